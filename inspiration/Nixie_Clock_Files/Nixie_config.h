@@ -0,0 +1,201 @@
+/*
+ * File:        Nixie_config.h
+ * Compiler:    XC8 v1.43
+ *
+ * Info:    Compile-time options for the Nixie clock firmware.
+ *          Everything in here is a plain #define so unused features cost nothing.
+ */
+
+#ifndef NIXIE_CONFIG_H
+#define NIXIE_CONFIG_H
+
+// Hour format
+//      0 = 12-hour clock (01-12, no AM/PM), 44-bit shift register frame
+//      1 = 24-hour clock (00-23), 45-bit shift register frame (needs the 3 cathode H1 tube)
+#ifndef CLOCK_24_HOUR
+#define CLOCK_24_HOUR   0
+#endif
+
+// What's on the TPIC6595 chain (see Nixie_display.h)
+//      DISPLAY_LAYOUT_6_TUBE: the v1 board, H1 H0 M1 M0 S1 S0, the IN-3 colons wired straight to +170V
+//      DISPLAY_LAYOUT_6_NEON: the same with the two IN-3s on chain outputs
+//      DISPLAY_LAYOUT_4_TUBE: HH:MM, the colon on the chain
+//      DISPLAY_LAYOUT_CUSTOM: define DISPLAY_FIELDS(X, a) here yourself
+#define DISPLAY_LAYOUT_6_TUBE   0
+#define DISPLAY_LAYOUT_6_NEON   1
+#define DISPLAY_LAYOUT_4_TUBE   2
+#define DISPLAY_LAYOUT_CUSTOM   3
+
+#ifndef DISPLAY_LAYOUT
+#define DISPLAY_LAYOUT          DISPLAY_LAYOUT_6_TUBE
+#endif
+
+// SPI clock to the TPIC6595 chain (SSP1CON1 SSPM bits)
+//      The TPIC6595 can take SRCK well past anything the MSSP can make @ 12.288MHz,
+//      so every setting here is safe for the chain, it's only a CPU/time trade-off
+#define SPI_CLOCK_FOSC_4        0b0000  // 3.072MHz,  6 byte frame = 48 Tcy  (15.6us)
+#define SPI_CLOCK_FOSC_16       0b0001  // 768kHz,    6 byte frame = 192 Tcy (62.5us)
+#define SPI_CLOCK_FOSC_64       0b0010  // 192kHz,    6 byte frame = 768 Tcy (250us), the original setting
+#define SPI_CLOCK_FOSC_SSPADD   0b1010  // Fosc / (4 * (SPI_CLOCK_SSPADD_DIV + 1))
+
+#ifndef SPI_CLOCK_MODE
+#define SPI_CLOCK_MODE          SPI_CLOCK_FOSC_16
+#endif
+#ifndef SPI_CLOCK_SSPADD_DIV
+#define SPI_CLOCK_SSPADD_DIV    3       // 768kHz when SPI_CLOCK_FOSC_SSPADD is picked
+#endif
+
+// SPI transmit engine
+//      1 = the SSP1 interrupt feeds the frame out a byte at a time, CPU is free while it shifts
+//          (~20 Tcy of ISR per byte, ~120 Tcy per frame no matter the SPI clock, simulator figures and
+//          lower bounds: it only counts the SFR accesses)
+//      0 = spin on SSP1STATbits.BF for every byte (CPU stuck for the whole frame, see SPI_CLOCK_*)
+//      At Fosc/4 a byte is only 8 Tcy, less than the interrupt costs, so 0 is the better pick there
+#ifndef SPI_USE_INTERRUPT
+#define SPI_USE_INTERRUPT       1
+#endif
+
+// Crystal calibration trim, in parts per billion (ppb)
+//      + if the crystal runs fast (clock gains time), - if it runs slow
+//      e.g. a clock that gains 1 sec/day is +11,574 ppb
+#ifndef TICK_TRIM_PPB
+#define TICK_TRIM_PPB           0
+#endif
+
+// Network time (SNTP client + clock discipline, see Nixie_ntp.h)
+//      Only on the targets with a network (the Linux host build), the PIC has none
+//      TZ_ZONE: what the tubes show = UTC in this zone, DST included (the zones are in Nixie_tz_table.h)
+#ifndef NTP_ENABLE
+#if defined(NIXIE_TARGET_HOST)
+#define NTP_ENABLE              1
+#else
+#define NTP_ENABLE              0
+#endif
+#endif
+#ifndef NTP_SERVER
+#define NTP_SERVER              "pool.ntp.org"
+#endif
+#ifndef NTP_POLL_SECS
+#define NTP_POLL_SECS           64      // seconds between request bursts
+#endif
+#ifndef NTP_BURST
+#define NTP_BURST               4       // requests per burst, the one with the shortest round trip wins
+#endif
+#ifndef NTP_BURST_GAP_SECS
+#define NTP_BURST_GAP_SECS      2       // seconds between the requests of a burst
+#endif
+#ifndef TZ_ZONE
+#define TZ_ZONE                 TZ_US_CENTRAL
+#endif
+
+// Cathode anti-poisoning "slot machine" (see Nixie_slot.h)
+//      SLOT_FRAME_HZ: frames a second while it spins, 1000 / n for n = 1-16 on the PIC (Timer2 postscaler)
+//      SLOT_BURST_SUBTICKS: how long it spins at the top of every minute, in 1/15 sec (5 = 333ms)
+//      SLOT_WINDOW_HOUR / SLOT_WINDOW_MINS: maintenance window, every second of HH:00 to HH:MM-1
+//      (hours as the tubes show them), SLOT_WINDOW_MINS 0 = no window
+#ifndef SLOT_ENABLE
+#define SLOT_ENABLE             1
+#endif
+#ifndef SLOT_FRAME_HZ
+#define SLOT_FRAME_HZ           250
+#endif
+#ifndef SLOT_BURST_SUBTICKS
+#define SLOT_BURST_SUBTICKS     5
+#endif
+#ifndef SLOT_WINDOW_HOUR
+#define SLOT_WINDOW_HOUR        3
+#endif
+#ifndef SLOT_WINDOW_MINS
+#define SLOT_WINDOW_MINS        10
+#endif
+
+// Digit crossfade (see Nixie_dim.h)
+//      Every second the old digits fade into the new ones over FADE_MS, starting right at the
+//      RCK edge (the new second still begins on time, the tubes go from old to new and never back),
+//      FADE_FRAME_HZ frames a second of old/new mix
+//      FADE_FRAME_HZ: 1000 / n for n = 1-16 on the PIC (Timer2 postscaler, like SLOT_FRAME_HZ)
+#ifndef FADE_ENABLE
+#define FADE_ENABLE             1
+#endif
+#ifndef FADE_MS
+#define FADE_MS                 150
+#endif
+#ifndef FADE_FRAME_HZ
+#define FADE_FRAME_HZ           1000
+#endif
+
+// Brightness (PWM on the TPIC6595 G pin, see Nixie_dim.h)
+//      Levels 0 (dark) to 31 (full, what the clock always was), perceptually even steps
+//      DIM_MODE_FIXED: always DIM_DAY_LEVEL
+//      DIM_MODE_SCHEDULE: DIM_NIGHT_LEVEL from DIM_NIGHT_FROM:00 to DIM_NIGHT_TO:00 (local 24-hour time,
+//          so it needs network time or CLOCK_24_HOUR, a 12-hour PIC can't tell 11pm from 11am)
+//      DIM_MODE_AMBIENT: in between, from a light sensor (LDR from VDD to RA1, 10k to ground on the PIC,
+//          [ and ] on the Linux build)
+#define DIM_MODE_FIXED          0
+#define DIM_MODE_SCHEDULE       1
+#define DIM_MODE_AMBIENT        2
+
+#ifndef DIM_MODE
+#if NTP_ENABLE || CLOCK_24_HOUR
+#define DIM_MODE                DIM_MODE_SCHEDULE
+#else
+#define DIM_MODE                DIM_MODE_FIXED
+#endif
+#endif
+#ifndef DIM_DAY_LEVEL
+#define DIM_DAY_LEVEL           31
+#endif
+#ifndef DIM_NIGHT_LEVEL
+#define DIM_NIGHT_LEVEL         8
+#endif
+#ifndef DIM_NIGHT_FROM
+#define DIM_NIGHT_FROM          22
+#endif
+#ifndef DIM_NIGHT_TO
+#define DIM_NIGHT_TO            7
+#endif
+
+// Timer2 frame stream (anti-poisoning bursts and crossfades share it), derived, don't touch
+#define STREAM_ENABLE           (SLOT_ENABLE || FADE_ENABLE)
+
+// Timing telemetry out of a UART, 38400 8N1 (see Nixie_telem.h)
+//      TX on RA0 on the PIC (EUSART), a file on Linux (NIXIE_TELEM=path)
+//      TELEM_RECORDS: ring size, 5 bytes of RAM each, a power of 2
+#ifndef TELEM_ENABLE
+#define TELEM_ENABLE            1
+#endif
+#ifndef TELEM_RECORDS
+#define TELEM_RECORDS           16
+#endif
+#define TELEM_BAUD              38400
+
+// Cold start: the time, crystal trim and brightness saved to non-volatile memory (see Nixie_persist.h),
+// the tubes come back up showing them instead of 12:00:00
+//      PIC: the Storage Area Flash (last 128 words), Linux: the file NIXIE_STATE names
+//      PERSIST_SAVE_MINS: minutes between saves (also on leaving the edit modes and on an NTP step),
+//      wear: 16 x 10k erases / saves a year, 60 = ~18 years on the PIC at the datasheet minimum
+#ifndef PERSIST_ENABLE
+#define PERSIST_ENABLE          1
+#endif
+#ifndef PERSIST_SAVE_MINS
+#define PERSIST_SAVE_MINS       60
+#endif
+
+// Rotary encoder
+//      Quadrature steps (edges) per mechanical detent, 4 for most encoders, 2 or 1 for some
+//      Acceleration: detents closer together than these many Timer1 counts
+//      (Fosc/4 / 8 = 2.6us each) move several units per detent
+#ifndef ENCODER_STEPS_PER_DETENT
+#define ENCODER_STEPS_PER_DETENT 4
+#endif
+#define ENCODER_FAST_COUNTS     7680u   // < 20ms between detents...
+#define ENCODER_ACCEL_FAST      5       // ...moves 5 units per detent
+#define ENCODER_MEDIUM_COUNTS   19200u  // < 50ms between detents...
+#define ENCODER_ACCEL_MEDIUM    2       // ...moves 2 units per detent
+
+// MCU supply current estimates for the power accounting (Nixie_power.h), in uA
+//      Typical PIC16F15325 numbers @ 12.288MHz HS crystal, 5V, measure your own board and fix these up
+#define POWER_RUN_UA            1800UL  // CPU running
+#define POWER_IDLE_UA           700UL   // IDLE (CPU stopped, crystal + peripherals still running)
+
+#endif // NIXIE_CONFIG_H
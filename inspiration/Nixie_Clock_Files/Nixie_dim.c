@@ -0,0 +1,120 @@
+/*
+ * File:        Nixie_dim.c
+ * Compiler:    XC8 v1.43
+ *
+ * Info:    Brightness levels and the digit crossfade (see Nixie_dim.h)
+ */
+
+#include "Nixie_config.h"
+#include "Nixie_hal.h"
+#include "Nixie_frame.h"
+#include "Nixie_dim.h"
+
+#if (DIM_MODE == DIM_MODE_SCHEDULE) && !NTP_ENABLE && !CLOCK_24_HOUR
+#error "DIM_MODE_SCHEDULE: needs network time or CLOCK_24_HOUR (a 12-hour clock has no idea if it's night)"
+#endif
+#if (DIM_DAY_LEVEL >= DIM_LEVELS) || (DIM_NIGHT_LEVEL > DIM_DAY_LEVEL)
+#error "DIM_DAY_LEVEL / DIM_NIGHT_LEVEL: 0 <= night <= day <= 31"
+#endif
+#if FADE_ENABLE && ((FADE_MS < 10) || (FADE_MS > 800))
+#error "FADE_MS: 10 to 800, the fade has to be over well before the next second"
+#endif
+
+// Square law, level 0 is off
+#define DIM_DUTY(l)         ((l) == 0 ? 0 : DIM_DUTY_MIN + (unsigned int)((DIM_DUTY_MAX - DIM_DUTY_MIN) * (unsigned long)(l) * (l) / ((DIM_LEVELS - 1) * (DIM_LEVELS - 1))))
+
+const unsigned int dimDuty[DIM_LEVELS] =
+{
+    DIM_DUTY(0),  DIM_DUTY(1),  DIM_DUTY(2),  DIM_DUTY(3),  DIM_DUTY(4),  DIM_DUTY(5),  DIM_DUTY(6),  DIM_DUTY(7),
+    DIM_DUTY(8),  DIM_DUTY(9),  DIM_DUTY(10), DIM_DUTY(11), DIM_DUTY(12), DIM_DUTY(13), DIM_DUTY(14), DIM_DUTY(15),
+    DIM_DUTY(16), DIM_DUTY(17), DIM_DUTY(18), DIM_DUTY(19), DIM_DUTY(20), DIM_DUTY(21), DIM_DUTY(22), DIM_DUTY(23),
+    DIM_DUTY(24), DIM_DUTY(25), DIM_DUTY(26), DIM_DUTY(27), DIM_DUTY(28), DIM_DUTY(29), DIM_DUTY(30), DIM_DUTY(31)
+};
+
+unsigned char dimLevel = DIM_DAY_LEVEL;
+
+#if DIM_MODE == DIM_MODE_SCHEDULE
+#if DIM_NIGHT_FROM > DIM_NIGHT_TO
+#define DIM_NIGHT(h)        (((h) >= DIM_NIGHT_FROM) || ((h) < DIM_NIGHT_TO))   // over midnight
+#else
+#define DIM_NIGHT(h)        (((h) >= DIM_NIGHT_FROM) && ((h) < DIM_NIGHT_TO))
+#endif
+#endif
+
+#if DIM_MODE == DIM_MODE_AMBIENT
+static unsigned int dimAmbient = 255 * 8;   // light sensor x 8, low pass filtered (~8 sec)
+#endif
+
+void dimInit(void)
+{
+    HAL_DIM_SET(dimDuty[dimLevel]);
+#if DIM_MODE == DIM_MODE_AMBIENT
+    HAL_AMBIENT_START();
+#endif
+}
+
+void dimSecond(unsigned char hour)
+{
+    unsigned char target = DIM_DAY_LEVEL;
+
+#if DIM_MODE == DIM_MODE_SCHEDULE
+    if(DIM_NIGHT(hour))
+        target = DIM_NIGHT_LEVEL;
+#elif DIM_MODE == DIM_MODE_AMBIENT
+    // Last second's conversion, then start the next one (it has a whole second, nobody waits on the ADC)
+    dimAmbient = dimAmbient - (dimAmbient >> 3) + HAL_AMBIENT_READ();
+    HAL_AMBIENT_START();
+    target = DIM_NIGHT_LEVEL + (unsigned char)(((DIM_DAY_LEVEL - DIM_NIGHT_LEVEL) * ((dimAmbient >> 3) + 1)) >> 8);
+#endif
+    (void)hour;
+
+    if(dimLevel < target)
+        dimLevel++;
+    else if(dimLevel > target)
+        dimLevel--;
+    else
+        return;
+    HAL_DIM_SET(dimDuty[dimLevel]);
+}
+
+#if FADE_ENABLE
+
+unsigned char fadeArmed = 0;
+unsigned int fadeStep = FADE_FRAMES;
+unsigned long fadeFramesShown = 0;
+
+static unsigned char fadeFrame[2][FRAME_BYTES];    // [0] = the second before, [1] = the new one
+static unsigned int fadeAcc;
+static unsigned char fadeUp;                        // which of them the tubes show
+
+// onTick(), right after an armed RCK left "from" up (the stream isn't running, nothing's pointing at fadeFrame[])
+void fadeStart(const nixieTime_t *from, const nixieTime_t *to)
+{
+    encodeFrame(fadeFrame[0], from);
+    encodeFrame(fadeFrame[1], to);
+    fadeStep = 0;
+    fadeAcc = FADE_FRAMES / 2;
+    fadeUp = 0;
+}
+
+// Density of the new second goes up by 1/FADE_FRAMES a frame, the accumulator never gets past
+// 2 x FADE_FRAMES so one subtract always brings it back, and on the last frame it's always new
+const unsigned char *fadeNextFrame(void)
+{
+    unsigned char pick = 0;
+
+    fadeStep++;
+    fadeAcc += fadeStep;
+    if(fadeAcc >= FADE_FRAMES)
+    {
+        fadeAcc -= FADE_FRAMES;
+        pick = 1;
+    }
+    if(pick == fadeUp)
+        return 0;
+    fadeUp = pick;
+    fadeFramesShown++;
+    return fadeFrame[pick];
+}
+
+#endif // FADE_ENABLE
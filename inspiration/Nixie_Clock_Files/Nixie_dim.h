@@ -0,0 +1,72 @@
+/*
+ * File:        Nixie_dim.h
+ * Compiler:    XC8 v1.43
+ *
+ * Info:    Brightness and digit crossfade for the Nixie clock.
+ *
+ *          Brightness: the TPIC6595s' G pins (output enable, active low) used to be tied to ground,
+ *          now they go to RC5, driven by PWM3 (inverted) off Timer2: 1kHz, 768 steps of duty
+ *          (Fosc / 16 / 192 x 4). The tubes only light while G is low, so the duty is the brightness.
+ *          PWM3's duty is double buffered, a new one takes effect at the next period, never a torn pulse.
+ *          (A 10k pull-up on G keeps the tubes dark until halInit() has PWM3 running.)
+ *          Level -> duty is a square law table worked out by the compiler (the eye sees brightness
+ *          roughly logarithmically, equal duty steps all look alike at the top and huge at the bottom),
+ *          lifted by DIM_DUTY_MIN so the lowest level still strikes: a Nixie takes some tens of us
+ *          to ionize, a shorter pulse doesn't light it at all.
+ *          onTick() works out the level the clock should be at once a second (DIM_MODE, Nixie_config.h)
+ *          and dimLevel walks there one level a second, so dusk comes on gradually, not in one jump.
+ *
+ *          Crossfade: the chain has one back buffer and one front buffer, the old and new digits can't
+ *          both be up at once, so they take turns. When the next second is going to fade in, frameService()
+ *          puts this second in the pipeline again instead of the next one (fadeArmed), so the second's RCK
+ *          (on time, like always) leaves the old digits up and the fade starts from them, right at the edge.
+ *          Latching the new digits there would flash them up at full until the first stream frame put the
+ *          old ones back, ~1ms later. onTick() then starts Timer2 streaming at FADE_FRAME_HZ: frame j of
+ *          FADE_FRAMES shows the new second with density j/FADE_FRAMES, the old one the rest of the time.
+ *          A first order sigma-delta picks which (one add and one compare, no divides, old and new spread
+ *          as evenly as they can be), so the new digits go from faint to full in FADE_MS, and the last
+ *          frame is always the new second. Only frames that change what's up get shifted, about half.
+ *          Timer2 is also the PWM period, so a frame is always a whole number of PWM pulses and the mix
+ *          never beats against the brightness.
+ *          The stream stops itself after its last frame (sub-tick streamStopAt is only a backstop), then
+ *          frameService() puts the pipeline frame in, like after an anti-poisoning burst. A fade that was
+ *          armed but can't start (an edit, a late main(), the time got stepped) puts the new second up
+ *          as a live frame instead, a shift time after the RCK.
+ *          Cost, from the simulator (make -C sim check, SPI Fosc/16, SPI interrupt), which only charges
+ *          SFR accesses, so all of these are lower bounds: at least ~19 Tcy of Timer2 ISR a frame, ~260 Tcy
+ *          awake for each frame that gets shifted, ~4% of the CPU for the FADE_MS of each second (polling
+ *          the SPI at Fosc/64, ~14%). The real figures are higher, by however many RAM instructions the
+ *          fade code runs, not measured. make -C sim refresh-bench has the numbers and the refresh rate
+ *          limits (upper bounds, then) for every SPI clock and mode.
+ */
+
+#ifndef NIXIE_DIM_H
+#define NIXIE_DIM_H
+
+#include "Nixie_config.h"
+#include "Nixie_time.h"
+
+#define DIM_LEVELS          32
+#define DIM_DUTY_MAX        768     // PWM duty with the tubes fully on (4 x (T2PR + 1) on the PIC)
+#define DIM_DUTY_MIN        38      // level 1, ~50us out of every 1ms
+
+extern const unsigned int dimDuty[DIM_LEVELS];
+extern unsigned char dimLevel;      // level the tubes are at right now
+
+void dimInit(void);                 // PWM to dimLevel, after halInit()
+void dimSecond(unsigned char hour); // once a second (onTick()), hour = local 24-hour time (DIM_MODE_SCHEDULE only)
+
+#if FADE_ENABLE
+
+#define FADE_FRAMES         ((unsigned int)((unsigned long)FADE_FRAME_HZ * FADE_MS / 1000))
+
+extern unsigned char fadeArmed;     // the pipeline frame is this second again, the next RCK starts a fade
+extern unsigned int fadeStep;       // frames of this fade so far (done at FADE_FRAMES)
+extern unsigned long fadeFramesShown;   // frames shifted since reset (the ones that changed the tubes)
+
+void fadeStart(const nixieTime_t *from, const nixieTime_t *to);
+const unsigned char *fadeNextFrame(void);   // ISR: next frame to shift, 0 = the tubes already show the right one
+
+#endif // FADE_ENABLE
+
+#endif // NIXIE_DIM_H
@@ -0,0 +1,108 @@
+/*
+ * File:        Nixie_display.h
+ * Compiler:    XC8 v1.43
+ *
+ * Info:    The display, declared once: what's on the TPIC6595 chain, in what order, how many
+ *          cathodes each tube has and what it shows. Everything that has to know the layout
+ *          is worked out from DISPLAY_FIELDS by the compiler: the frame size, the frame tables
+ *          and encodeFrame() (Nixie_frame.c), the anti-poisoning frames (Nixie_slot.c), and on
+ *          the host the terminal tubes (Nixie_hal_host.c), the simulator's chain decoder and
+ *          sim/frame_check.c. Nothing looks at the layout at run time.
+ *
+ *          DISPLAY_FIELDS(X, a) goes from the PIC end of the chain out (the last bits shifted in,
+ *          IC1 Q0 is bit 0) and calls X(name, cathodes, shows, a) for every field, a is just
+ *          passed along for the generators that need it. Fields are packed back to back, bit 0 up,
+ *          whatever the byte edges:
+ *              name        DISPLAY_<name>_AT = its lowest bit, DISPLAY_<name>_TOP = its highest
+ *              cathodes    outputs it takes, cathode 0 on the lowest, a plain number 1-10
+ *                          (it gets pasted into macro names)
+ *              shows       h1 h0 m1 m0 s1 s0: that digit of the time (nixieTime_t), cathode = digit
+ *                          lit: a neon (separator) that's just on, 1 cathode
+ *
+ *          Layouts (DISPLAY_LAYOUT, Nixie_config.h):
+ *              DISPLAY_LAYOUT_6_TUBE   the v1 board: six IN-12A, 44 bits (45 with the 3 cathode H1 of a
+ *                                      24-hour clock), six TPIC6595s. Its two IN-3 colons (NB1, NB2) are
+ *                                      wired to +170V through R7/R8, always on, not on the chain.
+ *              DISPLAY_LAYOUT_6_NEON   the same six tubes with the IN-3s on chain outputs between the
+ *                                      pairs instead, 46/47 bits, still six TPIC6595s
+ *              DISPLAY_LAYOUT_4_TUBE   HH:MM with the colon on the chain, 29/30 bits, four TPIC6595s
+ *              DISPLAY_LAYOUT_CUSTOM   DISPLAY_FIELDS comes from the build
+ *          The chain can be 1 to 8 bytes (the host side holds it in 64 bits).
+ */
+
+#ifndef NIXIE_DISPLAY_H
+#define NIXIE_DISPLAY_H
+
+#include "Nixie_config.h"
+
+#if CLOCK_24_HOUR
+#define DISPLAY_H1_CATHODES     3
+#else
+#define DISPLAY_H1_CATHODES     2
+#endif
+
+#if DISPLAY_LAYOUT == DISPLAY_LAYOUT_6_TUBE
+#define DISPLAY_FIELDS(X, a) \
+    X(S0, 10, s0, a) \
+    X(S1, 6, s1, a) \
+    X(M0, 10, m0, a) \
+    X(M1, 6, m1, a) \
+    X(H0, 10, h0, a) \
+    X(H1, DISPLAY_H1_CATHODES, h1, a)
+#elif DISPLAY_LAYOUT == DISPLAY_LAYOUT_6_NEON
+#define DISPLAY_FIELDS(X, a) \
+    X(S0, 10, s0, a) \
+    X(S1, 6, s1, a) \
+    X(NB2, 1, lit, a) \
+    X(M0, 10, m0, a) \
+    X(M1, 6, m1, a) \
+    X(NB1, 1, lit, a) \
+    X(H0, 10, h0, a) \
+    X(H1, DISPLAY_H1_CATHODES, h1, a)
+#elif DISPLAY_LAYOUT == DISPLAY_LAYOUT_4_TUBE
+#define DISPLAY_FIELDS(X, a) \
+    X(M0, 10, m0, a) \
+    X(M1, 6, m1, a) \
+    X(COLON, 1, lit, a) \
+    X(H0, 10, h0, a) \
+    X(H1, DISPLAY_H1_CATHODES, h1, a)
+#elif (DISPLAY_LAYOUT != DISPLAY_LAYOUT_CUSTOM) || !defined(DISPLAY_FIELDS)
+#error "DISPLAY_LAYOUT: DISPLAY_LAYOUT_6_TUBE, _6_NEON, _4_TUBE, or _CUSTOM with DISPLAY_FIELDS(X, a) defined"
+#endif
+
+// What a field shows, t = const nixieTime_t *
+#define DISPLAY_SHOW_h1(t)      ((t)->h1)
+#define DISPLAY_SHOW_h0(t)      ((t)->h0)
+#define DISPLAY_SHOW_m1(t)      ((t)->m1)
+#define DISPLAY_SHOW_m0(t)      ((t)->m0)
+#define DISPLAY_SHOW_s1(t)      ((t)->s1)
+#define DISPLAY_SHOW_s0(t)      ((t)->s0)
+#define DISPLAY_SHOW_lit(t)     0
+
+// ...and which of the six time digits that is, H1 = 0 to S0 = 5, -1 for a neon (host side)
+#define DISPLAY_DIGIT_h1        0
+#define DISPLAY_DIGIT_h0        1
+#define DISPLAY_DIGIT_m1        2
+#define DISPLAY_DIGIT_m0        3
+#define DISPLAY_DIGIT_s1        4
+#define DISPLAY_DIGIT_s0        5
+#define DISPLAY_DIGIT_lit       (-1)
+
+// Chain length, a plain sum so #if can use it
+#define DISPLAY_ADD(name, n, shows, a)  + (n)
+#define DISPLAY_BITS            (0 DISPLAY_FIELDS(DISPLAY_ADD, 0))
+
+#if (DISPLAY_BITS < 1) || (DISPLAY_BITS > 64)
+#error "DISPLAY_FIELDS: 1 to 64 bits (8 TPIC6595s)"
+#endif
+
+// Where every field is: DISPLAY_<name>_AT, DISPLAY_<name>_TOP, and the chain's top byte.
+// DISPLAY_BITS can't be used inside a DISPLAY_FIELDS(X, a) expansion (the preprocessor won't
+// expand DISPLAY_FIELDS inside itself), generators use these instead.
+#define DISPLAY_ENUM(name, n, shows, a) DISPLAY_##name##_AT, DISPLAY_##name##_TOP = DISPLAY_##name##_AT + (n) - 1,
+enum { DISPLAY_FIELDS(DISPLAY_ENUM, 0) DISPLAY_END, DISPLAY_TOP_BYTE = (DISPLAY_END - 1) >> 3 };
+
+// Chain bit p as it lands in byte b (0 = the PIC end), 0 if it's in another byte
+#define DISPLAY_BIT_IN(p, b)    ((unsigned char)((((p) >> 3) == (b)) ? (1u << ((p) & 7)) : 0))
+
+#endif // NIXIE_DISPLAY_H
@@ -0,0 +1,87 @@
+/*
+ * File:        Nixie_encoder.c
+ * Compiler:    XC8 v1.43
+ *
+ * Info:    Interrupt-on-change quadrature decoder (see Nixie_encoder.h)
+ */
+
+#include "Nixie_encoder.h"
+
+volatile unsigned char encoderCount = 0;
+
+static unsigned char encoderState = 0;      // last A/B state seen (bit 1 = A, bit 0 = B)
+static signed char encoderQuarter = 0;      // quarter steps since the last detent
+static unsigned int encoderLastDetent = 0;  // Timer1 count at the last detent
+static unsigned char encoderWrapped = 2;    // Timer1 wraps since then (2 = too many, or no detent yet)
+static unsigned char encoderTaken = 0;      // main() side copy of encoderCount
+
+// Quadrature transition table, index = (old AB << 2) | new AB
+// Clockwise (increment) goes 00 -> 10 -> 11 -> 01 -> 00
+// (same direction rule as before: channel A moving away from channel B is +)
+static const signed char encoderTable[16] =
+{
+    //  new:  00  01  10  11
+              0, -1, +1,  0,    // old 00
+             +1,  0,  0, -1,    // old 01
+             -1,  0,  0, +1,    // old 10
+              0, +1, -1,  0     // old 11 (00<->11 or 01<->10 is a missed/bounced edge, ignore it)
+};
+
+void encoderReset(unsigned char ab)
+{
+    encoderState = ab;
+    encoderQuarter = 0;
+    encoderWrapped = 2; // the first detent is never a fast one
+}
+
+unsigned char encoderEdge(unsigned char ab, unsigned int now, unsigned char timerWrapped)
+{
+    unsigned char step = 1;
+
+    encoderQuarter += encoderTable[(encoderState << 2) | ab];
+    encoderState = ab;
+
+    // Wraps add up over the whole detent, a slow one can have Timer1 wrap between two of its
+    // edges and not at the edge that finishes it
+    if((timerWrapped >= 2) || (encoderWrapped + timerWrapped >= 2))
+        encoderWrapped = 2;
+    else
+        encoderWrapped += timerWrapped;
+
+    if((encoderQuarter < ENCODER_STEPS_PER_DETENT) && (encoderQuarter > -ENCODER_STEPS_PER_DETENT))
+        return 0; // still between detents
+
+    // One full detent, how fast is the knob going? The 16-bit difference is the time since the last
+    // detent as long as Timer1 wrapped at most once, and didn't get back past where it was
+    if((encoderWrapped == 0) || ((encoderWrapped == 1) && (now < encoderLastDetent)))
+    {
+        if(((now - encoderLastDetent) & 0xFFFF) < ENCODER_FAST_COUNTS)
+            step = ENCODER_ACCEL_FAST;
+        else if(((now - encoderLastDetent) & 0xFFFF) < ENCODER_MEDIUM_COUNTS)
+            step = ENCODER_ACCEL_MEDIUM;
+    }
+    encoderLastDetent = now;
+    encoderWrapped = 0;
+
+    if(encoderQuarter > 0)
+        encoderCount += step;
+    else
+        encoderCount -= step;
+
+    encoderQuarter = 0;
+    return 1;
+}
+
+signed char encoderTake(void)
+{
+    unsigned char count = encoderCount; // one byte, the ISR can't tear it
+    signed char steps = (signed char)(count - encoderTaken);
+
+    encoderTaken = count;
+    return steps;
+}
+
+unsigned char encoderPending(void)
+{
+    return (unsigned char)(encoderCount != encoderTaken);
+}
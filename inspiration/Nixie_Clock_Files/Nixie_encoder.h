@@ -0,0 +1,43 @@
+/*
+ * File:        Nixie_encoder.h
+ * Compiler:    XC8 v1.43
+ *
+ * Info:    Rotary encoder (RPG) decoder for the edit modes.
+ *
+ *          Both channels fire interrupt-on-change on both edges, and every edge
+ *          goes through a full quadrature state machine (all 4 states, both
+ *          channels), so fast spins don't drop steps like the old "watch
+ *          channel A only" polling did.
+ *
+ *          Debounce comes for free: a bouncing contact just flips back and
+ *          forth between two neighbouring states (+1 -1 +1 -1 ...), which
+ *          cancels out, and an impossible jump (both channels changed at once)
+ *          counts as nothing.
+ *
+ *          Acceleration: the time between detents is measured with Timer1,
+ *          a fast spin moves ENCODER_ACCEL_FAST units per detent.
+ *
+ *          The ISR is the only writer of encoderCount and main() is the only
+ *          reader, both are single byte accesses, so no locking needed anywhere.
+ */
+
+#ifndef NIXIE_ENCODER_H
+#define NIXIE_ENCODER_H
+
+#include "Nixie_config.h"
+
+extern volatile unsigned char encoderCount; // running total of (accelerated) detents, wraps around, ISR writes only
+
+// Start from the current pin state (bit 1 = channel A, bit 0 = channel B)
+void encoderReset(unsigned char ab);
+
+// ISR side: ab = new pin state (bit 1 = channel A, bit 0 = channel B),
+// now = free running Timer1 count, timerWrapped = Timer1 overflows since the last call
+// Returns 1 when the edge finished a detent (encoderCount moved)
+unsigned char encoderEdge(unsigned char ab, unsigned int now, unsigned char timerWrapped);
+
+// main() side: detents (accelerated) since the last call, + = clockwise
+signed char encoderTake(void);
+unsigned char encoderPending(void);  // 1 if encoderTake() would return something
+
+#endif // NIXIE_ENCODER_H
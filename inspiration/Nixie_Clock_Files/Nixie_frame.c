@@ -0,0 +1,66 @@
+/*
+ * File:        Nixie_frame.c
+ * Compiler:    XC8 v1.43
+ *
+ * Info:    Compile-time frame tables and the frame encoder (see Nixie_frame.h),
+ *          both generated from DISPLAY_FIELDS (Nixie_display.h).
+ *          The tables are const so XC8 puts them in program memory (RETLW tables),
+ *          one byte per cathode for every byte a field spans, no RAM. That's 74 words
+ *          on the v1 board (75 for 24-hour), more than one shared table per pair would
+ *          take, but it buys an encoder with no geometry left in it at run time.
+ */
+
+#include "Nixie_frame.h"
+
+// A field's chain bytes, its lowest one and how many more it runs into (up to 2: 10 cathodes from bit 7)
+#define FRAME_LOW(name)         (DISPLAY_##name##_AT >> 3)
+#define FRAME_MORE(name)        ((DISPLAY_##name##_TOP >> 3) - FRAME_LOW(name))
+
+// Cathode c of a field lit, as byte k of the field (k = 0 its lowest byte)
+#define FRAME_ENTRY(name, k, c) DISPLAY_BIT_IN(DISPLAY_##name##_AT + (c), FRAME_LOW(name) + (k))
+
+#define FRAME_CATHODES(n, name, k)      FRAME_CATHODES_(n, name, k)
+#define FRAME_CATHODES_(n, name, k)     FRAME_CATHODES_##n(name, k)
+#define FRAME_CATHODES_1(name, k)       FRAME_ENTRY(name, k, 0)
+#define FRAME_CATHODES_2(name, k)       FRAME_CATHODES_1(name, k), FRAME_ENTRY(name, k, 1)
+#define FRAME_CATHODES_3(name, k)       FRAME_CATHODES_2(name, k), FRAME_ENTRY(name, k, 2)
+#define FRAME_CATHODES_4(name, k)       FRAME_CATHODES_3(name, k), FRAME_ENTRY(name, k, 3)
+#define FRAME_CATHODES_5(name, k)       FRAME_CATHODES_4(name, k), FRAME_ENTRY(name, k, 4)
+#define FRAME_CATHODES_6(name, k)       FRAME_CATHODES_5(name, k), FRAME_ENTRY(name, k, 5)
+#define FRAME_CATHODES_7(name, k)       FRAME_CATHODES_6(name, k), FRAME_ENTRY(name, k, 6)
+#define FRAME_CATHODES_8(name, k)       FRAME_CATHODES_7(name, k), FRAME_ENTRY(name, k, 7)
+#define FRAME_CATHODES_9(name, k)       FRAME_CATHODES_8(name, k), FRAME_ENTRY(name, k, 8)
+#define FRAME_CATHODES_10(name, k)      FRAME_CATHODES_9(name, k), FRAME_ENTRY(name, k, 9)
+
+// frame<name>Byte0/1/2[cathode]. The ones for bytes a field doesn't reach are all 0 and
+// encodeFrame() never reads them, so they get dropped.
+#define FRAME_TABLES(name, n, shows, a) \
+    static const unsigned char frame##name##Byte0[n] = { FRAME_CATHODES(n, name, 0) }; \
+    static const unsigned char frame##name##Byte1[n] = { FRAME_CATHODES(n, name, 1) }; \
+    static const unsigned char frame##name##Byte2[n] = { FRAME_CATHODES(n, name, 2) };
+
+DISPLAY_FIELDS(FRAME_TABLES, 0)
+
+// Fields go in bit 0 up, so the first one into a byte sets it and the rest OR into theirs.
+// Every if() is on constants: what's left is a table read and a store (or an OR) per byte
+// a field spans, straight through.
+#define FRAME_PUT(name, n, shows, a) \
+    d = DISPLAY_SHOW_##shows(t); \
+    if((DISPLAY_##name##_AT & 7) == 0) \
+        frame[FRAME_INDEX(FRAME_LOW(name))] = frame##name##Byte0[d]; \
+    else \
+        frame[FRAME_INDEX(FRAME_LOW(name))] |= frame##name##Byte0[d]; \
+    if(FRAME_MORE(name) >= 1) \
+        frame[FRAME_INDEX(FRAME_LOW(name) + 1)] = frame##name##Byte1[d]; \
+    if(FRAME_MORE(name) >= 2) \
+        frame[FRAME_INDEX(FRAME_LOW(name) + 2)] = frame##name##Byte2[d];
+
+// Build the frame for H1H0:M1M0:S1S0 (the digits the layout shows)
+// The time core keeps every digit in range (H1 0-1 or 0-2, M1/S1 0-5, the rest 0-9),
+// there are no range checks in here on purpose (this runs every tick)
+void encodeFrame(unsigned char *frame, const nixieTime_t *t)
+{
+    unsigned char d;
+
+    DISPLAY_FIELDS(FRAME_PUT, 0)
+}
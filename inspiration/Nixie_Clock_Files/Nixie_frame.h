@@ -0,0 +1,75 @@
+/*
+ * File:        Nixie_frame.h
+ * Compiler:    XC8 v1.43
+ *
+ * Info:    Shift register frame encoder for the Nixie clock.
+ *          Turns the time digits (H1 H0 : M1 M0 : S1 S0) into the
+ *          FRAME_BYTES bytes that get shifted out to the TPIC6595 chain.
+ *
+ *          The layout is Nixie_display.h's. Every possible byte contribution of
+ *          every field is worked out by the compiler from it (see Nixie_frame.c)
+ *          and lives in flash, so building a frame is just table lookups and ORs.
+ *          No pow(), no soft-float, no shifting at runtime.
+ */
+
+#ifndef NIXIE_FRAME_H
+#define NIXIE_FRAME_H
+
+#include "Nixie_time.h"
+#include "Nixie_display.h"
+
+/*
+ * Frame layout, the v1 board (sent out MSB side first, frame[0] first):
+ *
+ *                       H1H0    H0      M1 |M0    M0     S1  |S0    S0
+ *      (MSB) 000xxxxx xxxxxxxx xxxxxxxx xxxxxxxx xxxxxxxx xxxxxxxx  (LSB)
+ *             frame[0] frame[1] frame[2] frame[3] frame[4] frame[5]
+ *
+ * 12-hour clock: H1 only has cathodes 0,1  -> 44-bit number (frame[0] bits 3..0)
+ * 24-hour clock: H1 has cathodes 0,1,2     -> 45-bit number (frame[0] bits 4..0)
+ *
+ * Any layout: chain bit 0 is the last bit of frame[FRAME_BYTES - 1], the bits above
+ * FRAME_BITS in frame[0] are never lit.
+ */
+#define FRAME_BITS          DISPLAY_BITS
+#define FRAME_BYTES         ((FRAME_BITS + 7) / 8)
+
+// A whole frame's worth of F(a, i), frame[0] first (F brings its own , or ;)
+#if FRAME_BYTES == 1
+#define FRAME_EACH_BYTE(F, a)   F(a, 0)
+#elif FRAME_BYTES == 2
+#define FRAME_EACH_BYTE(F, a)   F(a, 0) F(a, 1)
+#elif FRAME_BYTES == 3
+#define FRAME_EACH_BYTE(F, a)   F(a, 0) F(a, 1) F(a, 2)
+#elif FRAME_BYTES == 4
+#define FRAME_EACH_BYTE(F, a)   F(a, 0) F(a, 1) F(a, 2) F(a, 3)
+#elif FRAME_BYTES == 5
+#define FRAME_EACH_BYTE(F, a)   F(a, 0) F(a, 1) F(a, 2) F(a, 3) F(a, 4)
+#elif FRAME_BYTES == 6
+#define FRAME_EACH_BYTE(F, a)   F(a, 0) F(a, 1) F(a, 2) F(a, 3) F(a, 4) F(a, 5)
+#elif FRAME_BYTES == 7
+#define FRAME_EACH_BYTE(F, a)   F(a, 0) F(a, 1) F(a, 2) F(a, 3) F(a, 4) F(a, 5) F(a, 6)
+#else
+#define FRAME_EACH_BYTE(F, a)   F(a, 0) F(a, 1) F(a, 2) F(a, 3) F(a, 4) F(a, 5) F(a, 6) F(a, 7)
+#endif
+
+// Which frame[] byte chain byte b (0 = the PIC end) is (fine inside DISPLAY_FIELDS generators)
+#define FRAME_INDEX(b)      (DISPLAY_TOP_BYTE - (b))
+
+void encodeFrame(unsigned char *frame, const nixieTime_t *t);
+
+/*
+ * Frame stream (STREAM_ENABLE): frames Timer2 shifts in and latches on its own, outside the 1Hz pipeline
+ * (anti-poisoning bursts, Nixie_slot.h, and digit crossfades, Nixie_dim.h). Only ever between one
+ * second's RCK and sub-tick streamStopAt, main() keeps off the chain meanwhile (Nixie_main_v3.c).
+ */
+#define STREAM_IDLE         0   // tubes show the time, the chain is main()'s
+#define STREAM_SLOT         1   // Timer2 is streaming anti-poisoning frames
+#define STREAM_FADE         2   // Timer2 is crossfading the last second into this one
+#define STREAM_DONE         3   // stopped, main() puts the time back (frameService())
+
+extern volatile unsigned char streamState;
+extern unsigned char streamStopAt;      // sub-tick the tick ISR stops the stream at (1 to TICK_SUBTICKS-1)
+extern unsigned int streamSkipped;      // Timer2 found the SPI still busy (frame rate too fast for the SPI clock)
+
+#endif // NIXIE_FRAME_H
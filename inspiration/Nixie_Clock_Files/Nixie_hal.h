@@ -0,0 +1,102 @@
+/*
+ * File:        Nixie_hal.h
+ * Compiler:    XC8 v1.43 (also gcc for the Linux host build)
+ *
+ * Info:    Hardware abstraction for the Nixie clock.
+ *          The clock logic (Nixie_main_v3.c, time core, frame encoder, mode handling)
+ *          only talks to the hardware through the HAL_xxx() macros below, each target
+ *          header turns them back into its own register accesses at compile time.
+ *          No function pointers, no vtables, no extra calls: on the PIC every macro expands
+ *          to the register access that used to be written out in main(). The simulator sees
+ *          the same register traffic as before the HAL; nobody has compared XC8 listings yet.
+ *
+ *          Targets (picked by the compiler/command line, PIC16 is the default):
+ *              Nixie_hal_pic16.h       PIC16F15325 @ 12.288MHz (the real clock, and the sim/ simulator)
+ *              Nixie_hal_host.h        Linux terminal clock, -DNIXIE_TARGET_HOST
+ *
+ *          What every target provides:
+ *              void halInit(void)          pins, SPI, timers, interrupt sources (leaves interrupts OFF)
+ *              HAL_ISR(name)               the interrupt entry point ISR_High() is declared with
+ *              HAL_IRQ_OFF() / HAL_IRQ_ON()
+ *              HAL_IDLE()                  nap until an interrupt (called with IRQs off, returns with them off)
+ *
+ *              HAL_TICK_START()            start the sub-tick timer (TICK_COUNTS_PER_SEC counts per second)
+ *              HAL_TICK_IRQ() / HAL_TICK_ACK()
+ *              HAL_TICK_LAG()              counts since the sub-tick match (latency check)
+ *              HAL_TICK_SET_PERIOD(p)      next sub-tick is p+1 counts (what tickNextPeriod() returns)
+ *
+ *              unsigned int halTimerNow(void)  free running 16-bit timer, 2.6us counts
+ *              HAL_WRAP_IRQ() / HAL_WRAP_ACK()   it wrapped (every 170.7ms)
+ *
+ *              HAL_SPI_WRITE(b)            start shifting one byte into the TPIC6595 chain
+ *              HAL_SPI_READ()              dummy read after a byte (clears BF on the PIC)
+ *              HAL_SPI_WAIT()              spin until the byte is out (SPI_USE_INTERRUPT 0)
+ *              HAL_SPI_IRQ() / HAL_SPI_ACK()   byte done (SPI_USE_INTERRUPT 1)
+ *              HAL_RCK_HIGH() / HAL_RCK_HOLD() / HAL_RCK_LOW()    the latch pulse
+ *
+ *              HAL_ENCODER_AB()            encoder pins, bit 1 = channel A, bit 0 = channel B
+ *              HAL_ENCODER_IRQ() / HAL_ENCODER_ACK()
+ *              HAL_BUTTON_IRQ() / HAL_BUTTON_ACK()
+ *
+ *              HAL_STREAM_START(hz) / HAL_STREAM_STOP()   frame pacing interrupt on/off, hz is a constant
+ *              HAL_STREAM_IRQ() / HAL_STREAM_ACK()         (SLOT_FRAME_HZ, FADE_FRAME_HZ), first one within 1/hz
+ *
+ *              HAL_DIM_SET(duty)           tube brightness = PWM duty on the TPIC6595 G pin, 0 to DIM_DUTY_MAX
+ *              HAL_AMBIENT_START()         light sensor (DIM_MODE_AMBIENT only): start a reading...
+ *              HAL_AMBIENT_READ()          ...and the last one, 0 (dark) to 255 (bright)
+ *
+ *              HAL_UART_READY()            telemetry UART (TELEM_ENABLE): room for another byte...
+ *              HAL_UART_WRITE(b)           ...send it
+ *              HAL_UART_WAKE()             main() is about to nap waiting for room, interrupt when there is
+ *              HAL_UART_IRQ() / HAL_UART_ACK() there is (ACK turns that interrupt back off)
+ *
+ *              HAL_NV_BYTES / HAL_NV_ROW_BYTES non-volatile store (PERSIST_ENABLE): its size, and its erase unit
+ *              void halNvRead(unsigned int at, unsigned char *buf, unsigned char n)
+ *              void halNvErase(unsigned int at)    the whole row at is in, back to 0xFF
+ *              void halNvWrite(unsigned int at, const unsigned char *buf, unsigned char n)
+ *                                          into erased bytes of one row
+ *                                          (both turn interrupts off themselves, the CPU may stall a while)
+ *              HAL_RTC / HAL_RTC_SECS()    1 if there's a clock that keeps going with the power off,
+ *                                          and its seconds (0 = none)
+ *
+ *              HAL_FLASH                   goes after a const table's declarator, keeps it in flash
+ *              HAL_FLASH_U32(p) / HAL_FLASH_S8(p)  read a uint32_t / signed char of such a table
+ *
+ *          And the targets with a network (NTP_ENABLE, see Nixie_ntp.h):
+ *              HAL_TICK_PHASE()            counts since the last sub-tick match the ISR took, keeps
+ *                                          counting past the next match until the ISR takes that one
+ *                                          (sub-second part of the NTP timestamps)
+ *              HAL_NET_IRQ() / HAL_NET_ACK()   a UDP packet from the time server is waiting
+ *              void halNetSend(const unsigned char *pkt, unsigned char len)    to the time server
+ *              unsigned char halNetReceive(unsigned char *buf, unsigned char max)  next packet, 0 = none
+ */
+
+#ifndef NIXIE_HAL_H
+#define NIXIE_HAL_H
+
+#include <stdint.h>     // uint32_t: 32 bits on every target (unsigned long is 64 on the Linux build)
+#include "Nixie_config.h"
+
+#if defined(NIXIE_TARGET_HOST)
+#define HAL_TARGET_HOST     1
+#include "Nixie_hal_host.h"
+#elif defined(ESP8266)
+#error "No ESP8266 backend yet (it goes in once it has been built against the Arduino core)"
+#else
+#define HAL_TARGET_PIC16    1
+#include "Nixie_hal_pic16.h"
+#endif
+
+void halInit(void);
+unsigned int halTimerNow(void);
+#if PERSIST_ENABLE
+void halNvRead(unsigned int at, unsigned char *buf, unsigned char n);
+void halNvErase(unsigned int at);
+void halNvWrite(unsigned int at, const unsigned char *buf, unsigned char n);
+#endif
+#if NTP_ENABLE
+void halNetSend(const unsigned char *pkt, unsigned char len);
+unsigned char halNetReceive(unsigned char *buf, unsigned char max);
+#endif
+
+#endif // NIXIE_HAL_H
@@ -0,0 +1,404 @@
+/*
+ * File:        Nixie_hal_host.c
+ * Compiler:    gcc (Linux)
+ *
+ * Info:    Linux side of the HAL (see Nixie_hal_host.h)
+ */
+
+#include "Nixie_config.h"
+#include "Nixie_tick.h"
+#include "Nixie_hal.h"
+#include "Nixie_dim.h"
+#include "Nixie_frame.h"
+
+#if HAL_TARGET_HOST
+
+#include <fcntl.h>
+#include <netdb.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+#define NS_PER_SEC          1000000000LL
+#define TIMER_HZ            384000LL    // same 2.6us counts as Timer1 on the PIC
+#define CHAIN_MASK          (~0ULL >> (64 - 8 * FRAME_BYTES))
+
+// The tubes as the terminal draws them, from DISPLAY_FIELDS (chain position, cathodes,
+// which time digit or -1 for a neon)
+typedef struct
+{
+    unsigned char at, cathodes;
+    signed char digit;
+} hostField_t;
+
+#define HOST_FIELD(name, n, shows, a)   { DISPLAY_##name##_AT, n, DISPLAY_DIGIT_##shows },
+static const hostField_t hostFields[] = { DISPLAY_FIELDS(HOST_FIELD, 0) };
+#define HOST_FIELDS         (int)(sizeof(hostFields) / sizeof(hostFields[0]))
+
+sigset_t halHostIrqs;
+volatile unsigned char halHostTickFlag = 0;
+volatile unsigned char halHostWrapFlag = 0;
+volatile unsigned char halHostSpiFlag = 0;
+volatile unsigned char halHostEncoderFlag = 0;
+volatile unsigned char halHostButtonFlag = 0;
+volatile unsigned char halHostAB = 0;
+volatile unsigned char halHostNetFlag = 0;
+volatile unsigned char halHostStreamFlag = 0;
+volatile unsigned char halHostAmbient = 255;
+long long halHostTickAt3 = 0;
+
+void ISR_High(void);
+
+static timer_t tickTimer;
+static timer_t streamTimer;
+static long long tickNext3;             // next sub-tick, in ns x 3 (a count is 1/3000 sec = 333,333.3ns)
+static unsigned char tickPeriod = TICK_PERIOD - 1;
+static long long wrapLast;
+static unsigned long long chain, outputs;
+static unsigned int dimDutyNow;
+static int uartFd = -1;
+static int nvFd = -1;
+static struct termios termSaved;
+
+static long long nowNs(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * NS_PER_SEC + ts.tv_nsec;
+}
+
+static void tickArm(void)
+{
+    struct itimerspec its = { { 0, 0 }, { 0, 0 } };
+    long long ns = tickNext3 / 3;
+
+    its.it_value.tv_sec = ns / NS_PER_SEC;
+    its.it_value.tv_nsec = ns % NS_PER_SEC;
+    timer_settime(tickTimer, TIMER_ABSTIME, &its, 0);
+}
+
+// One encoder detent, CW goes 00 -> 10 -> 11 -> 01 -> 00, an "interrupt" per edge
+static void turn(int cw)
+{
+    static const unsigned char seq[4] = { 0x2, 0x3, 0x1, 0x0 };
+    int k;
+
+    for(k=0; k<4; k++)
+    {
+        halHostAB = cw ? seq[k] : seq[(6 - k) % 4];
+        halHostEncoderFlag = 1;
+        ISR_High();
+    }
+}
+
+#if NTP_ENABLE
+static int netSocket = -1;
+
+static int netPending(void)
+{
+    int n = 0;
+
+    return (netSocket >= 0) && (ioctl(netSocket, FIONREAD, &n) == 0) && (n > 0);
+}
+#endif
+
+static void irq(int sig)
+{
+    char c;
+    long long wrap;
+
+    if(sig == SIGALRM)
+    {
+        halHostTickAt3 = tickNext3;
+        halHostTickFlag = 1;
+        wrap = (nowNs() * TIMER_HZ / NS_PER_SEC) >> 16;
+        if(wrap != wrapLast)
+        {
+            wrapLast = wrap;
+            halHostWrapFlag = 1;
+        }
+    }
+    else if(sig == SIGUSR1)
+        halHostSpiFlag = 1;
+    else if(sig == SIGUSR2)
+        halHostStreamFlag = 1;
+    else if(sig == SIGIO)
+    {
+        while(read(0, &c, 1) == 1)
+        {
+            if(c == '+' || c == '=')
+                turn(1);
+            else if(c == '-' || c == '_')
+                turn(0);
+            else if(c == ' ' || c == '\n')
+            {
+                halHostButtonFlag = 1;
+                ISR_High();
+            }
+            else if(c == '[' && halHostAmbient >= 16)
+                halHostAmbient -= 16;
+            else if(c == ']' && halHostAmbient <= 255 - 16)
+                halHostAmbient += 16;
+            else if(c == 'q')
+                exit(0);
+        }
+#if NTP_ENABLE
+        if(netPending())
+        {
+            halHostNetFlag = 1;
+            ISR_High();
+        }
+#endif
+        return;
+    }
+    ISR_High();
+}
+
+#if NTP_ENABLE
+// UDP socket "connected" to the time server, SIGIO when something comes in
+static void netOpen(void)
+{
+    struct addrinfo hints, *ai;
+    char host[128];
+    const char *port = "123";
+    const char *env = getenv("NIXIE_NTP_SERVER");
+    char *colon;
+
+    strncpy(host, env ? env : NTP_SERVER, sizeof(host) - 1);
+    host[sizeof(host) - 1] = 0;
+    colon = strrchr(host, ':');
+    if(colon)
+    {
+        *colon = 0;
+        port = colon + 1;
+    }
+
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_DGRAM;
+    if(getaddrinfo(host, port, &hints, &ai) != 0)
+        return; // no network, the clock just free runs
+
+    netSocket = socket(ai->ai_family, SOCK_DGRAM, 0);
+    if(netSocket >= 0)
+    {
+        connect(netSocket, ai->ai_addr, ai->ai_addrlen);
+        fcntl(netSocket, F_SETOWN, getpid());
+        fcntl(netSocket, F_SETFL, fcntl(netSocket, F_GETFL) | O_ASYNC | O_NONBLOCK);
+    }
+    freeaddrinfo(ai);
+}
+
+void halNetSend(const unsigned char *pkt, unsigned char len)
+{
+    if(netSocket >= 0)
+        send(netSocket, pkt, len, 0);
+}
+
+unsigned char halNetReceive(unsigned char *buf, unsigned char max)
+{
+    ssize_t n;
+
+    if(netSocket < 0)
+        return 0;
+    n = recv(netSocket, buf, max, 0);
+    return (n > 0) ? (unsigned char)n : 0;
+}
+#endif
+
+static void termRestore(void)
+{
+    tcsetattr(0, TCSANOW, &termSaved);
+    write(1, "\n", 1);
+}
+
+void halInit(void)
+{
+    struct sigaction sa;
+    struct sigevent sev;
+    struct termios t;
+
+    sigemptyset(&halHostIrqs);
+    sigaddset(&halHostIrqs, SIGALRM);
+    sigaddset(&halHostIrqs, SIGUSR1);
+    sigaddset(&halHostIrqs, SIGIO);
+    sigaddset(&halHostIrqs, SIGUSR2);
+    sigprocmask(SIG_BLOCK, &halHostIrqs, 0); // interrupts off until main() says so
+
+    sa.sa_handler = irq;
+    sa.sa_mask = halHostIrqs;   // one "ISR" at a time, like the PIC
+    sa.sa_flags = SA_RESTART;
+    sigaction(SIGALRM, &sa, 0);
+    sigaction(SIGUSR1, &sa, 0);
+    sigaction(SIGIO, &sa, 0);
+    sigaction(SIGUSR2, &sa, 0);
+
+    sev.sigev_notify = SIGEV_SIGNAL;
+    sev.sigev_signo = SIGALRM;
+    sev.sigev_value.sival_ptr = 0;
+    timer_create(CLOCK_MONOTONIC, &sev, &tickTimer);
+    sev.sigev_signo = SIGUSR2;
+    timer_create(CLOCK_MONOTONIC, &sev, &streamTimer);
+
+    // Keyboard: no line buffering, no echo, SIGIO on every key
+    if(tcgetattr(0, &termSaved) == 0)
+    {
+        t = termSaved;
+        t.c_lflag &= ~(ICANON | ECHO);
+        tcsetattr(0, TCSANOW, &t);
+        atexit(termRestore);
+    }
+    fcntl(0, F_SETOWN, getpid());
+    fcntl(0, F_SETFL, fcntl(0, F_GETFL) | O_ASYNC | O_NONBLOCK);
+
+    if(getenv("NIXIE_TELEM"))
+        uartFd = open(getenv("NIXIE_TELEM"), O_WRONLY | O_CREAT | O_APPEND, 0644);
+    if(getenv("NIXIE_STATE"))
+        nvFd = open(getenv("NIXIE_STATE"), O_RDWR | O_CREAT, 0644);
+
+    wrapLast = (nowNs() * TIMER_HZ / NS_PER_SEC) >> 16;
+#if NTP_ENABLE
+    netOpen();
+#endif
+}
+
+void halHostTickStart(void)
+{
+    halHostTickAt3 = nowNs() * 3;
+    tickNext3 = halHostTickAt3 + ((long long)tickPeriod + 1) * 1000000;
+    tickArm();
+}
+
+void halHostTickPeriod(unsigned char period)
+{
+    tickPeriod = period;
+    tickNext3 += ((long long)period + 1) * 1000000;   // from the last match, not from now
+    tickArm();
+}
+
+unsigned int halHostTickPhase(void)
+{
+    return (unsigned int)((nowNs() * 3 - halHostTickAt3) / 1000000);
+}
+
+// Frame stream pacing, hz from now on (0 = off)
+void halHostStream(unsigned int hz)
+{
+    struct itimerspec its = { { 0, 0 }, { 0, 0 } };
+
+    if(hz != 0)
+    {
+        its.it_interval.tv_nsec = NS_PER_SEC / hz;
+        its.it_value = its.it_interval;
+    }
+    halHostStreamFlag = 0;
+    timer_settime(streamTimer, 0, &its, 0);
+}
+
+// No G pin to dim, the terminal shows the duty instead (next latch)
+void halHostDim(unsigned int duty)
+{
+    dimDutyNow = duty;
+}
+
+// Telemetry byte, nowhere if NIXIE_TELEM isn't set
+void halHostUartWrite(unsigned char b)
+{
+    if(uartFd >= 0)
+        write(uartFd, &b, 1);
+}
+
+#if PERSIST_ENABLE
+// Non-volatile store in a file, bytes it doesn't have yet (or no file at all) read as erased
+void halNvRead(unsigned int at, unsigned char *buf, unsigned char n)
+{
+    ssize_t got = (nvFd >= 0) ? pread(nvFd, buf, n, at) : 0;
+
+    if(got < 0)
+        got = 0;
+    memset(buf + got, 0xFF, n - got);
+}
+
+void halNvErase(unsigned int at)
+{
+    unsigned char row[HAL_NV_ROW_BYTES];
+
+    memset(row, 0xFF, sizeof(row));
+    if(nvFd >= 0)
+        pwrite(nvFd, row, sizeof(row), at - at % HAL_NV_ROW_BYTES);
+}
+
+void halNvWrite(unsigned int at, const unsigned char *buf, unsigned char n)
+{
+    if(nvFd >= 0)
+        pwrite(nvFd, buf, n, at);
+}
+#endif
+
+unsigned int halTimerNow(void)
+{
+    return (unsigned int)((nowNs() * TIMER_HZ / NS_PER_SEC) & 0xFFFF);
+}
+
+void halHostSpiWrite(unsigned char b)
+{
+    chain = ((chain << 8) | b) & CHAIN_MASK;
+    halHostSpiFlag = 0;
+    raise(SIGUSR1); // "byte done", taken as soon as interrupts are on
+}
+
+// RCK: show the chain as tubes, the far end (first bit in, see Nixie_frame.h) on the left
+// A neon on the chain shows as ':' when lit, a pair of digits with nothing on the chain between
+// them gets a ':' anyway (the v1 board's IN-3s are wired straight to +170V)
+void halHostLatch(void)
+{
+    char line[3 * 64 + 16] = "\r  ";
+    int len = 3, last = -1, sep = 0;
+    unsigned int field;
+    int f, i;
+    char c;
+
+    outputs = chain;
+    for(f=HOST_FIELDS-1; f>=0; f--)
+    {
+        field = (unsigned int)(outputs >> hostFields[f].at) & ((1u << hostFields[f].cathodes) - 1);
+        if(hostFields[f].digit < 0)
+        {
+            line[len++] = field ? ':' : ' ';
+            sep = 1;
+            continue;
+        }
+        if((last >= 0) && !sep && (last / 2 != hostFields[f].digit / 2))
+            line[len++] = ':';
+
+        c = '-';
+        for(i=0; i<hostFields[f].cathodes; i++)
+            if(field & (1u << i))
+                c = (char)('0' + i);
+        line[len++] = c;
+        last = hostFields[f].digit;
+        sep = 0;
+    }
+    snprintf(line + len, sizeof(line) - len, "  %3u%% ", dimDutyNow * 100 / DIM_DUTY_MAX);
+    write(1, line, strlen(line));
+}
+
+void halHostIdle(void)
+{
+    sigset_t open;
+
+    sigprocmask(SIG_BLOCK, 0, &open);
+    sigdelset(&open, SIGALRM);
+    sigdelset(&open, SIGUSR1);
+    sigdelset(&open, SIGIO);
+    sigdelset(&open, SIGUSR2);
+    sigsuspend(&open);  // returns with the mask back the way it was (interrupts off)
+}
+
+#endif // HAL_TARGET_HOST
@@ -0,0 +1,107 @@
+/*
+ * File:        Nixie_hal_host.h
+ * Compiler:    gcc (Linux)
+ *
+ * Info:    Linux side of the HAL (see Nixie_hal.h): the same clock core runs as a
+ *          terminal program, tubes printed as text, encoder on the keyboard.
+ *
+ *          "Interrupts" are signals, all blocked together while one runs (like the PIC):
+ *              SIGALRM     sub-tick timer (POSIX timer on CLOCK_MONOTONIC, absolute, never drifts)
+ *              SIGUSR1     SPI byte done (the byte "shifts" instantly)
+ *              SIGIO       keyboard: + / - turn the encoder a detent, space = push button, q = quit,
+ *                          [ / ] darker / brighter room (DIM_MODE_AMBIENT)
+ *                          and the NTP socket (NIXIE_NTP_SERVER=host[:port] overrides NTP_SERVER)
+ *              SIGUSR2     frame stream pacing (a second POSIX timer, only while it's on)
+ *          The brightness (G duty) is printed after the tubes.
+ *          Telemetry "UART": appended to the file NIXIE_TELEM names (a FIFO works), never busy.
+ *          Non-volatile store: the file NIXIE_STATE names, the system clock stands in for an RTC.
+ *          HAL_IRQ_OFF/ON block/unblock them, HAL_IDLE() is sigsuspend().
+ */
+
+#ifndef NIXIE_HAL_HOST_H
+#define NIXIE_HAL_HOST_H
+
+#include <signal.h>
+#include <time.h>
+
+extern sigset_t halHostIrqs;                    // every signal used as an interrupt
+extern volatile unsigned char halHostTickFlag;
+extern volatile unsigned char halHostWrapFlag;
+extern volatile unsigned char halHostSpiFlag;
+extern volatile unsigned char halHostEncoderFlag;
+extern volatile unsigned char halHostButtonFlag;
+extern volatile unsigned char halHostAB;        // simulated encoder pins
+extern volatile unsigned char halHostNetFlag;
+extern volatile unsigned char halHostStreamFlag;
+extern long long halHostTickAt3;                // last sub-tick match the ISR took, ns x 3
+extern volatile unsigned char halHostAmbient;   // simulated light sensor
+
+void halHostTickStart(void);
+void halHostTickPeriod(unsigned char period);
+void halHostSpiWrite(unsigned char b);
+void halHostLatch(void);
+void halHostIdle(void);
+unsigned int halHostTickPhase(void);
+void halHostStream(unsigned int hz);
+void halHostDim(unsigned int duty);
+void halHostUartWrite(unsigned char b);
+
+#define HAL_ISR(name)           void name(void)
+#define HAL_IRQ_OFF()           sigprocmask(SIG_BLOCK, &halHostIrqs, 0)
+#define HAL_IRQ_ON()            sigprocmask(SIG_UNBLOCK, &halHostIrqs, 0)
+#define HAL_IDLE()              halHostIdle()
+
+#define HAL_TICK_START()        halHostTickStart()
+#define HAL_TICK_IRQ()          (halHostTickFlag == 1)
+#define HAL_TICK_ACK()          (halHostTickFlag = 0)
+#define HAL_TICK_LAG()          ((unsigned char)halHostTickPhase())    // mostly the kernel's timer slack
+#define HAL_TICK_PHASE()        halHostTickPhase()
+#define HAL_TICK_SET_PERIOD(p)  halHostTickPeriod(p)
+
+#define HAL_WRAP_IRQ()          (halHostWrapFlag == 1)
+#define HAL_WRAP_ACK()          (halHostWrapFlag = 0)
+
+#define HAL_SPI_WRITE(b)        halHostSpiWrite(b)
+#define HAL_SPI_READ()          0
+#define HAL_SPI_WAIT()          // already out
+#define HAL_SPI_IRQ()           (halHostSpiFlag == 1)
+#define HAL_SPI_ACK()           (halHostSpiFlag = 0)
+
+#define HAL_RCK_HIGH()          halHostLatch()
+#define HAL_RCK_HOLD()
+#define HAL_RCK_LOW()
+
+#define HAL_ENCODER_AB()        halHostAB
+#define HAL_ENCODER_IRQ()       (halHostEncoderFlag == 1)
+#define HAL_ENCODER_ACK()       (halHostEncoderFlag = 0)
+#define HAL_BUTTON_IRQ()        (halHostButtonFlag == 1)
+#define HAL_BUTTON_ACK()        (halHostButtonFlag = 0)
+
+#define HAL_NET_IRQ()           (halHostNetFlag == 1)
+#define HAL_NET_ACK()           (halHostNetFlag = 0)
+
+#define HAL_STREAM_START(hz)    halHostStream(hz)
+#define HAL_STREAM_STOP()       halHostStream(0)
+#define HAL_STREAM_IRQ()        (halHostStreamFlag == 1)
+#define HAL_STREAM_ACK()        (halHostStreamFlag = 0)
+
+#define HAL_DIM_SET(duty)       halHostDim(duty)
+#define HAL_AMBIENT_START()
+#define HAL_AMBIENT_READ()      halHostAmbient
+
+#define HAL_UART_READY()        1
+#define HAL_UART_WRITE(b)       halHostUartWrite(b)
+#define HAL_UART_WAKE()
+#define HAL_UART_IRQ()          0
+#define HAL_UART_ACK()
+
+#define HAL_NV_BYTES            256     // the file NIXIE_STATE names, reads 0xFF without one
+#define HAL_NV_ROW_BYTES        64
+#define HAL_RTC                 1       // the system clock
+#define HAL_RTC_SECS()          ((uint32_t)time(0))
+
+#define HAL_FLASH                               // plain const, it's all RAM here
+#define HAL_FLASH_U32(p)        (*(p))
+#define HAL_FLASH_S8(p)         (*(p))
+
+#endif // NIXIE_HAL_HOST_H
@@ -0,0 +1,272 @@
+/*
+ * File:        Nixie_hal_pic16.c
+ * Compiler:    XC8 v1.43
+ *
+ * Info:    PIC16F15325 side of the HAL: config bits, peripheral setup
+ *          and the Timer1 read (see Nixie_hal.h, Nixie_hal_pic16.h)
+ */
+
+#include "Nixie_config.h"
+#include "Nixie_tick.h"
+#include "Nixie_hal.h"
+
+#if HAL_TARGET_PIC16
+
+// PIC16F15325 Configuration Bit Settings
+// 'C' source line config statements
+#pragma config FEXTOSC = HS       // External Oscillator mode selection bits (HS (crystal oscillator) above 4MHz; PFM set to high power)
+#pragma config RSTOSC = EXT1X     // Power-up default value for COSC bits (EXTOSC operating per FEXTOSC bits)
+#pragma config CLKOUTEN = OFF     // Clock Out Enable bit (CLKOUT function is disabled; i/o or oscillator function on OSC2)
+#pragma config CSWEN = ON         // Clock Switch Enable bit (Writing to NOSC and NDIV is allowed)
+#pragma config FCMEN = OFF        // Fail-Safe Clock Monitor Enable bit (FSCM timer disabled)
+#pragma config MCLRE = ON         // Master Clear Enable bit (MCLR pin is Master Clear function)
+#pragma config PWRTE = OFF        // Power-up Timer Enable bit (PWRT disabled)
+#pragma config LPBOREN = OFF      // Low-Power BOR enable bit (ULPBOR disabled)
+#pragma config BOREN = OFF        // Brown-out reset enable bits (Brown-out reset disabled)
+#pragma config BORV = LO          // Brown-out Reset Voltage Selection (Brown-out Reset Voltage (VBOR) set to 1.9V on LF, and 2.45V on F Devices)
+#pragma config ZCD = OFF          // Zero-cross detect disable (Zero-cross detect circuit is disabled at POR.)
+#pragma config PPS1WAY = OFF      // Peripheral Pin Select one-way control (The PPSLOCK bit can be set and cleared repeatedly by software)
+#pragma config STVREN = OFF       // Stack Overflow/Underflow Reset Enable bit (Stack Overflow or Underflow will not cause a reset)
+#pragma config WDTCPS = WDTCPS_31 // WDT Period Select bits (Divider ratio 1:65536; software control of WDTPS)
+#pragma config WDTE = OFF         // WDT operating mode (WDT Disabled, SWDTEN is ignored)
+#pragma config WDTCWS = WDTCWS_7  // WDT Window Select bits (window always open (100%); software control; keyed access not required)
+#pragma config WDTCCS = SC        // WDT input clock selector (Software Control)
+#pragma config BBSIZE = BB512     // Boot Block Size Selection bits (512 words boot block size)
+#pragma config BBEN = OFF         // Boot Block Enable bit (Boot Block disabled)
+#if PERSIST_ENABLE
+#pragma config SAFEN = ON         // SAF Enable bit (SAF enabled: the saved state, Nixie_persist.h, the linker keeps code out)
+#else
+#pragma config SAFEN = OFF        // SAF Enable bit (SAF disabled)
+#endif
+#pragma config WRTAPP = OFF       // Application Block Write Protection bit (Application Block not write protected)
+#pragma config WRTB = OFF         // Boot Block Write Protection bit (Boot Block not write protected)
+#pragma config WRTC = OFF         // Configuration Register Write Protection bit (Configuration Register not write protected)
+#pragma config WRTSAF = OFF       // Storage Area Flash Write Protection bit (SAF not write protected)
+#pragma config LVP = OFF          // Low Voltage Programming Enable bit (High Voltage on MCLR/Vpp must be used for programming)
+#pragma config CP = OFF           // UserNVM Program memory code protection bit (UserNVM code protection disabled)
+
+void halInit(void)
+{
+    ANSELA = 0; // all digital I/O (no analog inputs)
+    ANSELC = 0; // all digital I/O (no analog inputs)
+    
+    // TRIS I/O Settings
+    //      C5 = Output for PWM3 to the G (output enable) pins of the shift registers (brightness)
+    //      C4 = Input for Encoder Channel A
+    //      C3 = Input for Encoder Channel B
+    //      C2 = Output for RCK Data Latch Output Pulse to shift registers
+    //      C1 = SPI SDO 44-bit serial output data (SER_IN) to shift registers
+    //      C0 = SPI Clock for the SRCK serial clock to shift registers
+    TRISC = 0b011000;
+    TRISA = 0b111111; //All inputs, OSC pins, Ext. INT, light sensor, etc.
+#if TELEM_ENABLE
+    TRISA = 0b111110; // A0 = Output for the telemetry UART TX
+#endif
+    
+    // Turn off everything in the beginning
+    HAL_RCK_LOW();
+    PORTCbits.RC0 = 0; // SCK/SCL
+    PORTCbits.RC1 = 0; // SDO
+    
+    // PPS Settings (Peripheral Pin Select) (mapping)
+    // want SDO on Pin 9 (RC1) & SCK on Pin 10 (RC0)
+    RC0PPS = 0x15;   // RC0->MSSP1:SCK1;
+    RC1PPS = 0x16;   // RC1->MSSP1:SDO1;
+    
+    // SPI settings (to send data/clock to the shift registers)
+    SSP1CON1bits.SSPEN  = 1; // Just turn ON and leave on
+    SSP1STATbits.CKE    = 1; // IDLE state is LOW (0), data transmitted out on rising edge of SCK
+    SSP1ADD             = SPI_CLOCK_SSPADD_DIV; // only used by SPI_CLOCK_FOSC_SSPADD
+    SSP1CON1bits.SSPM3  = (SPI_CLOCK_MODE >> 3) & 1; // SPI Clock, see Nixie_config.h
+    SSP1CON1bits.SSPM2  = (SPI_CLOCK_MODE >> 2) & 1; // (was 0010 = Fosc/64)
+    SSP1CON1bits.SSPM1  = (SPI_CLOCK_MODE >> 1) & 1;
+    SSP1CON1bits.SSPM0  = (SPI_CLOCK_MODE >> 0) & 1;
+    
+    // Timer settings (to generate the exact 1Hz Nixie clock latch signal)
+    /**
+     * d = 1.0sec
+     * Fosc = 12.288MHz = 12,288,000 Hz
+     * Fin = Fosc / 4 = 12.288MHz / 4 = 3.072MHz
+     * 
+     * Using 8-bit compare mode (TMR0L counts up to TMR0H, then the hardware clears it)
+     * Use prescaler 1:1024 and postscaler 1:1
+     * 
+     * 3,072,000 / 1024 = 3000 counts per second
+     * 3000 = 15 x 200, so TMR0H = 199 and the ISR counts 15 matches per second
+     * 
+     * No preload/reload in software anymore, so no counts get lost in the ISR (see Nixie_tick.h)
+     */
+    
+    T0CON0bits.T0EN     = 0; // timer0 off for the moment
+    T0CON0bits.T016BIT  = 0; // 8-bit timer0 mode (TMR0H is the period/compare register)
+    T0CON0bits.T0OUTPS3 = 0; // 0000 1:1 postscaler (no postscaler)
+    T0CON0bits.T0OUTPS2 = 0; // 0000 1:1 postscaler (no postscaler)
+    T0CON0bits.T0OUTPS1 = 0; // 0000 1:1 postscaler (no postscaler)
+    T0CON0bits.T0OUTPS0 = 0; // 0000 1:1 postscaler (no postscaler)
+    
+    T0CON1bits.T0CS2 = 0;   // 010 Timer0 clock source = Fosc/4
+    T0CON1bits.T0CS1 = 1;   // 010 Timer0 clock source = Fosc/4
+    T0CON1bits.T0CS0 = 0;   // 010 Timer0 clock source = Fosc/4
+    T0CON1bits.T0ASYNC = 0; // sync. timer0 counter with Fosc/4 (why the fuck not)
+    T0CON1bits.T0CKPS3 = 1; // 1010 1:1024 prescaler
+    T0CON1bits.T0CKPS2 = 0; // 1010 1:1024 prescaler
+    T0CON1bits.T0CKPS1 = 1; // 1010 1:1024 prescaler
+    T0CON1bits.T0CKPS0 = 0; // 1010 1:1024 prescaler
+    
+    TMR0H = TICK_PERIOD - 1; // 199, match every 200 counts (15 times a second)
+    TMR0L = 0;
+    
+    // Timer1 free running, time base for the encoder acceleration and the power accounting
+    // Fosc/4 / 8 = 384kHz (2.6us per count), wraps every 170ms
+    T1CLK = 0b0001;     // Timer1 clock source = Fosc/4
+    T1CON = 0b00110011; // 1:8 prescaler, RD16 (16-bit reads), timer on
+    
+    // Timer2 free running at 1kHz: Fosc/4 / 16 = 192kHz, T2PR = 191
+    // It's the PWM3 period, and its postscaler paces the frame stream (TMR2IF every n periods,
+    // HAL_STREAM_START() sets n), that interrupt is only enabled while a stream runs
+#if SLOT_ENABLE && ((1000 / SLOT_FRAME_HZ < 1) || (1000 / SLOT_FRAME_HZ > 16))
+#error "SLOT_FRAME_HZ: 63 to 1000 on the PIC (1kHz / a 1-16 postscaler)"
+#endif
+#if FADE_ENABLE && ((1000 / FADE_FRAME_HZ < 1) || (1000 / FADE_FRAME_HZ > 16))
+#error "FADE_FRAME_HZ: 63 to 1000 on the PIC (1kHz / a 1-16 postscaler)"
+#endif
+    T2CLKCON = 0b0001;  // Timer2 clock source = Fosc/4
+    T2PR = 191;
+    T2CON = HAL_T2CON_ON;
+    
+    // PWM3 --> RC5 --> TPIC6595 G, brightness (see Nixie_dim.h)
+    // Period = Timer2's (1ms), duty in Tosc x 16 = 768 for 100%, starts dark (dimInit() sets it)
+    RC5PPS = 0x0B;          // RC5->PWM3:PWM3OUT
+    CCPTMRS1 = 0b00000001;  // P3TSEL = Timer2
+    PWM3DCH = 0;
+    PWM3DCL = 0;
+    PWM3CON = 0b10010000;   // on, inverted (G is active low)
+    
+#if DIM_MODE == DIM_MODE_AMBIENT
+    // Light sensor on RA1: 8-bit is plenty, left justified so ADRESH is all of it
+    // Fosc/32 = 2.6us TAD, a conversion is ~30us, one a second
+    ANSELA = 0b000010;
+    ADCON1 = 0b00100000;    // left justified, Fosc/32, VDD reference
+    ADCON0 = 0b00000101;    // ANA1, ADC on
+#endif
+    
+#if TELEM_ENABLE
+    // EUSART TX --> RA0, telemetry (see Nixie_telem.h), receiver off
+    // BRG16 + BRGH: Fosc / (4 x (SP1BRG + 1)) = 12.288MHz / 320 = 38400 baud exactly
+#if TELEM_BAUD != 38400
+#error "TELEM_BAUD: only 38400 is worked out for the PIC (SP1BRG)"
+#endif
+    RA0PPS = 0x0F;          // RA0->EUSART1:TX1
+    BAUD1CON = 0b00001000;  // BRG16
+    SP1BRGH = 0;
+    SP1BRGL = 79;
+    TX1STA = 0b00100100;    // TXEN, asynchronous, BRGH
+    RC1STA = 0b10000000;    // SPEN
+#endif
+    
+    // Encoder channels: interrupt-on-change, both edges, both channels
+    IOCCP = HAL_ENCODER_IOC_MASK;   // rising edges on RC4, RC3
+    IOCCN = HAL_ENCODER_IOC_MASK;   // falling edges on RC4, RC3
+    IOCCF = 0;
+    
+    // Interrupt settings (1Hz timer0 interrupt, external switch interrupt)
+    PIE0bits.TMR0IE = 1;    // enable timer0 interrupt
+    INTCONbits.INTEDG = 1;  // INT rising edge triggered from PB Switch of the Encoder
+    PIE0bits.INTE = 1;      // enable external INT interrupt
+    PIR0bits.INTF = 0;
+    PIE0bits.IOCIE = 1;     // enable encoder interrupt-on-change
+    PIR4bits.TMR1IF = 0;
+    PIE4bits.TMR1IE = 1;    // Timer1 overflow, power accounting windows
+    
+    // SLEEP() means IDLE: CPU stops, Fosc + peripherals (Timer0!) keep running
+    CPUDOZEbits.IDLEN = 1;
+#if SPI_USE_INTERRUPT
+    PIR3bits.SSP1IF = 0;
+    PIE3bits.SSP1IE = 1;    // SPI byte done interrupt feeds the next byte of the frame
+#endif
+    INTCONbits.PEIE = 1;    // (GIE is left to main(), once it's ready)
+}
+
+// Free running Timer1 count (2.6us each)
+unsigned int halTimerNow(void)
+{
+    unsigned char lo = TMR1L; // TMR1L first, that latches TMR1H (RD16 mode) so the 16-bit read can't tear
+    
+    return ((unsigned int)TMR1H << 8) | lo;
+}
+
+#if PERSIST_ENABLE
+// Storage Area Flash, one byte per 14-bit word. Erase and write need the 0x55/0xAA unlock with
+// nothing in between, so interrupts are off for it, and the CPU stalls till the flash is done
+// (~2ms, the ISR runs late, the timers don't)
+static void nvUnlock(void)
+{
+    NVMCON2 = 0x55;
+    NVMCON2 = 0xAA;
+    NVMCON1bits.WR = 1;
+    NOP();
+    NOP();
+}
+
+void halNvRead(unsigned int at, unsigned char *buf, unsigned char n)
+{
+    unsigned int addr = HAL_NV_BASE + at;
+
+    NVMCON1bits.NVMREGS = 0;    // program memory, not the config words
+    while(n != 0)
+    {
+        NVMADRL = (unsigned char)addr;
+        NVMADRH = (unsigned char)(addr >> 8);
+        NVMCON1bits.RD = 1;
+        *buf++ = NVMDATL;
+        addr++;
+        n--;
+    }
+}
+
+void halNvErase(unsigned int at)
+{
+    unsigned int addr = HAL_NV_BASE + at;
+    unsigned char gie = INTCONbits.GIE;
+
+    INTCONbits.GIE = 0;
+    NVMADRL = (unsigned char)addr;
+    NVMADRH = (unsigned char)(addr >> 8);
+    NVMCON1bits.NVMREGS = 0;
+    NVMCON1bits.FREE = 1;
+    NVMCON1bits.WREN = 1;
+    nvUnlock();
+    NVMCON1bits.FREE = 0;
+    NVMCON1bits.WREN = 0;
+    INTCONbits.GIE = gie;
+}
+
+// Every byte but the last only loads its write latch, the last one writes the row
+// (latches that weren't loaded stay 0x3FFF and leave their words alone)
+void halNvWrite(unsigned int at, const unsigned char *buf, unsigned char n)
+{
+    unsigned int addr = HAL_NV_BASE + at;
+    unsigned char gie = INTCONbits.GIE;
+
+    INTCONbits.GIE = 0;
+    NVMCON1bits.NVMREGS = 0;
+    NVMCON1bits.WREN = 1;
+    NVMCON1bits.LWLO = 1;
+    while(n != 0)
+    {
+        NVMADRL = (unsigned char)addr;
+        NVMADRH = (unsigned char)(addr >> 8);
+        NVMDATL = *buf++;
+        NVMDATH = 0x3F;
+        if(n == 1)
+            NVMCON1bits.LWLO = 0;
+        nvUnlock();
+        addr++;
+        n--;
+    }
+    NVMCON1bits.WREN = 0;
+    INTCONbits.GIE = gie;
+}
+#endif
+
+#endif // HAL_TARGET_PIC16
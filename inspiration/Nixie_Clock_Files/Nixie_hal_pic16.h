@@ -0,0 +1,94 @@
+/*
+ * File:        Nixie_hal_pic16.h
+ * Compiler:    XC8 v1.43
+ *
+ * Info:    PIC16F15325 side of the HAL (see Nixie_hal.h).
+ *          Every macro is the plain register access, nothing more.
+ *
+ *          Pins:   RC0 SCK --> SRCK, RC1 SDO --> SER_IN, RC2 --> RCK
+ *                  RC4 encoder A, RC3 encoder B, RA2/INT push button
+ *          Timer0: 8-bit compare mode, Fosc/4 / 1024 = 3000 counts/sec (sub-tick)
+ *          Timer1: Fosc/4 / 8, free running (2.6us counts)
+ *          Timer2: Fosc/4 / 16 / 192 = 1kHz, free running: PWM3 period, postscaler --> frame stream pacing
+ *          PWM3:   RC5 --> TPIC6595 G (inverted, G low = outputs on for the duty part of each period)
+ *          ADC:    RA1 (ANA1) light sensor, DIM_MODE_AMBIENT only
+ *          EUSART: TX on RA0, 38400 8N1, telemetry (TELEM_ENABLE)
+ *          NVM:    Storage Area Flash 0x1F80-0x1FFF (SAFEN = ON), saved state (PERSIST_ENABLE),
+ *                  a byte in the low 8 bits of each word, 32 word rows, the CPU stalls ~2ms per erase / write
+ *          No RTC, the time a cold start gets back is the last one saved
+ */
+
+#ifndef NIXIE_HAL_PIC16_H
+#define NIXIE_HAL_PIC16_H
+
+#include <xc.h>
+
+#define _XTAL_FREQ 12288000 // Fosc = 12.288MHz (external crystal)
+
+#define HAL_ENCODER_IOC_MASK    0b00011000  // RC4 + RC3 interrupt-on-change flags
+
+#define HAL_ISR(name)           void interrupt name(void)
+#define HAL_IRQ_OFF()           (INTCONbits.GIE = 0)
+#define HAL_IRQ_ON()            (INTCONbits.GIE = 1)
+// SLEEP() is IDLE (IDLEN set in halInit()), NOP after it because the next instruction is prefetched
+#define HAL_IDLE()              do { SLEEP(); NOP(); } while(0)
+
+#define HAL_TICK_START()        (T0CON0bits.T0EN = 1)
+#define HAL_TICK_IRQ()          ((PIE0bits.TMR0IE == 1) && (PIR0bits.TMR0IF == 1))
+#define HAL_TICK_ACK()          (PIR0bits.TMR0IF = 0)
+#define HAL_TICK_LAG()          TMR0L
+#define HAL_TICK_SET_PERIOD(p)  (TMR0H = (p))
+
+#define HAL_WRAP_IRQ()          ((PIE4bits.TMR1IE == 1) && (PIR4bits.TMR1IF == 1))
+#define HAL_WRAP_ACK()          (PIR4bits.TMR1IF = 0)
+
+#define HAL_SPI_WRITE(b)        (SSP1BUF = (b))
+#define HAL_SPI_READ()          ((unsigned char)SSP1BUF)
+#define HAL_SPI_WAIT()          while(SSP1STATbits.BF == 0)
+#define HAL_SPI_IRQ()           ((PIE3bits.SSP1IE == 1) && (PIR3bits.SSP1IF == 1))
+#define HAL_SPI_ACK()           (PIR3bits.SSP1IF = 0)
+
+// LAT, not PORT, no read-modify-write
+#define HAL_RCK_HIGH()          (LATCbits.LATC2 = 1)
+#define HAL_RCK_HOLD()          NOP()   // TPIC6595 wants 40ns, one Tcy is 325ns
+#define HAL_RCK_LOW()           (LATCbits.LATC2 = 0)
+
+#define HAL_ENCODER_AB()        ((unsigned char)((PORTCbits.RC4 << 1) | PORTCbits.RC3))
+#define HAL_ENCODER_IRQ()       ((PIE0bits.IOCIE == 1) && (PIR0bits.IOCIF == 1))
+// clear only the flags seen, an edge landing right now isn't lost
+#define HAL_ENCODER_ACK()       (IOCCF ^= (IOCCF & HAL_ENCODER_IOC_MASK))
+#define HAL_BUTTON_IRQ()        ((PIE0bits.INTE == 1) && (PIR0bits.INTF == 1))
+#define HAL_BUTTON_ACK()        (PIR0bits.INTF = 0)
+
+// Writing T2CON clears the postscaler and leaves T2TMR alone (no glitch in the PWM on G),
+// so the first frame is 1/hz out, less whatever part of a period had already gone by
+#define HAL_T2CON_ON            0b11000000  // on, 1:16 prescaler
+#define HAL_STREAM_START(hz)    do { T2CON = HAL_T2CON_ON | (1000 / (hz) - 1); PIR4bits.TMR2IF = 0; PIE4bits.TMR2IE = 1; } while(0)
+#define HAL_STREAM_STOP()       (PIE4bits.TMR2IE = 0)
+#define HAL_STREAM_IRQ()        ((PIE4bits.TMR2IE == 1) && (PIR4bits.TMR2IF == 1))
+#define HAL_STREAM_ACK()        (PIR4bits.TMR2IF = 0)
+
+// 10-bit duty, double buffered by the hardware (loads at the next period)
+#define HAL_DIM_SET(duty)       do { PWM3DCH = (unsigned char)((duty) >> 2); PWM3DCL = (unsigned char)((duty) << 6); } while(0)
+#define HAL_AMBIENT_START()     (ADCON0bits.GO = 1)
+#define HAL_AMBIENT_READ()      ADRESH  // left justified, top 8 bits
+
+// TX1IF = TX1REG has room, it can't be cleared (only a write does that), so the interrupt
+// is just a wake-up: on while main() naps with bytes waiting, off again in the ISR
+#define HAL_UART_READY()        (PIR3bits.TX1IF == 1)
+#define HAL_UART_WRITE(b)       (TX1REG = (b))
+#define HAL_UART_WAKE()         (PIE3bits.TX1IE = 1)
+#define HAL_UART_IRQ()          ((PIE3bits.TX1IE == 1) && (PIR3bits.TX1IF == 1))
+#define HAL_UART_ACK()          (PIE3bits.TX1IE = 0)
+
+#define HAL_NV_BASE             0x1F80  // SAF, the last 128 words of program memory
+#define HAL_NV_BYTES            128
+#define HAL_NV_ROW_BYTES        32
+#define HAL_RTC                 0
+#define HAL_RTC_SECS()          0UL
+
+#define HAL_FLASH                               // XC8 puts const in program memory by itself
+#define HAL_FLASH_U32(p)        (*(p))
+#define HAL_FLASH_S8(p)         (*(p))
+
+#endif // NIXIE_HAL_PIC16_H
@@ -5,7 +5,7 @@
  * 
  * Started: February 25, 2018, 9:33 PM (while drunk)
  * 
- * Info:    This .C code is for a 12-Hour Nixie Tube Clock circuit.
+ * Info:    This .C code is for a 12-Hour (or 24-Hour, see Nixie_config.h) Nixie Tube Clock circuit.
  *          This PIC determines/controls/outputs the accurate 1Hz clock signal. 
  *          It also correctly determines and feeds time display values to the shift registers (logic-level). 
  * 
@@ -16,8 +16,8 @@
  *          This code needs to produce a 44-bit number (to send out Sync. serially)
  *              to represent the time of a 12-hour clock (H1H0:M1M0:S1S0), details below. 
  *
- *          If you want a 24-hour clock, you have to rework the code and
- *              output a 45-bit number (to account for the additional digit of H1)
+ *          If you want a 24-hour clock, set CLOCK_24_HOUR in Nixie_config.h, the code then
+ *              outputs a 45-bit number (to account for the additional digit of H1)
  * 
  *          Full details of this project (circuit/SCH/PCB/etc.) can be found at:
  *              "Projects" tab at http://crystal.uta.edu/~burns/
@@ -33,7 +33,7 @@
  * DETAILED NOTES:  
  * 
  * Want a 12-hour clock format
- * 12hr x 60min x 60sec = 43,200 dec (use a single global var to store this value, unsigned int of 16 bits will do)
+ * 12hr x 60min x 60sec = 43,200 states, kept as the six display digits (H1H0:M1M0:S1S0) so the PIC never has to divide
  * 44-bit binary format for shift registers (H1H0:M1M0:S1S0): 
  *            H1: 1,0   H0: 2,1-9,0,1   M1: 0-5   M0: 0-9   S1: 0-5   S0: 0-9           (decimal digits)
  *              H1           H0           M1        M0        S1        S0
@@ -67,51 +67,103 @@
  *      6. When 1sec (1Hz) timer interrupt goes off, pulse the RCK (latches the shift registers, Nixie tubes show new numbers)
  *      7. Increment the current time vars
  *      8. Go back to step 1
+ *      (main() naps in IDLE whenever it is waiting on an interrupt, see Nixie_power.h)
+ * 
+ * Control flow:
+ *      The ISR only does what can't wait (RCK pulse, feeding SPI bytes, decoding encoder edges,
+ *      counting seconds) and posts an event. main() is one loop: take the highest priority event
+ *      (tick > SPI done > button > encoder), run its handler to completion, let frameService()
+ *      keep the shift registers fed, nap when nothing is pending. See Nixie_sched.h for the
+ *      worst-case latency of each event class.
+ *      Every register access goes through the HAL_xxx() macros (Nixie_hal.h), so this same file
+ *      builds for the PIC16F15325 (and the sim/ simulator) and a Linux terminal clock.
+ * 
+ * Network time (Linux only for now, NTP_ENABLE):
+ *      The ISR stamps a reply's arrival (clockNow(): utcSecs + sub-tick counts), onNet() hands it to
+ *      the NTP client, and the client only ever changes tickTrimPpb, so the tubes speed up or slow
+ *      down by a count here and there and never skip or repeat a second (Nixie_ntp.h).
+ *      The first sync is the one exception, ntpClockStep() sets myTime from UTC in TZ_ZONE.
+ *      DST changes come off a precomputed table (Nixie_tz.h): onTick() compares utcSecs with the
+ *      next transition and only resets myTime when it's reached (a jump of the hours, like any clock).
+ * 
+ * Frame pipeline (Free Running Mode):
+ *      The TPIC6595s are already double buffered: the shift stage is the back buffer,
+ *      the output latch (RCK) is the front buffer the tubes are showing.
+ *      frameState is the handshake between main() and the 1Hz ISR for that back buffer:
+ *          FRAME_EMPTY  --main()-->  FRAME_SHIFTING  --SPI ISR-->  FRAME_READY  --1Hz ISR-->  FRAME_EMPTY
+ *      main() builds frame N+1 and clocks all of it into the chain right after second N is latched,
+ *      so it's sitting ready ~1sec ahead of the deadline. The ISR only pulses RCK if the frame is
+ *      FRAME_READY, it never latches a half-shifted frame (it counts a miss in frameLate instead,
+ *      unless it's a live frame that has the chain, see below: an edit that lands right on the second).
+ *      myTime is always the time the tubes are showing. When it changes under the pipeline (an edit,
+ *      or a missed latch) main() shifts in a "live" frame instead, which the SPI ISR latches the
+ *      moment its last bit is in (frameLive), then the pipeline carries on from there.
+ * 
+ *      Timer match --> RCK edge latency:
+ *          main() only clears GIE for the few instructions around a nap (~10 Tcy, IDLE wakes up
+ *          instantly since the crystal never stops), so the things between the timer match and the RCK
+ *          edge are that, the interrupt latency (3-5 Tcy), the flag tests and the sub-tick count (~12 Tcy),
+ *          i.e. under 30 Tcy = 10us @ 12.288MHz. The one exception is the ISR already running for
+ *          the push button, an encoder edge or an SPI byte when the timer matches, which adds that branch
+ *          (~40 Tcy worst, the encoder) on top.
+ *          Upper bound: 70 Tcy = 23us (counted by hand; the simulator's 11 Tcy timer match -> RCK only
+ *          counts SFR accesses, a lower bound). latchLagMax keeps the worst lag actually seen,
+ *          in TMR0 counts (1024 Tcy = 333us each), so anything but 0 there means something is badly wrong.
+ *          (The latency no longer costs accuracy either way, Timer0 restarts itself, see Nixie_tick.h)
+ *          The whole 1Hz branch of the ISR (RCK pulse, tickTrimSecond(), posting EVT_TICK) is ~100 Tcy worst case by hand
+ *          (~33us with a trim), so the push button never waits longer than that.
+ *          (timeTick() itself runs in main() now, the ISR just counts seconds in ticksOwed)
+ * 
+ * Frame stream (anti-poisoning SLOT_ENABLE, see Nixie_slot.h, and crossfade FADE_ENABLE, see Nixie_dim.h):
+ *      Right after the second's RCK onTick() may hand the chain to Timer2 (streamState): at the top of every
+ *      minute (and all through the maintenance window) an anti-poisoning burst, any other second a crossfade
+ *      from the second before (that RCK latches the second before again, fadeArmed, so the fade starts
+ *      from the old digits at the edge). The Timer2 interrupt streams frames through the same SPI engine (each one
+ *      latched the moment it's in, like a live frame) while frameService() keeps off the chain. A crossfade
+ *      stops itself after its last frame, the tick ISR stops anything still running at sub-tick streamStopAt,
+ *      at least 66ms before the next second, and frameService() puts myTime and then the pipeline frame back in
+ *      well before that RCK. The 1Hz RCK itself never moves.
+ *
+ * Brightness (see Nixie_dim.h):
+ *      PWM3 on the TPIC6595 G pin, onTick() nudges it a level a second towards what DIM_MODE says.
+ * 
+ * Telemetry (TELEM_ENABLE, see Nixie_telem.h):
+ *      The ISR drops a record for every second's RCK (timer lag + a Timer1 stamp) and every frame it finishes
+ *      shifting, main() one for every mode change, encoder turn and NTP update, all into a RAM ring that
+ *      main() drains out of the UART between events. While there's something left to send, idleNap() lets
+ *      the UART wake it up for the next byte. None of it is between the timer match and the RCK edge.
+ * 
+ * Cold start (PERSIST_ENABLE, see Nixie_persist.h):
+ *      persistRestore() puts the newest saved time (plus the brightness, and on a network clock the
+ *      crystal error) back before the first frame goes out, so the tubes light up at the time the clock
+ *      had when it last saved instead of 12:00:00, or with an RTC at the right time. The save itself is
+ *      persistService(), after every PERSIST_SAVE_MINS, leaving the edit modes and an NTP step, and only
+ *      at a quiet moment: next second's frame in, no stream, over a sub-tick before the RCK, since the
+ *      PIC's CPU (ISR and all) stalls for the ~5ms of flash erase + write. The timers keep going.
  * 
  * General structure (User Set Mode): 
  *      1. External INT pin interrupt connected to the Push Button switch of the Rotary Encoder
  *      2. This push action cycles through individually adjusting (inc/dec) the HOURS, MINS, and then SECS
- *      3. One more push puts the clock back into normal Free Running Mode, starting off wherever you adjusted to
+ *      3. One more push puts the clock back into normal Free Running Mode
+ *         (the clock never stops, it keeps counting from wherever you adjusted it to while you edit the rest)
  *      4. The rotary encoder increments/decrements individual digit segments and updates in real-time (as instant as possible)
+ *         (both channels are decoded on interrupt-on-change, spinning it fast moves several units per detent, see Nixie_encoder.h)
  */
 
-// PIC16F15325 Configuration Bit Settings
-// 'C' source line config statements
-#pragma config FEXTOSC = HS       // External Oscillator mode selection bits (HS (crystal oscillator) above 4MHz; PFM set to high power)
-#pragma config RSTOSC = EXT1X     // Power-up default value for COSC bits (EXTOSC operating per FEXTOSC bits)
-#pragma config CLKOUTEN = OFF     // Clock Out Enable bit (CLKOUT function is disabled; i/o or oscillator function on OSC2)
-#pragma config CSWEN = ON         // Clock Switch Enable bit (Writing to NOSC and NDIV is allowed)
-#pragma config FCMEN = OFF        // Fail-Safe Clock Monitor Enable bit (FSCM timer disabled)
-#pragma config MCLRE = ON         // Master Clear Enable bit (MCLR pin is Master Clear function)
-#pragma config PWRTE = OFF        // Power-up Timer Enable bit (PWRT disabled)
-#pragma config LPBOREN = OFF      // Low-Power BOR enable bit (ULPBOR disabled)
-#pragma config BOREN = OFF        // Brown-out reset enable bits (Brown-out reset disabled)
-#pragma config BORV = LO          // Brown-out Reset Voltage Selection (Brown-out Reset Voltage (VBOR) set to 1.9V on LF, and 2.45V on F Devices)
-#pragma config ZCD = OFF          // Zero-cross detect disable (Zero-cross detect circuit is disabled at POR.)
-#pragma config PPS1WAY = OFF      // Peripheral Pin Select one-way control (The PPSLOCK bit can be set and cleared repeatedly by software)
-#pragma config STVREN = OFF       // Stack Overflow/Underflow Reset Enable bit (Stack Overflow or Underflow will not cause a reset)
-#pragma config WDTCPS = WDTCPS_31 // WDT Period Select bits (Divider ratio 1:65536; software control of WDTPS)
-#pragma config WDTE = OFF         // WDT operating mode (WDT Disabled, SWDTEN is ignored)
-#pragma config WDTCWS = WDTCWS_7  // WDT Window Select bits (window always open (100%); software control; keyed access not required)
-#pragma config WDTCCS = SC        // WDT input clock selector (Software Control)
-#pragma config BBSIZE = BB512     // Boot Block Size Selection bits (512 words boot block size)
-#pragma config BBEN = OFF         // Boot Block Enable bit (Boot Block disabled)
-#pragma config SAFEN = OFF        // SAF Enable bit (SAF disabled)
-#pragma config WRTAPP = OFF       // Application Block Write Protection bit (Application Block not write protected)
-#pragma config WRTB = OFF         // Boot Block Write Protection bit (Boot Block not write protected)
-#pragma config WRTC = OFF         // Configuration Register Write Protection bit (Configuration Register not write protected)
-#pragma config WRTSAF = OFF       // Storage Area Flash Write Protection bit (SAF not write protected)
-#pragma config LVP = OFF          // Low Voltage Programming Enable bit (High Voltage on MCLR/Vpp must be used for programming)
-#pragma config CP = OFF           // UserNVM Program memory code protection bit (UserNVM code protection disabled)
-
-#include <xc.h>
-#include <math.h>
-
-#define _XTAL_FREQ 12288000 // Fosc = 12.288MHz (external crystal)
-
-#define RCK_Latch_Signal    PORTCbits.RC2 // output IO pulse to latch out Shift Register data
-#define Encoder_Ch_A        PORTCbits.RC4 // input from Channel A of the Encoder (RPG)
-#define Encoder_Ch_B        PORTCbits.RC3 // input from Channel B of the Encoder (RPG)
+#include "Nixie_config.h"
+#include "Nixie_hal.h"
+#include "Nixie_time.h"
+#include "Nixie_frame.h"
+#include "Nixie_tick.h"
+#include "Nixie_encoder.h"
+#include "Nixie_power.h"
+#include "Nixie_sched.h"
+#include "Nixie_ntp.h"
+#include "Nixie_tz.h"
+#include "Nixie_slot.h"
+#include "Nixie_dim.h"
+#include "Nixie_telem.h"
+#include "Nixie_persist.h"
 
 #define MODE_FREE_RUNNING   0   // clock increments freely and normally
 #define MODE_EDIT_HOURS     1   // user can use the encoder to select/adjust HOURS digits
@@ -119,395 +171,906 @@
 #define MODE_EDIT_SECS      3   // user can use the encoder to select/adjust SECONDS digits
 
 unsigned char currentMode = 0;  // 4 different modes the clock can be in (incremented by the push button of the encoder)
-unsigned int myTime = 0;        // 0 to 43,200 decimal (12hr x 60min x 60sec = 43,200)
-unsigned char waitFlag = 0;     // set in the timer ISR, used in main() to prevent unnec. time calculations
+nixieTime_t myTime;             // H1H0:M1M0:S1S0 kept as digits (no / or % needed anywhere, see Nixie_time.h)
+nixieTime_t nextTime;           // myTime + 1sec, what the pipeline frame in the shift registers shows
+
+#define FRAME_EMPTY         0   // latched (consumed) by the ISR, main() needs to build and shift the next one
+#define FRAME_SHIFTING      1   // main() is clocking the next frame into the shift registers, DON'T latch
+#define FRAME_READY         2   // next frame is fully in the shift registers, ISR may latch it
+
+volatile unsigned char frameState = FRAME_EMPTY; // frame pipeline handshake (main() <--> 1Hz ISR)
+unsigned char frameLate = 0;    // number of 1Hz ticks that found the next frame not ready (should stay 0)
+unsigned char latchLagMax = 0;  // worst timer match --> RCK latency seen, in TMR0 counts (1024 Tcy each)
+#if STREAM_ENABLE
+volatile unsigned char streamState = STREAM_IDLE;   // who owns the chain between RCKs (see Nixie_frame.h)
+unsigned char streamStopAt = TICK_SUBTICKS - 1;
+unsigned int streamSkipped = 0;
+#endif
+volatile unsigned char subTick = 0; // TMR0 matches so far this second (0 to TICK_SUBTICKS-1)
+volatile unsigned char ticksOwed = 0;   // seconds counted by the ISR (wraps, only the difference matters)
+unsigned char ticksDone = 0;            // seconds main() has added to myTime
+volatile unsigned char latchMissed = 0; // a second went by without a READY frame, tubes are behind
+volatile unsigned char frameLive = 0;   // frame being shifted is myTime, latch it as soon as it's in
+unsigned char showPending = 0;          // myTime changed, the tubes need it right now
+volatile unsigned char timer1Wraps = 0; // Timer1 overflows (every 170.7ms)
+unsigned char encoderWraps = 0;     // timer1Wraps at the last encoder edge (ISR only)
+unsigned int wakeStamp = 0;         // Timer1 count when main() last woke up from a nap
+#if NTP_ENABLE
+uint32_t utcSecs = NTP_BOOT_SECS;       // UTC seconds since 1900 that myTime shows (ticksDone's worth)
+unsigned int subTickCounts = 0;         // sub-timer counts from the second boundary to the current sub-tick
+unsigned char subTickLen = TICK_PERIOD; // counts in the current sub-tick
+ntpStamp_t ntpRxStamp;                  // when the last network packet came in (stamped in the ISR)
+#endif
+
+unsigned char nextFrame[FRAME_BYTES];   // frame being shifted out (has to stay put until the SPI is done with it)
+const unsigned char *spiTxPtr;          // next byte the SPI interrupt will load into SSP1BUF
+volatile unsigned char spiTxCount = 0;  // bytes still to go after the one currently shifting
+volatile unsigned char spiBusy = 0;     // 1 while a frame is being clocked out
+#if PERSIST_ENABLE
+unsigned char persistDue = 0;           // save at the next quiet moment (persistService())
+unsigned int persistSecs = 0;           // seconds since the last save
+#if NTP_ENABLE
+unsigned long persistNtpSteps = 0;      // ntpSteps at the last save
+#endif
+#endif
+#if TELEM_ENABLE
+unsigned int spiStartedAt;              // Timer1 at spiStartFrame()
+unsigned char spiIrqs;                  // button + encoder interrupts while it shifted
+#if STREAM_ENABLE
+unsigned char streamRan;                // STREAM_SLOT / STREAM_FADE, for the summary once it's DONE
+unsigned char streamFrames;             // frames it shifted...
+unsigned char streamLongest;            // ...and the longest of them, Timer1 counts (both stop at 255)
+#endif
+#if NTP_ENABLE
+unsigned long telemNtpUpdates = 0;      // ntpUpdates / ntpSteps already reported
+unsigned long telemNtpSteps = 0;
+#endif
+#endif
 
 // Function Prototypes
-void interrupt ISR_High(void);
-void sendDataOut(void);
+HAL_ISR(ISR_High);
+void sendDataOut(const nixieTime_t *t);
 void latchOutData(void);
+void spiStartFrame(const unsigned char *frame);
+void spiFrameDone(void);
+void idleNap(void);
+void frameService(void);
+void onTick(void);
+void onButton(void);
+void onEncoder(void);
+#if NTP_ENABLE
+void onNet(void);
+ntpStamp_t clockNow(void);
+#endif
+#if STREAM_ENABLE
+void streamStop(void);
+#endif
+#if PERSIST_ENABLE
+void persistRestore(void);
+void persistService(void);
+#endif
+#if TELEM_ENABLE
+void telemShiftDone(void);
+#if NTP_ENABLE
+void telemNtp(void);
+#endif
+#endif
 
 void main(void) 
 {
     unsigned char i = 0;
-    unsigned char aState_curr = 0;
-    unsigned char aState_prev = 0;
-    unsigned char adjustSecs = 0;  // only valid values 0-59
-    unsigned char adjustMins = 0;  // only valid values 0-59
-    unsigned char adjustHours = 0; // only valid values 1-12, but remember 12 truly means 0
-    
-    ANSELA = 0; // all digital I/O (no analog inputs)
-    ANSELC = 0; // all digital I/O (no analog inputs)
-    
-    // TRIS I/O Settings
-    //      C5 = Don't Care (or output testing BLUE_LED)
-    //      C4 = Input for Encoder Channel A
-    //      C3 = Input for Encoder Channel B
-    //      C2 = Output for RCK Data Latch Output Pulse to shift registers
-    //      C1 = SPI SDO 44-bit serial output data (SER_IN) to shift registers
-    //      C0 = SPI Clock for the SRCK serial clock to shift registers
-    TRISC = 0b011000;
-    TRISA = 0b111111; //All inputs, OSC pins, Ext. INT, etc.
-    
-    // Turn off everything in the beginning
-    RCK_Latch_Signal = 0;
-    PORTCbits.RC0 = 0; // SCK/SCL
-    PORTCbits.RC1 = 0; // SDO
-    
-    // PPS Settings (Peripheral Pin Select) (mapping)
-    // want SDO on Pin 9 (RC1) & SCK on Pin 10 (RC0)
-    RC0PPS = 0x15;   // RC0->MSSP1:SCK1;
-    RC1PPS = 0x16;   // RC1->MSSP1:SDO1;
-    
-    // SPI settings (to send data/clock to the shift registers)
-    SSP1CON1bits.SSPEN  = 1; // Just turn ON and leave on
-    SSP1STATbits.CKE    = 1; // IDLE state is LOW (0), data transmitted out on rising edge of SCK
-    SSP1CON1bits.SSPM3  = 0; // 0010 SPI Clock = Fosc/64
-    SSP1CON1bits.SSPM2  = 0; // 0010 SPI Clock = Fosc/64
-    SSP1CON1bits.SSPM1  = 1; // 0010 SPI Clock = Fosc/64
-    SSP1CON1bits.SSPM0  = 0; // 0010 SPI Clock = Fosc/64
+    unsigned char evt = EVT_NONE;
+    
+    timeReset(&myTime); // 12:00:00 (or 00:00:00 for a 24-hour clock)
+    
+    halInit(); // pins, SPI, timers, interrupt sources, see Nixie_hal.h (interrupts still off)
+    encoderReset(HAL_ENCODER_AB());
+#if TELEM_ENABLE
+    telemInit();           // TELEM_BOOT first thing on the wire
+#endif
+#if PERSIST_ENABLE
+    persistRestore();      // the time (and brightness) saved before the power went, see Nixie_persist.h
+#endif
+    HAL_IRQ_ON();
     
     // Clear all the outputs of the shift registers (turn off all Nixies)
-    for(i=0; i<6; i++)
+    // FRAME_BYTES x 8 bits of 0 for all the shift register outputs
+    for(i=0; i<FRAME_BYTES; i++)
+        nextFrame[i] = 0b00000000;
+    
+    spiStartFrame(nextFrame);
+    while(spiBusy == 1)
     {
-        SSP1BUF = 0b00000000; // 6 x 8 bits for all the shift register outputs
-        while(SSP1STATbits.BF == 0);
+        HAL_IRQ_OFF();
+        if(spiBusy == 1)
+            HAL_IDLE();
+        HAL_IRQ_ON();
     }
     
     // Latch everything out of the shift registers all at once
     latchOutData();
+    dimInit();             // and light them (G PWM)
     
-    // Timer settings (to generate the exact 1Hz Nixie clock latch signal)
-    /**
-     * d = 1.0sec
-     * Fosc = 12.288MHz = 12,288,000 Hz
-     * Fin = Fosc / 4 = 12.288MHz / 4 = 3.072MHz
-     * 
-     * Using 16-bit mode (0-65,535)
-     * Use prescaler 1:64 and postscaler 1:1 to fit into 16-bit register (<65k)
-     * 
-     * 3,072,000 / 64 / 1 = 48,000
-     * Preload = 65,536 - 48,000 = 17,536 = 0x4480
-     */
-    
-    T0CON0bits.T0EN     = 0; // timer0 off for the moment
-    T0CON0bits.T016BIT  = 1; // 16-bit timer0 mode
-    T0CON0bits.T0OUTPS3 = 0; // 0000 1:1 postscaler (no postscaler)
-    T0CON0bits.T0OUTPS2 = 0; // 0000 1:1 postscaler (no postscaler)
-    T0CON0bits.T0OUTPS1 = 0; // 0000 1:1 postscaler (no postscaler)
-    T0CON0bits.T0OUTPS0 = 0; // 0000 1:1 postscaler (no postscaler)
-    
-    T0CON1bits.T0CS2 = 0;   // 010 Timer0 clock source = Fosc/4
-    T0CON1bits.T0CS1 = 1;   // 010 Timer0 clock source = Fosc/4
-    T0CON1bits.T0CS0 = 0;   // 010 Timer0 clock source = Fosc/4
-    T0CON1bits.T0ASYNC = 0; // sync. timer0 counter with Fosc/4 (why the fuck not)
-    T0CON1bits.T0CKPS3 = 0; // 0110 1:64 prescaler
-    T0CON1bits.T0CKPS2 = 1; // 0110 1:64 prescaler
-    T0CON1bits.T0CKPS1 = 1; // 0110 1:64 prescaler
-    T0CON1bits.T0CKPS0 = 0; // 0110 1:64 prescaler
-    
-    TMR0H = 0x44; // preload value = 0x4480 (LOAD HIGH FIRST!!!)
-    TMR0L = 0x80; // preload value = 0x4480
-    
-    // Interrupt settings (1Hz timer0 interrupt, external switch interrupt)
-    PIE0bits.TMR0IE = 1;    // enable timer0 interrupt
-    INTCONbits.INTEDG = 1;  // INT rising edge triggered from PB Switch of the Encoder
-    PIE0bits.INTE = 1;      // enable external INT interrupt
-    PIR0bits.INTF = 0;
-    INTCONbits.PEIE = 1;
-    INTCONbits.GIE  = 1;
-    
-    T0CON0bits.T0EN = 1;   // start timer0
+    HAL_TICK_START();      // start the sub-tick timer (and it never stops again)
+    showPending = 1;       // show 12:00:00 (or the restored time) right away, the pipeline takes over from there
+#if NTP_ENABLE
+    tzLocate(utcSecs);
+    ntpInit();             // first request goes out on the first tick
+#endif
 
     // main routine while loop
     while(1)
     {
-        while(currentMode == MODE_FREE_RUNNING)
+        // Highest priority event first, its handler runs to completion
+        HAL_IRQ_OFF();
+        evt = schedNext(halTimerNow());
+        HAL_IRQ_ON();
+        
+        if(evt == EVT_TICK)
+            onTick();
+        else if(evt == EVT_BUTTON)
+            onButton();
+        else if(evt == EVT_ENCODER)
+            onEncoder();
+#if NTP_ENABLE
+        else if(evt == EVT_NET)
+            onNet();
+#endif
+        // (EVT_SPI_DONE has no handler of its own, frameService() below starts the next shift)
+        
+        // Keep the shift registers fed (the one thing every event can lead to)
+        frameService();
+#if PERSIST_ENABLE
+        persistService();  // a save that's due, if now's a quiet moment
+#endif
+#if TELEM_ENABLE
+        telemDrain();      // as much as the UART takes right now, idleNap() wakes up for the rest
+#endif
+        
+        // Nothing left to do until the next interrupt (sub-tick, SPI byte, encoder, button), take a nap
+        HAL_IRQ_OFF();
+        if(schedPending == 0)
+            idleNap();
+        HAL_IRQ_ON();
+    } // end of while(1)
+} // end of void main(void)
+
+// EVT_TICK: the ISR latched a new second (or missed it), catch myTime up
+void onTick(void)
+{
+#if FADE_ENABLE
+    nixieTime_t before = myTime;    // what the tubes showed until the RCK
+    unsigned char secs = 0;
+#endif
+    
+    // Normally exactly one second, more only if main() got held up for a whole second
+    while(ticksDone != ticksOwed)
+    {
+#if FADE_ENABLE
+        secs++;
+#endif
+        timeTick(&myTime); // ripple-carry +1 second, a handful of instructions
+        ticksDone++;
+#if PERSIST_ENABLE
+        persistSecs++;
+#endif
+#if NTP_ENABLE
+        utcSecs++;
+        if(utcSecs == tzNextAt) // DST on/off, the only per second cost of the time zone
         {
-            if(waitFlag == 0) // Only do if ready, don't perform unnec. calculations
+            tzAdvance();
+            if(ntpSynced == 1)  // (before the first sync myTime is whatever got dialed in, leave it be)
             {
-                sendDataOut();
-                waitFlag = 1;
+                timeSet(&myTime, tzSecsOfDay(utcSecs));
+                showPending = 1;
             }
         }
-        
-        // User Set Mode: Adjust the Hours Digits of the Clock
-        while(currentMode == MODE_EDIT_HOURS)
+        ntpSecond();       // polls, and the slew (never touches myTime, only the tick rate)
+#endif
+    }
+#if TELEM_ENABLE && NTP_ENABLE
+    telemNtp();
+#endif
+#if PERSIST_ENABLE
+    // Every PERSIST_SAVE_MINS, and right after the clock got stepped to server time
+    if(persistSecs >= PERSIST_SAVE_MINS * 60u)
+        persistDue = 1;
+#if NTP_ENABLE
+    if(ntpSteps != persistNtpSteps)
+    {
+        persistNtpSteps = ntpSteps;
+        persistDue = 1;
+    }
+#endif
+#endif
+    
+    if(latchMissed == 1) // the tubes didn't move, put the right time up asap
+    {
+        latchMissed = 0;
+        showPending = 1;
+    }
+    
+#if STREAM_ENABLE
+    // Anti-poisoning burst or crossfade for this second? (only when the tubes are up to date and nobody's editing)
+    if((currentMode == MODE_FREE_RUNNING) && (showPending == 0) && (streamState == STREAM_IDLE))
+    {
+#if SLOT_ENABLE
+        streamStopAt = slotDue(&myTime);
+        if(streamStopAt != 0)
         {
-            // Read the Encoder (might make it function-based later)
-            aState_curr = PORTCbits.RC4; // Encoder Channel A output
-
-            if(aState_curr != aState_prev) // Did a rotation occur?
-            {
-                adjustHours = myTime / 3600; // Starting point for Hours adjustment (find the current H1:H0)
-                
-                if(aState_curr != PORTCbits.RC3) // Compare Ch. A vs B, CW or CCW?, increment or decrement?
-                {
-                    adjustHours++;
-                    
-                    // weird case, "adjusting" a 0 to a 12 is done in sendDataOut()
-                    if(adjustHours >= 12) // want the incrementing to be cyclical
-                        adjustHours = 0;
-                }
-                else
-                {
-                    adjustHours--;
-                    
-                    // weird case again, if decrement lower than zero (rollover to high int value)
-                    if(adjustHours >= 13) // want the decrementing to be cyclical
-                        adjustHours = 11;
-                }
-
-                // could combine these next two lines together, but it's a little more clear this way
-                myTime = myTime - ((myTime / 3600)*3600); // subtract all the possible hours from the overall time
-                myTime = myTime + (adjustHours*3600);     // add back the new adjusted hours to the overall time
-                
-                sendDataOut();
-
-                // Latch everything out of the shift registers all at once
-                latchOutData();
-
-                aState_prev = aState_curr;
-            }
+#if TELEM_ENABLE
+            streamRan = STREAM_SLOT;
+            streamFrames = 0;
+            streamLongest = 0;
+#endif
+            streamState = STREAM_SLOT;  // frameService() keeps off the chain from here on
+            HAL_STREAM_START(SLOT_FRAME_HZ);
         }
-        
-        // User Set Mode: Adjust the Minutes Digits of the Clock
-        while(currentMode == MODE_EDIT_MINS)
+#endif
+#if FADE_ENABLE
+        // Only from exactly the second before (what the RCK just latched again)
+        if((streamState == STREAM_IDLE) && (secs == 1) && (fadeArmed == 1))
         {
-            // Read the Encoder (might make it function-based later)
-            aState_curr = PORTCbits.RC4; // Encoder Channel A output
+            fadeStart(&before, &myTime);
+#if TELEM_ENABLE
+            streamRan = STREAM_FADE;
+            streamFrames = 0;
+            streamLongest = 0;
+#endif
+            streamStopAt = TICK_SUBTICKS - 1;   // backstop, it stops itself after FADE_MS
+            streamState = STREAM_FADE;
+            HAL_STREAM_START(FADE_FRAME_HZ);
+            fadeArmed = 0;
+        }
+#endif
+    }
+#endif
+#if FADE_ENABLE
+    if(fadeArmed == 1)  // the RCK left the second before up and no fade is coming, the new one goes up now
+    {
+        fadeArmed = 0;
+        showPending = 1;
+    }
+#endif
+    
+    // Brightness, a level a second towards wherever DIM_MODE wants it
+#if (DIM_MODE == DIM_MODE_SCHEDULE) && NTP_ENABLE
+    dimSecond((unsigned char)(tzSecsOfDay(utcSecs) / 3600));   // local time, whatever the tubes are set to
+#else
+    dimSecond((unsigned char)(myTime.h1 * 10 + myTime.h0));
+#endif
+}
 
-            if(aState_curr != aState_prev) // Did a rotation occur?
-            {
-                adjustMins = (myTime / 60) % 60; // Starting point for Minutes adjustment  (find the current M1:M0)
-                
-                if(aState_curr != PORTCbits.RC3) // Compare Ch. A vs B, CW or CCW?, increment or decrement?
-                {
-                    adjustMins++;
-                    
-                    if(adjustMins >= 60) // want the incrementing to be cyclical
-                        adjustMins = 0;
-                }
-                else
-                {
-                    adjustMins--;
-                    
-                    if(adjustMins >= 60) // want the decrementing to be cyclical
-                        adjustMins = 59;
-                }
-
-                myTime = myTime - (((myTime / 60) % 60) * 60); // subtract all the possible minutes from the overall time
-                myTime = myTime + (adjustMins*60);           // add back the new adjusted minutes to the overall time
-                
-                sendDataOut();
-
-                // Latch everything out of the shift registers all at once
-                latchOutData();
+// EVT_BUTTON: cycle FREE --> HOURS --> MINS --> SECS --> FREE
+void onButton(void)
+{
+    currentMode++;
+    
+    if(currentMode >= 4)
+        currentMode = 0;
+    TELEM_MAIN(TELEM_MODE, currentMode, 0, 0);
+#if PERSIST_ENABLE
+    if(currentMode == MODE_FREE_RUNNING)
+        persistDue = 1;    // done editing, keep what got set
+#endif
+    
+#if STREAM_ENABLE
+    // Editing starts now, not after the burst
+    HAL_IRQ_OFF();
+    if((streamState == STREAM_SLOT) || (streamState == STREAM_FADE))
+        streamStop();
+    HAL_IRQ_ON();
+#endif
+    
+    encoderTake(); // forget anything turned in the last mode
+}
 
-                aState_prev = aState_curr;
-            }
-        }
-        
-        // User Set Mode: Adjust the Seconds Digits of the Clock
-        while(currentMode == MODE_EDIT_SECS)
-        {
-            // Read the Encoder (might make it function-based later)
-            aState_curr = PORTCbits.RC4; // Encoder Channel A output
+// EVT_ENCODER: adjust the digits of the mode we're in
+void onEncoder(void)
+{
+    signed char steps = encoderTake(); // detents (already accelerated), + = CW = increment
+    
+    if(steps != 0)
+        TELEM_MAIN(TELEM_ENCODER, (unsigned char)steps, currentMode, 0);
+    if((steps == 0) || (currentMode == MODE_FREE_RUNNING))
+        return; // knob does nothing in free running mode
+    
+    // Cyclical, only the selected digits change, no carry into anything else
+    for(; steps > 0; steps--)
+    {
+        if(currentMode == MODE_EDIT_HOURS)
+            timeIncHours(&myTime);
+        else if(currentMode == MODE_EDIT_MINS)
+            timeIncMins(&myTime);
+        else
+            timeIncSecs(&myTime);
+    }
+    for(; steps < 0; steps++)
+    {
+        if(currentMode == MODE_EDIT_HOURS)
+            timeDecHours(&myTime);
+        else if(currentMode == MODE_EDIT_MINS)
+            timeDecMins(&myTime);
+        else
+            timeDecSecs(&myTime);
+    }
+    
+    showPending = 1; // updates in real-time (as instant as possible)
+}
 
-            if(aState_curr != aState_prev) // Did a rotation occur?
-            {
-                adjustSecs = myTime % 60; // Starting point for Seconds adjustment  (find the current S1:S0)
-                
-                if(aState_curr != PORTCbits.RC3) // Compare Ch. A vs B, CW or CCW?, increment or decrement?
-                {
-                    adjustSecs++;
-                    
-                    if(adjustSecs >= 60) // want the incrementing to be cyclical
-                        adjustSecs = 0;
-                }
-                else
-                {
-                    adjustSecs--;
-                    
-                    if(adjustSecs >= 60) // want the decrementing to be cyclical
-                        adjustSecs = 59;
-                }
-
-                myTime = myTime - (myTime % 60);    // subtract all the possible seconds from the overall time
-                myTime = myTime + adjustSecs;       // add back the new adjusted seconds to the overall time
-                
-                sendDataOut();
-
-                // Latch everything out of the shift registers all at once
-                latchOutData();
+#if NTP_ENABLE
+// EVT_NET: hand whatever came in to the NTP client
+void onNet(void)
+{
+    unsigned char pkt[NTP_PACKET_BYTES];
+    unsigned char len = 0;
+    
+    while((len = halNetReceive(pkt, NTP_PACKET_BYTES)) != 0)
+        ntpReceive(pkt, len, ntpRxStamp);
+}
 
-                aState_prev = aState_curr;
-            }
-        }    
-    } // end of while(1)
-} // end of void main(void)
+// UTC right now, seconds + where we are inside the second (call with interrupts off)
+// Seconds the ISR counted but main() hasn't added yet count too, and the phase keeps
+// counting past a match the ISR hasn't taken yet (HAL_TICK_PHASE())
+// The middle of the current count, not its start, or every offset would read half a count (167us) high
+ntpStamp_t clockNow(void)
+{
+    uint32_t secs = utcSecs + (unsigned char)(ticksOwed - ticksDone);
+    unsigned long counts = subTickCounts + HAL_TICK_PHASE();
+    
+    return ((ntpStamp_t)secs << 32) + ((((ntpStamp_t)counts * 2 + 1) << 31) / TICK_COUNTS_PER_SEC);
+}
 
+ntpStamp_t ntpClockRead(void)
+{
+    ntpStamp_t t;
+    
+    HAL_IRQ_OFF();
+    t = clockNow();
+    HAL_IRQ_ON();
+    return t;
+}
 
+// First sync (or a hopeless clock): jump to the server's time. Seconds move, the sub-tick
+// count moves by whole sub-ticks, the timer itself keeps its phase (what's left, up to half a
+// sub-tick = 33ms, the NTP client slews out like any other offset)
+void ntpClockStep(long long ns)
+{
+    ntpStamp_t t;
+    uint32_t secs;
+    long counts;
+    
+    HAL_IRQ_OFF();
+    t = clockNow() + (ntpStamp_t)ntpNsToStamp(ns);
+    secs = (uint32_t)(t >> 32);
+    counts = (long)(((t & 0xFFFFFFFFULL) * TICK_COUNTS_PER_SEC) >> 32) - (long)HAL_TICK_PHASE() + TICK_PERIOD / 2;
+    if(counts < 0)
+    {
+        counts += TICK_COUNTS_PER_SEC;
+        secs--;
+    }
+    subTick = (unsigned char)(counts / TICK_PERIOD);
+    if(subTick >= TICK_SUBTICKS)
+    {
+        subTick -= TICK_SUBTICKS;
+        secs++;
+    }
+    subTickCounts = subTick * TICK_PERIOD;
+    utcSecs = secs;
+    ticksDone = ticksOwed;
+    latchMissed = 0;
+    HAL_IRQ_ON();
+    
+    tzLocate(secs);
+    timeSet(&myTime, tzSecsOfDay(secs));
+    showPending = 1;
+}
 
-// HIGH Priority Interrupt Service Routine
-void interrupt ISR_High(void)
+void ntpNetSend(const unsigned char *pkt)
+{
+    halNetSend(pkt, NTP_PACKET_BYTES);
+}
+#endif
+
+// After every event: start the next shift if the chain is free and something needs to go out
+void frameService(void)
 {
-    // Was the 1Hz TIMER0 interrupt triggered?
-    if((PIE0bits.TMR0IE == 1) && (PIR0bits.TMR0IF == 1))
+    if(spiBusy == 1)
+        return; // EVT_SPI_DONE brings us back here
+    
+#if STREAM_ENABLE
+    if((streamState == STREAM_SLOT) || (streamState == STREAM_FADE))
+        return; // the chain belongs to the Timer2 stream, streamStop() posts EVT_SPI_DONE when it's over
+    if(streamState == STREAM_DONE)
     {
-        // reload the preload value immediately, CRUCIAL!!!
-        TMR0H = 0x44; // preload value = 0x4480 (LOAD HIGH FIRST!!!)
-        TMR0L = 0x80; // preload value = 0x4480
+        // Last stream frame is up, the time goes back on now (a no-op after a whole crossfade,
+        // not after a burst or a fade cut short), the pipeline frame right behind it
+        streamState = STREAM_IDLE;
+        showPending = 1;
+        TELEM_MAIN(TELEM_STREAM, streamRan, streamFrames, streamLongest);
+    }
+#endif
     
-        // Latch everything out of the shift registers all at once
-        latchOutData();
-        
-        myTime++;
-        waitFlag = 0;
-        PIR0bits.TMR0IF = 0;  // Clear flag
+    if(showPending == 1)
+    {
+        // myTime changed under the pipeline, shift it in and latch it straight away
+        showPending = 0;
+        frameLive = 1;
+        sendDataOut(&myTime);
     }
+    else if((frameState == FRAME_EMPTY) && (ticksDone == ticksOwed))
+    {
+        // Only do if the last frame got latched, don't perform unnec. calculations
+        // Frame N+1 goes into the shift registers ~1sec ahead of its RCK
+        // (and not before onTick() caught myTime up: an RCK that lands while main() is busy, say
+        //  right after an edit's live frame, would otherwise get myTime + 1 of the second before)
+        nextTime = myTime;
+        timeTick(&nextTime);
+        frameLive = 0;
+#if FADE_ENABLE
+        // Fading into the next second: the RCK latches this one again and the fade takes it from there
+        // (onTick() starts it, or puts nextTime up as a live frame if it can't)
+        fadeArmed = (currentMode == MODE_FREE_RUNNING);
+#if SLOT_ENABLE
+        if(slotDue(&nextTime) != 0)
+            fadeArmed = 0;  // a burst instead
+#endif
+        if(fadeArmed == 1)
+        {
+            sendDataOut(&myTime);
+            return;
+        }
+#endif
+        sendDataOut(&nextTime);
+    }
+}
+
+
+
+// HIGH Priority Interrupt Service Routine
+HAL_ISR(ISR_High)
+{
+    unsigned char lag = 0;
+    unsigned int now = 0;
+#if STREAM_ENABLE
+    const unsigned char *frame;
+#endif
+#if TELEM_ENABLE
+    unsigned char missed = 0;
+#endif
     
-    // Was the PB Switch of the Encoder pushed?
-    if((PIE0bits.INTE == 1) && (PIR0bits.INTF == 1))
+    // Was the TIMER0 (15Hz sub-tick) interrupt triggered?
+    if(HAL_TICK_IRQ())
     {
-//        __delay_ms(10);
-        PIE0bits.TMR0IE = 0;   // temp. disable the timer0 interrupt
-        T0CON0bits.T0EN = 0;   // pause/stop timer0
-        PIR0bits.TMR0IF = 0;
+        subTick++;
+#if NTP_ENABLE
+        subTickCounts += subTickLen;
+#endif
         
+#if STREAM_ENABLE
+        // Anti-poisoning burst is over (never later than one sub-tick before the second boundary)
+        if(((streamState == STREAM_SLOT) || (streamState == STREAM_FADE)) && (subTick >= streamStopAt))
+            streamStop();
+#endif
         
-        currentMode++;
+        if(subTick >= TICK_SUBTICKS) // 15th match, this is the 1Hz second boundary
+        {
+            lag = HAL_TICK_LAG();  // TMR0 counts since the match (normally 0, see "Frame pipeline" notes up top)
         
-        if(currentMode >= 4)
-            currentMode = 0;
-
-        PIR0bits.INTF = 0;
+            // Latch everything out of the shift registers all at once
+            // (only if main() finished shifting the next frame in, never latch half a frame)
+            if(frameState == FRAME_READY)
+                latchOutData();
+            else
+            {
+                // A live frame (an edit) got the chain just before the boundary: the tubes show
+                // myTime, onTick() puts the new second up right after. Anything else is the pipeline late.
+                if(frameLive == 0)
+                    frameLate++;
+                latchMissed = 1;
+#if TELEM_ENABLE
+                missed = TELEM_TICK_MISSED;
+#endif
+            }
+#if TELEM_ENABLE
+            now = halTimerNow();   // the same few Tcy after the RCK every second
+#endif
+            
+            if(lag > latchLagMax)
+                latchLagMax = lag;
+            
+            subTick = 0;
+#if NTP_ENABLE
+            subTickCounts = 0;
+#endif
+            ticksOwed++;       // main() does the actual timeTick()
+            schedPost(EVT_TICK, halTimerNow());
+            tickTrimSecond();  // calibration, how many counts to add/drop over the next second
+            TELEM_ISR(TELEM_TICK, lag | missed, (unsigned char)now, (unsigned char)(now >> 8));
+        }
         
-        if(currentMode == MODE_FREE_RUNNING) // in free-running mode, want timer to increment clock normally at 1Hz
+        // Length of the sub-tick that just started, TMR0 already restarted from 0 on its own
+        // so this doesn't have to be quick, just done before TMR0L gets to 198 (~66ms)
+#if NTP_ENABLE
+        subTickLen = tickNextPeriod() + 1;
+        HAL_TICK_SET_PERIOD(subTickLen - 1);
+#else
+        HAL_TICK_SET_PERIOD(tickNextPeriod());
+#endif
+        HAL_TICK_ACK();  // Clear flag
+    }
+    
+#if SPI_USE_INTERRUPT
+    // Did the SPI finish shifting out a byte?
+    if(HAL_SPI_IRQ())
+    {
+        HAL_SPI_ACK();
+        (void)HAL_SPI_READ();  // dummy read clears BF (nothing comes back from the shift registers)
+        
+        if(spiTxCount != 0)
         {
-            // reload the preload value immediately, CRUCIAL!!!
-            TMR0H = 0x44; // preload value = 0x4480 (LOAD HIGH FIRST!!!)
-            TMR0L = 0x80; // preload value = 0x4480
-            PIE0bits.TMR0IE = 1;    // re-enable timer0 interrupt
-            T0CON0bits.T0EN = 1;    // restart timer0
-        }  
+            HAL_SPI_WRITE(*spiTxPtr); // feed the next byte, CPU is free again until it's out
+            spiTxPtr++;
+            spiTxCount--;
+        }
+        else
+            spiFrameDone();
+    }
+#endif
+    
+#if STREAM_ENABLE
+    // Stream frame due: shift the next one in, spiFrameDone() latches it as soon as it's in
+    // (the SPI is always free by now unless the frame rate is too fast for the SPI clock, skip one then)
+    if(HAL_STREAM_IRQ())
+    {
+        HAL_STREAM_ACK();
+        frame = 0;
+        if(spiBusy == 1)
+            streamSkipped++;
+#if SLOT_ENABLE
+        else if(streamState == STREAM_SLOT)
+            frame = slotNextFrame();
+#endif
+#if FADE_ENABLE
+        else if(streamState == STREAM_FADE)
+        {
+            frame = fadeNextFrame();    // 0 = the tubes already show the right one
+            if(fadeStep >= FADE_FRAMES)
+                streamStop();           // that was the last one (always the new second)
+        }
+#endif
+        if(frame != 0)
+        {
+            frameState = FRAME_SHIFTING;
+            frameLive = 1;
+            spiStartFrame(frame);
+        }
+    }
+#endif
+    
+    // Timer1 overflow, another 65,536 counts (170.7ms) went by
+    if(HAL_WRAP_IRQ())
+    {
+        HAL_WRAP_ACK();
+        timer1Wraps++;
+        powerWindow(currentMode); // book the window to whatever mode we're in
+    }
+    
+    // Did either encoder channel change?
+    if(HAL_ENCODER_IRQ())
+    {
+        HAL_ENCODER_ACK();
+        
+#if TELEM_ENABLE
+        if((spiBusy == 1) && (spiIrqs < TELEM_SHIFT_IRQS))
+            spiIrqs++;
+#endif
+        now = halTimerNow();
+        if(encoderEdge(HAL_ENCODER_AB(), now,
+                       (unsigned char)(timer1Wraps - encoderWraps)) == 1)
+            schedPost(EVT_ENCODER, now); // a whole detent, main() applies it
+        encoderWraps = timer1Wraps; // "Timer1 wrapped" is only about the time since this edge
+    }
+    
+    // Was the PB Switch of the Encoder pushed?
+    if(HAL_BUTTON_IRQ())
+    {
+        // Timer0 keeps running, the clock doesn't lose time while you edit
+        // main() changes the mode (onButton())
+        HAL_BUTTON_ACK();
+        schedPost(EVT_BUTTON, halTimerNow());
+#if TELEM_ENABLE
+        if((spiBusy == 1) && (spiIrqs < TELEM_SHIFT_IRQS))
+            spiIrqs++;
+#endif
+    }
+    
+#if NTP_ENABLE
+    // Time server answered, stamp it now (T4), main() does the rest (onNet())
+    if(HAL_NET_IRQ())
+    {
+        HAL_NET_ACK();
+        ntpRxStamp = clockNow();
+        schedPost(EVT_NET, halTimerNow());
+    }
+#endif
+    
+#if TELEM_ENABLE
+    // UART has room, main() was only waiting for that (idleNap()), it's awake now
+    if(HAL_UART_IRQ())
+    {
+        HAL_UART_ACK();
     }
+#endif
 }
 
-void sendDataOut(void)
+#if STREAM_ENABLE
+// End of a burst or a crossfade (ISR, or main() with interrupts off)
+// A stream frame may still be shifting, spiFrameDone() latches it as usual, main() takes it from there
+void streamStop(void)
 {
-    // Temp time calculation variables
-    unsigned int hours = 0;
-    unsigned int mins  = 0;
-    unsigned int secs  = 0;
-    unsigned int h1    = 0;
-    unsigned int h0    = 0;
-    unsigned int m1    = 0;
-    unsigned int m0    = 0;
-    unsigned int s1    = 0;
-    unsigned int s0    = 0;
-
-    // Vars for the final weird binary format for the shift registers 
-    unsigned int bin_hour1 = 0;
-    unsigned int bin_hour0 = 0;
-    unsigned int bin_min1  = 0;
-    unsigned int bin_min0  = 0;
-    unsigned int bin_sec1  = 0;
-    unsigned int bin_sec0  = 0;
-
-    // Disable external INT when doing stuff below so INT0 user switch
-    // doesn't interrupt during a crucial time
-    PIE0bits.INTE = 0;
-            
-    // STEP 1
-    // Split the myTime (total seconds) var into hours, minutes, seconds
-    // and then split each once more to extract the individual digits
-
-    if(myTime >= 43200) // 12 hours expressed in 43,200 seconds
-        myTime = 0;     // reset the clock counter var
-
-    // HH:MM:SS encoding (12-hour format, no AM/PM)
-    // H1 H0 : M1 M0 : S1 S0    (more detailed)
-
-    secs = myTime % 60;
-    s1 = secs / 10; 
-    s0 = secs % 10;
-
-    mins = (myTime / 60) % 60;
-    m1 = mins / 10;
-    m0 = mins % 10;
-
-    hours = myTime / 3600;
+    HAL_STREAM_STOP();
+    streamState = STREAM_DONE;
+    schedPost(EVT_SPI_DONE, halTimerNow());  // the chain is main()'s again (frameService())
+}
+#endif
 
-    if(hours == 0) //special case
-        hours = 12;
+#if PERSIST_ENABLE
+// Power-up, interrupts still off: the newest saved state back before the first frame goes out
+// (no RTC: the time it saved last, with one: plus however long the power was off)
+void persistRestore(void)
+{
+    persistState_t s;
+    unsigned char slot;
+#if PERSIST_WIDE
+    uint32_t off = 0;
+#endif
+#if TELEM_ENABLE
+    unsigned int took;
+#endif
+    
+    s.time = myTime;
+    s.synced = 0;
+    s.dimLevel = dimLevel;
+    s.trimPpb = 0;
+#if PERSIST_WIDE
+    s.utcSecs = 0;
+    s.rtcSecs = 0;
+#endif
+    slot = persistLoad(&s);
+    if(slot != PERSIST_NONE)
+    {
+        myTime = s.time;
+        dimLevel = s.dimLevel;  // dimInit() lights the tubes at it, no ramp up from full at night
+#if HAL_RTC
+        if((s.rtcSecs != 0) && ((int32_t)(HAL_RTC_SECS() - s.rtcSecs) > 0))
+            off = HAL_RTC_SECS() - s.rtcSecs;
+#endif
+#if NTP_ENABLE
+        ntpRestore(s.trimPpb, (unsigned char)(s.synced && HAL_RTC));
+        if(s.synced == 1)
+        {
+            utcSecs = s.utcSecs + off;
+            tzLocate(utcSecs);
+            timeSet(&myTime, tzSecsOfDay(utcSecs));
+        }
+        else if(off != 0)
+            timeSet(&myTime, timeSecs(&myTime) + off);
+#elif HAL_RTC
+        if(off != 0)
+            timeSet(&myTime, timeSecs(&myTime) + off);
+#endif
+    }
+#if TELEM_ENABLE
+    took = halTimerNow();  // Timer1 started in halInit()
+    telemPut(TELEM_RESTORE, slot, (unsigned char)took, (unsigned char)(took >> 8));
+#endif
+}
 
-    h1 = hours / 10;
-    h0 = hours % 10;
+// Main loop: a save that's due goes in at a quiet moment, the next second's frame already in the chain,
+// no stream, nobody editing, over a sub-tick before the RCK (the PIC's CPU, ISR and all, stalls
+// for the flash, the tick match that comes in meanwhile is just taken a few ms late)
+void persistService(void)
+{
+    persistState_t s;
+#if TELEM_ENABLE
+    unsigned int took;
+    unsigned char slot;
+#endif
+    
+    if((persistDue == 0) || (spiBusy == 1) || (frameState != FRAME_READY) || (showPending == 1)
+       || (currentMode != MODE_FREE_RUNNING) || (ticksDone != ticksOwed) || (subTick >= TICK_SUBTICKS - 1))
+        return;
+#if STREAM_ENABLE
+    if(streamState != STREAM_IDLE)
+        return;
+#endif
+    
+    s.time = myTime;
+    s.dimLevel = dimLevel;
+#if NTP_ENABLE
+    s.synced = ntpSynced;
+    s.trimPpb = ntpFreqPpb;
+    s.utcSecs = utcSecs;
+#else
+    s.synced = 0;
+    s.trimPpb = tickTrimPpb;
+#if PERSIST_WIDE
+    s.utcSecs = 0;
+#endif
+#endif
+#if PERSIST_WIDE
+    s.rtcSecs = HAL_RTC_SECS();
+#endif
+    
+#if TELEM_ENABLE
+    took = halTimerNow();
+    slot = persistSave(&s);
+    took = halTimerNow() - took;
+    TELEM_MAIN(TELEM_SAVE, slot, (unsigned char)took, (unsigned char)(took >> 8));
+#else
+    persistSave(&s);
+#endif
+    persistDue = 0;
+    persistSecs = 0;
+}
+#endif
 
-    // STEP 2
-    // Encode/format the above vars into the "odd" binary output for shift registers
-    // For each individual binary number, only a single bit may be HIGH (1)
+#if TELEM_ENABLE
+// Frame's in (spiFrameDone()): a record for a pipeline or live frame, a stream frame only goes into its summary
+void telemShiftDone(void)
+{
+    unsigned int took = halTimerNow() - spiStartedAt;
+    
+#if STREAM_ENABLE
+    if(streamState != STREAM_IDLE)
+    {
+        if(streamFrames != 255)
+            streamFrames++;
+        if(took > 255)
+            took = 255;
+        if(took > streamLongest)
+            streamLongest = (unsigned char)took;
+        return;
+    }
+#endif
+    
+#if SPI_USE_INTERRUPT
+    telemPut(TELEM_SHIFT, (unsigned char)took, (unsigned char)(took >> 8),
+             (frameLive ? TELEM_SHIFT_LIVE : TELEM_SHIFT_PIPELINE) | spiIrqs);   // SPI ISR
+#else
+    TELEM_MAIN(TELEM_SHIFT, (unsigned char)took, (unsigned char)(took >> 8),
+               (frameLive ? TELEM_SHIFT_LIVE : TELEM_SHIFT_PIPELINE) | spiIrqs); // main() spun on it
+#endif
+}
 
-    // 44-bit binary format for shift registers (H1H0:M1M0:S1S0): 
-    //      H1: 1,0   H0: 2,1-9,0,1   M1: 0-5   M0: 0-9   S1: 0-5   S0: 0-9
-    //         H1           H0           M1        M0        S1        S0
-    // (MSB)   xx       xxxxxxxxxx    xxxxxx   xxxxxxxxxx  xxxxxx  xxxxxxxxxx   (LSB)
+#if NTP_ENABLE
+// onTick(), after ntpSecond(): the offset of an update, if there was one, signed 24 bits, saturated
+void telemNtp(void)
+{
+    long long v;
+    unsigned char type = TELEM_NTP_SLEW;
+    
+    if(ntpUpdates == telemNtpUpdates)
+        return;
+    telemNtpUpdates = ntpUpdates;
+    v = ntpLastOffsetNs / 1000;             // us
+    if(ntpSteps != telemNtpSteps)
+    {
+        telemNtpSteps = ntpSteps;
+        type = TELEM_NTP_STEP;
+        v /= 1000;                          // ms
+    }
+    if(v > 0x7FFFFF)
+        v = 0x7FFFFF;
+    if(v < -0x7FFFFF)
+        v = -0x7FFFFF;
+    TELEM_MAIN(type, (unsigned char)v, (unsigned char)(v >> 8), (unsigned char)(v >> 16));
+}
+#endif
+#endif
 
-    //                          H1H0    H0      M1 |M0    M0     S1  |S0    S0
-    // More Detailed: (MSB) 0000xxxx xxxxxxxx xxxxxxxx xxxxxxxx xxxxxxxx xxxxxxxx  (LSB)
-    // Have to send out in 8-bit chunks
+// Build the frame for t and start shifting it in (spiBusy must be 0)
+void sendDataOut(const nixieTime_t *t)
+{
+    // Tell the 1Hz ISR the shift registers are being messed with
+    frameState = FRAME_SHIFTING;
+            
+    // t already holds the individual digits H1 H0 : M1 M0 : S1 S0
+    // (wrapping at 12 or 24 hours is handled by timeTick(), nothing to split up here)
+    //
+    // Encode/format the digits into the "odd" binary output for shift registers
+    // For each individual tube, only a single bit may be HIGH (1)
+    // All the encoding is precomputed lookup tables, no pow() (no soft-float on this PIC)
+    encodeFrame(nextFrame, t);
 
-    // Need to serially shift out this 44-bit number 8-bits at a time
+    // Need to serially shift out this FRAME_BITS number (44-bit on the v1 board, 45-bit for 24-hour,
+    // see Nixie_display.h) 8-bits at a time
     // Send out starting with the MSB side (hours side)
+    // (but not displayed yet, that's in the Timer ISR which calls latchOutData() and pulses the RCK pin,
+    //  or the SPI interrupt itself for a live frame, see spiFrameDone())
+    spiStartFrame(nextFrame);
+}
 
-    // encode and send data out serially 
-    // (but not displayed yet, that's in the Timer ISR which calls latchOutData() and pulses the RCK pin)
-    bin_hour1 = (unsigned int)pow(2,h1); //0-bit of shiftReg is connected to Nixie "0", and logically so on...
-    bin_hour0 = (unsigned int)pow(2,h0);
-    bin_min1  = (unsigned int)pow(2,m1);
-    bin_min0  = (unsigned int)pow(2,m0);
-    bin_sec1  = (unsigned int)pow(2,s1);
-    bin_sec0  = (unsigned int)pow(2,s0);
-
-    // might need to wrap this stuff with all interrupts disabled to be safe
-    SSP1BUF = 0b00001111 & (((bin_hour1<<2)&0b1100) | ((bin_hour0>>8)&0b11));
-    while(SSP1STATbits.BF == 0);
-
-    SSP1BUF = bin_hour0;
-    while(SSP1STATbits.BF == 0);
-
-    SSP1BUF = ((bin_min1<<2)&0b11111100) | ((bin_min0>>8)&0b11);
-    while(SSP1STATbits.BF == 0);
+// Nap in IDLE until the next interrupt, call with GIE = 0
+// With GIE off, an interrupt that fires between the caller's "anything to do?" check
+// and the SLEEP instruction still wakes the core (SLEEP becomes a NOP if a flag is
+// already up), it just gets serviced right after the nap when the caller sets GIE again
+void idleNap(void)
+{
+    powerAsleep(currentMode, (halTimerNow() - wakeStamp) & 0xFFFF);
+#if TELEM_ENABLE
+    if(telemPending())
+    {
+        HAL_UART_WAKE();    // more to send, back up as soon as the UART has room
+    }
+#endif
+    
+    HAL_IDLE();
+    
+    wakeStamp = halTimerNow();
+}
 
-    SSP1BUF = bin_min0;
-    while(SSP1STATbits.BF == 0);
+// Start clocking a whole frame out to the shift register chain
+// Only call when spiBusy == 0, and leave frame[] alone until it's 0 again
+#if !SPI_USE_INTERRUPT
+// The dummy read clears BF, otherwise the next byte doesn't wait for the shift
+// (FRAME_EACH_BYTE() puts them back to back, hence the ; after the while)
+#define SPI_SEND_BYTE(frame, i) do { HAL_SPI_WRITE((frame)[i]); HAL_SPI_WAIT(); (void)HAL_SPI_READ(); } while(0);
+#endif
 
-    SSP1BUF = ((bin_sec1<<2)&0b11111100) | ((bin_sec0>>8)&0b11);
-    while(SSP1STATbits.BF == 0);
+void spiStartFrame(const unsigned char *frame)
+{
+#if TELEM_ENABLE
+    spiStartedAt = halTimerNow();
+    spiIrqs = 0;
+#endif
+#if SPI_USE_INTERRUPT
+    // Load the first byte here, the SPI interrupt feeds the rest
+    spiTxPtr   = frame + 1;
+    spiTxCount = FRAME_BYTES - 1;
+    spiBusy    = 1;
+    HAL_SPI_WRITE(frame[0]);
+#else
+    // Old way, spin on BF for every byte (CPU does nothing else meanwhile)
+    // Unrolled to FRAME_BYTES straight sends, no loop counter between the bytes
+    spiBusy = 1;
+    FRAME_EACH_BYTE(SPI_SEND_BYTE, frame)
+    spiFrameDone();
+#endif
+}
 
-    SSP1BUF = bin_sec0;
-    while(SSP1STATbits.BF == 0);
+// Last bit of the frame is in the chain (SPI ISR, or spiStartFrame() in blocking mode)
+void spiFrameDone(void)
+{
+    spiBusy = 0;
     
-    // Re-Enable the external INT when waiting
-    PIE0bits.INTE = 1;
+    if(frameLive == 1)
+        latchOutData();           // it's myTime, show it now (--> FRAME_EMPTY)
+    else
+        frameState = FRAME_READY; // the next RCK pulse may show this frame
+#if TELEM_ENABLE
+    telemShiftDone();
+#endif
+    
+    schedPost(EVT_SPI_DONE, halTimerNow());
 }
 
 void latchOutData(void)
 {
-    // Disable external INT when doing stuff below so INT0 user switch
-    // doesn't interrupt during a crucial time
-    PIE0bits.INTE = 0;
-    
     // Pulse RCK, idle LOW then HIGH-LOW pulse
-    // fool around with how fast I can do this
     // Latch everything out of the shift registers all at once
-    RCK_Latch_Signal = 1;
-    __delay_ms(10);
-    RCK_Latch_Signal = 0;
+    //
+    // The TPIC6595 only needs RCK high for 40ns (tw, datasheet), one instruction
+    // is 325ns @ 12.288MHz, so the NOP already gives 650ns of margin.
+    // This gets called from the 1Hz ISR, so NO delays in here
+    // (it used to __delay_ms(10), which held off every other interrupt for 10ms each second)
+    HAL_RCK_HIGH();
+    HAL_RCK_HOLD();
+    HAL_RCK_LOW();
     
-    // Re-Enable the external INT when waiting
-    PIE0bits.INTE = 1;
+    // Whatever was in the shift registers is showing now, main() can shift in the next frame
+    frameState = FRAME_EMPTY;
 }
 
 // end of Nixie_main.c (peace)
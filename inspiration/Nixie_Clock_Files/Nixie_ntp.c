@@ -0,0 +1,295 @@
+/*
+ * File:        Nixie_ntp.c
+ * Compiler:    gcc (Linux host build)
+ *
+ * Info:    SNTP client, min-delay filter and FLL/PLL clock discipline (see Nixie_ntp.h)
+ */
+
+#include "Nixie_config.h"
+#include "Nixie_tick.h"
+#include "Nixie_ntp.h"
+
+#if NTP_ENABLE
+
+#define NS_PER_SEC          1000000000LL
+
+unsigned char ntpSynced = 0;
+long ntpFreqPpb = 0;
+long ntpPhasePpb = 0;
+long long ntpLastOffsetNs = 0;
+long long ntpLastDelayNs = 0;
+unsigned long ntpUpdates = 0;
+unsigned long ntpSteps = 0;
+
+static unsigned int pollLeft;       // seconds to the next burst
+static unsigned char burstLeft;     // requests of this burst still to send
+static unsigned char burstTimer;    // seconds to the next request of the burst (or to the end of it)
+static unsigned char inBurst;
+static unsigned char waiting;       // a request is out, sentT1 is its transmit stamp
+static ntpStamp_t sentT1;
+static unsigned int slewLeft;       // seconds ntpPhasePpb still applies
+static long long slewedNs;          // phase slewed out so far (running total)
+static unsigned long secsSinceUpdate;
+static unsigned char fllLeft;       // FLL updates still to go before the PLL takes over
+static unsigned char spike;         // the last update was way off and got ignored
+static unsigned char slewWhole;     // the last update's whole offset got slewed out (FLL can trust the next one)
+
+static unsigned char bestValid;     // best (shortest round trip) sample of this burst
+static long long bestOffsetNs;
+static long long bestDelayNs;
+static long long bestSlewedNs;      // slewedNs when it was taken
+
+static long long delayHistory[NTP_DELAY_HISTORY];  // best round trip of the last few bursts
+static unsigned char delayNext;
+
+long long ntpStampToNs(long long d)
+{
+    if(d < 0)
+        return -ntpStampToNs(-d);
+    return (d >> 32) * NS_PER_SEC + (long long)(((unsigned long long)(d & 0xFFFFFFFFLL) * NS_PER_SEC) >> 32);
+}
+
+long long ntpNsToStamp(long long ns)
+{
+    if(ns < 0)
+        return -ntpNsToStamp(-ns);
+    return ((ns / NS_PER_SEC) << 32) + (((ns % NS_PER_SEC) << 32) / NS_PER_SEC);
+}
+
+static void putStamp(unsigned char *p, ntpStamp_t t)
+{
+    unsigned char i;
+
+    for(i=0; i<8; i++)
+        p[i] = (unsigned char)(t >> (56 - 8 * i));
+}
+
+static ntpStamp_t getStamp(const unsigned char *p)
+{
+    ntpStamp_t t = 0;
+    unsigned char i;
+
+    for(i=0; i<8; i++)
+        t = (t << 8) | p[i];
+    return t;
+}
+
+static long clampPpb(long long v, long max)
+{
+    if(v > max)
+        return max;
+    if(v < -max)
+        return -max;
+    return (long)v;
+}
+
+// tickTrimPpb is + for a fast crystal (slows the clock), the discipline speeds it up with +
+// (a long write is atomic on both network targets, tickTrimSecond() reads it in the ISR)
+static void applyTrim(void)
+{
+    long trim = ntpFreqPpb;
+
+    if(slewLeft != 0)
+        trim += ntpPhasePpb;
+    tickTrimPpb = TICK_TRIM_PPB - clampPpb(trim, NTP_SLEW_MAX_PPB);
+}
+
+static void sendRequest(void)
+{
+    unsigned char pkt[NTP_PACKET_BYTES];
+    unsigned char i;
+
+    for(i=0; i<NTP_PACKET_BYTES; i++)
+        pkt[i] = 0;
+    pkt[0] = (0 << 6) | (4 << 3) | 3;   // no leap warning, version 4, client
+
+    // Our transmit time goes out in the transmit field, the server sends it back as the originate
+    // field, which is how a reply gets matched to its request
+    sentT1 = ntpClockRead();
+    putStamp(pkt + 40, sentT1);
+    waiting = 1;
+    ntpNetSend(pkt);
+}
+
+// End of a burst: discipline the clock with its best sample
+static void update(void)
+{
+    long long offset, filtered, slack;
+    long long minDelay = bestDelayNs;
+    unsigned char i;
+
+    if(bestValid == 0)
+        return; // every reply lost, try again next poll
+
+    // The clock kept slewing after the sample was taken, that part is already fixed
+    offset = bestOffsetNs - (slewedNs - bestSlewedNs);
+    ntpLastOffsetNs = offset;
+    ntpLastDelayNs = bestDelayNs;
+    ntpUpdates++;
+
+    // Every ns of round trip over the shortest one seen lately is queueing, on one leg or the other,
+    // so the offset could be out by up to half of it: only what's beyond that counts
+    // (stops the PLL chasing queueing noise, a real offset still gets through)
+    delayHistory[delayNext] = bestDelayNs;
+    delayNext = (unsigned char)((delayNext + 1) % NTP_DELAY_HISTORY);
+    for(i=0; i<NTP_DELAY_HISTORY; i++)
+        if((delayHistory[i] != 0) && (delayHistory[i] < minDelay))
+            minDelay = delayHistory[i];
+    slack = (bestDelayNs - minDelay) / 2;
+    if(offset > slack)
+        filtered = offset - slack;
+    else if(offset < -slack)
+        filtered = offset + slack;
+    else
+        filtered = 0;
+
+    if((ntpSynced == 0) || (offset > NTP_PANIC_NS) || (offset < -NTP_PANIC_NS))
+    {
+        ntpClockStep(offset);
+        ntpSteps++;
+        ntpSynced = 1;
+        slewLeft = 0;
+        slewWhole = 0;
+        fllLeft = NTP_FLL_UPDATES;
+        secsSinceUpdate = 0;
+        applyTrim();
+        return;
+    }
+
+    if(fllLeft != 0)
+    {
+        // FLL (right after a step): once a whole offset has been slewed out, all of the next one
+        // built up since, i.e. it's the frequency error times the interval, however big
+        if(slewWhole == 1)
+        {
+            ntpFreqPpb = clampPpb(ntpFreqPpb + filtered / (long long)secsSinceUpdate / NTP_FLL_GAIN, NTP_SLEW_MAX_PPB);
+            fllLeft--;
+        }
+        ntpPhasePpb = clampPpb(filtered / NTP_POLL_SECS, NTP_SLEW_MAX_PPB);
+        slewWhole = (ntpPhasePpb == filtered / NTP_POLL_SECS);
+    }
+    else if((filtered >= NTP_LOCK_NS) || (filtered <= -NTP_LOCK_NS))
+    {
+        // Way off: one of these is a spike (a burst that only got queued replies), ignore it,
+        // two in a row and the server really moved, slew it all out, learn nothing
+        if(spike == 0)
+        {
+            spike = 1;
+            secsSinceUpdate = 0;
+            return;
+        }
+        ntpPhasePpb = clampPpb(filtered / NTP_POLL_SECS, NTP_SLEW_MAX_PPB);
+    }
+    else
+    {
+        // PLL (type II): a share of the offset into the frequency, a share slewed out,
+        // jitter on single samples averages away over several polls
+        ntpFreqPpb = clampPpb(ntpFreqPpb + filtered / (long long)secsSinceUpdate / NTP_PLL_GAIN, NTP_SLEW_MAX_PPB);
+        ntpPhasePpb = clampPpb(filtered / NTP_PHASE_GAIN / NTP_POLL_SECS, NTP_SLEW_MAX_PPB);
+        spike = 0;
+    }
+    slewLeft = NTP_POLL_SECS;
+    secsSinceUpdate = 0;
+    applyTrim();
+}
+
+// Power-up with a saved state: the crystal error learned before the power went, and whether the
+// time it came back with is server time (kept by an RTC), then the first update only has to slew
+// (FLL again, the estimate could be stale)
+void ntpRestore(long freqPpb, unsigned char synced)
+{
+    ntpFreqPpb = clampPpb(freqPpb, NTP_SLEW_MAX_PPB);
+    if(synced == 1)
+    {
+        ntpSynced = 1;
+        slewWhole = 0;
+        fllLeft = NTP_FLL_UPDATES;
+    }
+}
+
+void ntpInit(void)
+{
+    pollLeft = 1;   // first burst right away
+    inBurst = 0;
+    waiting = 0;
+    slewLeft = 0;
+    slewedNs = 0;
+    secsSinceUpdate = 0;
+    applyTrim();
+}
+
+void ntpSecond(void)
+{
+    secsSinceUpdate++;
+
+    if(slewLeft != 0)
+    {
+        slewedNs += ntpPhasePpb;    // ppb for one second = ns
+        slewLeft--;
+        if(slewLeft == 0)
+            applyTrim();            // offset gone, back to the frequency estimate alone
+    }
+
+    if(inBurst == 0)
+    {
+        pollLeft--;
+        if(pollLeft != 0)
+            return;
+        inBurst = 1;
+        burstLeft = NTP_BURST;
+        burstTimer = 1;
+        bestValid = 0;
+    }
+
+    burstTimer--;
+    if(burstTimer != 0)
+        return;
+
+    if(burstLeft != 0)
+    {
+        burstLeft--;
+        burstTimer = NTP_BURST_GAP_SECS;    // also how long the last one gets to answer
+        sendRequest();
+        return;
+    }
+
+    waiting = 0;
+    inBurst = 0;
+    pollLeft = NTP_POLL_SECS;
+    update();
+}
+
+void ntpReceive(const unsigned char *pkt, unsigned char len, ntpStamp_t t4)
+{
+    ntpStamp_t t2, t3;
+    long long offset, delay;
+
+    if((waiting == 0) || (len < NTP_PACKET_BYTES))
+        return;
+    if(((pkt[0] & 7) != 4) || ((pkt[0] >> 6) == 3))
+        return; // not a server reply, or the server isn't synchronized itself
+    if((pkt[1] == 0) || (pkt[1] > 15))
+        return; // kiss-o'-death or a bad stratum
+    if(getStamp(pkt + 24) != sentT1)
+        return; // not the answer to the request that's out (late, duplicate or spoofed)
+    waiting = 0;
+
+    t2 = getStamp(pkt + 32);
+    t3 = getStamp(pkt + 40);
+
+    // Halves first, the first sync can be years off and the sum would overflow
+    offset = ntpStampToNs((long long)(t2 - sentT1) / 2 + (long long)(t3 - t4) / 2);
+    delay = ntpStampToNs((long long)(t4 - sentT1) - (long long)(t3 - t2));
+    if(delay < 0)
+        delay = 0;  // our clock only counts in 333us steps
+
+    if((bestValid == 0) || (delay < bestDelayNs))
+    {
+        bestValid = 1;
+        bestOffsetNs = offset;
+        bestDelayNs = delay;
+        bestSlewedNs = slewedNs;
+    }
+}
+
+#endif // NTP_ENABLE
@@ -0,0 +1,84 @@
+/*
+ * File:        Nixie_ntp.h
+ * Compiler:    gcc (Linux host build), not built for the PIC (no network)
+ *
+ * Info:    SNTP client and clock discipline.
+ *
+ *          Every NTP_POLL_SECS the client sends a burst of NTP_BURST requests, NTP_BURST_GAP_SECS
+ *          apart. Each reply gives an offset and a round trip delay:
+ *              offset = ((T2 - T1) + (T3 - T4)) / 2        delay = (T4 - T1) - (T3 - T2)
+ *          (T1 request sent, T2 server got it, T3 server answered, T4 answer got here)
+ *          Queueing only ever adds delay, and it's what skews the offset, so the sample with the
+ *          shortest round trip is the most honest one: only that one is used (min-delay filter).
+ *          It's then shrunk by half of however much its round trip is over the shortest of the last
+ *          NTP_DELAY_HISTORY bursts (that much could be queueing on one leg), and a single update
+ *          way out of line (over NTP_LOCK_NS) is taken for a spike and ignored, two in a row is real.
+ *
+ *          The offset is never fixed by moving the seconds. It goes into tickTrimPpb (Nixie_tick.h)
+ *          as a rate change, the tubes still tick exactly once a second, some seconds just
+ *          get a count (333us) longer or shorter:
+ *              ntpFreqPpb      crystal error estimate
+ *                              FLL for the first NTP_FLL_UPDATES after a step (offset / interval),
+ *                              then PLL (a 1/NTP_PLL_GAIN share of offset / interval)
+ *              ntpPhasePpb     slews the offset out over the next NTP_POLL_SECS
+ *                              (all of it in FLL mode, 1/NTP_PHASE_GAIN of it in PLL mode)
+ *          tickTrimPpb = TICK_TRIM_PPB - (ntpFreqPpb + ntpPhasePpb), the sum clamped to +/-NTP_SLEW_MAX_PPB
+ *          (500ppm = 0.5ms per second, 1.5 counts a second at most).
+ *
+ *          The only step is the very first sync (the tubes were showing a made up time anyway),
+ *          or an offset beyond NTP_PANIC_NS (the clock is hopelessly wrong, slewing it would take days).
+ *          The first step moves whole sub-ticks (1/15 sec), the leftover is slewed like any other offset.
+ *          The clock is read in whole counts, so with a perfect network it still wanders +/-1 count (333us).
+ *
+ *          After a power cut ntpRestore() puts back the saved ntpFreqPpb, and if an RTC kept the time
+ *          (HAL_RTC) the clock counts as synced already: the first offset gets slewed, not stepped.
+ *
+ *          Tested against a stand-in server with injected delay, jitter, loss and offset:
+ *          sim/ntp_harness.cpp (make -C sim ntp-check).
+ */
+
+#ifndef NIXIE_NTP_H
+#define NIXIE_NTP_H
+
+#include "Nixie_config.h"
+
+#if NTP_ENABLE
+
+typedef unsigned long long ntpStamp_t;  // NTP format: seconds since 1900 in the top 32 bits, fraction below
+
+#define NTP_PACKET_BYTES        48
+#define NTP_PORT                123
+#define NTP_BOOT_SECS           3976214400UL    // 2026-01-01 00:00:00 UTC, where the clock starts before a sync
+
+#define NTP_SLEW_MAX_PPB        500000L         // fastest slew, and the most ntpFreqPpb can ever take out
+#define NTP_DELAY_HISTORY       8               // bursts the shortest round trip is remembered over
+#define NTP_FLL_UPDATES         4               // frequency updates in FLL mode after a step
+#define NTP_FLL_GAIN            2               // FLL: offset / (secs x gain) goes into the frequency estimate
+#define NTP_PLL_GAIN            32              // PLL: same, much gentler
+#define NTP_PHASE_GAIN          4               // PLL: 1/gain of each offset gets slewed out
+#define NTP_LOCK_NS             20000000LL      // only offsets under 20ms are trusted for the frequency estimate
+#define NTP_PANIC_NS            (1000LL * 1000000000LL) // more than this off after the first sync: step
+
+extern unsigned char ntpSynced;         // 1 once the first reply set the clock
+extern long ntpFreqPpb;                 // + = the crystal is slow and the clock is being sped up
+extern long ntpPhasePpb;                // slew for the offset of the last update
+extern long long ntpLastOffsetNs;       // offset used by the last update (+ = the server is ahead)
+extern long long ntpLastDelayNs;        // its round trip
+extern unsigned long ntpUpdates;        // bursts that produced an update
+extern unsigned long ntpSteps;          // times the clock was stepped (1 after the first sync)
+
+// Provided by the application (Nixie_main_v3.c, or the test harness)
+ntpStamp_t ntpClockRead(void);                  // the clock right now, as UTC
+void ntpClockStep(long long ns);                // move the clock by ns (and the tubes with it)
+void ntpNetSend(const unsigned char *pkt);      // NTP_PACKET_BYTES to the server
+
+void ntpRestore(long freqPpb, unsigned char synced);    // before ntpInit(): what a saved state had (Nixie_persist.h)
+void ntpInit(void);
+void ntpSecond(void);                           // once for every second the clock counts
+void ntpReceive(const unsigned char *pkt, unsigned char len, ntpStamp_t t4);    // a reply, t4 = when it got here
+long long ntpStampToNs(long long d);            // a difference of two ntpStamp_t, in ns
+long long ntpNsToStamp(long long ns);           // and back
+
+#endif // NTP_ENABLE
+
+#endif // NIXIE_NTP_H
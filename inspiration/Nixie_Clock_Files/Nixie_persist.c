@@ -0,0 +1,169 @@
+/*
+ * File:        Nixie_persist.c
+ * Compiler:    XC8 v1.43
+ *
+ * Info:    Wear-levelled saved state in non-volatile memory (see Nixie_persist.h)
+ */
+
+#include "Nixie_config.h"
+#include "Nixie_hal.h"
+#include "Nixie_dim.h"
+#include "Nixie_persist.h"
+
+#if PERSIST_ENABLE
+
+unsigned long persistSaves = 0;
+unsigned int persistErases = 0;
+
+static unsigned char nextSlot = 0;      // where the next record goes
+static unsigned char nextSeq = 0;       // and its sequence number
+
+#if CLOCK_24_HOUR
+#define HOURS_FLAG              PERSIST_24_HOUR
+#else
+#define HOURS_FLAG              0
+#endif
+
+static unsigned char sum(const unsigned char *r)
+{
+    unsigned char i, s = 0;
+
+    for(i=0; i<PERSIST_RECORD_BYTES - 1; i++)
+        s += r[i];
+    return s;
+}
+
+static unsigned char valid(const unsigned char *r)
+{
+    return (unsigned char)((unsigned char)(sum(r) + r[PERSIST_RECORD_BYTES - 1]) == PERSIST_CHECK);
+}
+
+static unsigned char blank(const unsigned char *r)
+{
+    unsigned char i;
+
+    for(i=0; i<PERSIST_RECORD_BYTES; i++)
+        if(r[i] != 0xFF)
+            return 0;
+    return 1;
+}
+
+// Two BCD digits, tens no more than maxTens, 0 if it isn't
+static unsigned char bcd(unsigned char b, unsigned char maxTens, unsigned char *tens, unsigned char *units)
+{
+    if(((b >> 4) > maxTens) || ((b & 15) > 9))
+        return 0;
+    *tens = b >> 4;
+    *units = b & 15;
+    return 1;
+}
+
+static void unpack(const unsigned char *r, persistState_t *s)
+{
+    nixieTime_t t;
+    unsigned char h = r[1] & PERSIST_HOURS;
+    unsigned char hoursOk;
+
+    // The time only if it's the clock's own format and every digit is in range
+    hoursOk = ((r[1] & PERSIST_24_HOUR) == HOURS_FLAG) && bcd(h, 2, &t.h1, &t.h0);
+#if CLOCK_24_HOUR
+    hoursOk = hoursOk && (h <= 0x23);
+#else
+    hoursOk = hoursOk && (h >= 0x01) && (h <= 0x12);
+#endif
+    if(hoursOk && bcd(r[2], 5, &t.m1, &t.m0) && bcd(r[3], 5, &t.s1, &t.s0))
+        s->time = t;
+    s->synced = (unsigned char)((r[1] & PERSIST_SYNCED) != 0);
+    s->trimPpb = (long)(signed short)(r[4] | ((unsigned int)r[5] << 8)) * PERSIST_TRIM_UNIT;
+    if(r[6] <= DIM_LEVELS - 1)
+        s->dimLevel = r[6];
+#if PERSIST_WIDE
+    s->utcSecs = r[7] | ((uint32_t)r[8] << 8) | ((uint32_t)r[9] << 16) | ((uint32_t)r[10] << 24);
+    s->rtcSecs = r[11] | ((uint32_t)r[12] << 8) | ((uint32_t)r[13] << 16) | ((uint32_t)r[14] << 24);
+#endif
+}
+
+unsigned char persistLoad(persistState_t *s)
+{
+    unsigned char r[PERSIST_RECORD_BYTES];
+    unsigned char slot, best = PERSIST_NONE, bestSeq = 0;
+
+    for(slot=0; slot<PERSIST_SLOTS; slot++)
+    {
+        halNvRead((unsigned int)slot * PERSIST_RECORD_BYTES, r, PERSIST_RECORD_BYTES);
+        if(!valid(r))
+            continue;
+        if((best == PERSIST_NONE) || ((signed char)(r[0] - bestSeq) > 0))
+        {
+            best = slot;
+            bestSeq = r[0];
+        }
+    }
+    if(best == PERSIST_NONE)
+        return PERSIST_NONE;
+
+    halNvRead((unsigned int)best * PERSIST_RECORD_BYTES, r, PERSIST_RECORD_BYTES);
+    unpack(r, s);
+    nextSlot = (unsigned char)((best + 1 == PERSIST_SLOTS) ? 0 : best + 1);
+    nextSeq = (unsigned char)(bestSeq + 1);
+    return best;
+}
+
+unsigned char persistSave(const persistState_t *s)
+{
+    unsigned char r[PERSIST_RECORD_BYTES];
+    unsigned int at;
+    long trim = s->trimPpb / PERSIST_TRIM_UNIT;
+    unsigned char slot;
+
+    // A slot that should be blank but isn't: on to the next row, erasing it
+    at = (unsigned int)nextSlot * PERSIST_RECORD_BYTES;
+    if(at % HAL_NV_ROW_BYTES != 0)
+    {
+        halNvRead(at, r, PERSIST_RECORD_BYTES);
+        if(!blank(r))
+        {
+            at += HAL_NV_ROW_BYTES - at % HAL_NV_ROW_BYTES;
+            if(at == HAL_NV_BYTES)
+                at = 0;
+            nextSlot = (unsigned char)(at / PERSIST_RECORD_BYTES);
+        }
+    }
+    if(at % HAL_NV_ROW_BYTES == 0)
+    {
+        halNvErase(at);
+        persistErases++;
+    }
+
+    if(trim > 32767)
+        trim = 32767;
+    if(trim < -32767)
+        trim = -32767;
+    r[0] = nextSeq;
+    r[1] = (unsigned char)((s->time.h1 << 4) | s->time.h0 | HOURS_FLAG | (s->synced ? PERSIST_SYNCED : 0));
+    r[2] = (unsigned char)((s->time.m1 << 4) | s->time.m0);
+    r[3] = (unsigned char)((s->time.s1 << 4) | s->time.s0);
+    r[4] = (unsigned char)trim;
+    r[5] = (unsigned char)(trim >> 8);
+    r[6] = s->dimLevel;
+#if PERSIST_WIDE
+    r[7] = (unsigned char)s->utcSecs;
+    r[8] = (unsigned char)(s->utcSecs >> 8);
+    r[9] = (unsigned char)(s->utcSecs >> 16);
+    r[10] = (unsigned char)(s->utcSecs >> 24);
+    r[11] = (unsigned char)s->rtcSecs;
+    r[12] = (unsigned char)(s->rtcSecs >> 8);
+    r[13] = (unsigned char)(s->rtcSecs >> 16);
+    r[14] = (unsigned char)(s->rtcSecs >> 24);
+#endif
+    r[PERSIST_RECORD_BYTES - 1] = (unsigned char)(PERSIST_CHECK - sum(r));
+    halNvWrite(at, r, PERSIST_RECORD_BYTES);
+    persistSaves++;
+
+    slot = nextSlot;
+    nextSlot = (unsigned char)((slot + 1 == PERSIST_SLOTS) ? 0 : slot + 1);
+    nextSeq++;
+    return slot;
+}
+
+#endif // PERSIST_ENABLE
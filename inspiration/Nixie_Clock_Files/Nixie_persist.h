@@ -0,0 +1,97 @@
+/*
+ * File:        Nixie_persist.h
+ * Compiler:    XC8 v1.43
+ *
+ * Info:    Saved state for a cold start: the time on the tubes, the crystal trim and the
+ *          brightness go to non-volatile memory (HAL_NV_xxx, Nixie_hal.h) now and then, and at
+ *          power-up the newest good copy is back on the tubes with the very first frame,
+ *          before the tick has even started.
+ *
+ *          Records go round a ring of PERSIST_SLOTS, each one in the next slot, so the wear is
+ *          spread over the whole store. A row is erased when the ring gets to its first slot, never
+ *          before, the row before it (the newest records) is left alone. At power-up every slot is
+ *          read, the valid one with the newest sequence number wins (8-bit, compared mod 256, so
+ *          there can't be more than 128 slots), and saving carries on in the slot after it.
+ *          A slot that isn't blank when its turn comes (a write the power cut short) makes the
+ *          ring skip to the next row.
+ *
+ *          Record, bytes (on the PIC a byte per flash word):
+ *              0   sequence number
+ *              1   hours, BCD | PERSIST_24_HOUR | PERSIST_SYNCED
+ *              2   minutes, BCD
+ *              3   seconds, BCD
+ *              4,5 trim, ppb / PERSIST_TRIM_UNIT, signed (+/-524ppm)
+ *              6   brightness (dimLevel)
+ *              7   check: the record's bytes add up to PERSIST_CHECK (a blank slot, all 0xFF,
+ *                  and all 0 both fail it)
+ *          with NTP or an RTC (PERSIST_WIDE) 8 more bytes go in before the check:
+ *              7-10    utcSecs (NTP seconds)
+ *              11-14   HAL_RTC_SECS() when it was saved
+ *              15      check
+ *
+ *          What comes back:
+ *              PIC             the time saved last (no RTC, how long the power was off is anybody's guess),
+ *                              the brightness. Its trim is the build's own TICK_TRIM_PPB, nothing changes
+ *                              it at run time, the saved one is just a record of it.
+ *              with an RTC     the saved time plus however long the RTC says the power was off
+ *              with NTP        ntpFreqPpb (the crystal error it learned), and with an RTC as well the time
+ *                              counts as synced: the first reply slews what's left instead of stepping
+ *
+ *          Wear: each save writes one slot, a row is erased once per (row bytes / record bytes) saves,
+ *          so a row sees one erase per PERSIST_SLOTS saves. The PIC's SAF: 16 slots x 10k erase cycles
+ *          (datasheet minimum for its program flash, typically 100k) = 160k saves, hourly that's
+ *          ~18 years, every 10 minutes ~3.
+ */
+
+#ifndef NIXIE_PERSIST_H
+#define NIXIE_PERSIST_H
+
+#include "Nixie_config.h"
+#include "Nixie_hal.h"
+#include "Nixie_time.h"
+
+#if PERSIST_ENABLE
+
+#define PERSIST_WIDE            (NTP_ENABLE || HAL_RTC)
+#define PERSIST_RECORD_BYTES    (PERSIST_WIDE ? 16 : 8)
+#define PERSIST_SLOTS           (HAL_NV_BYTES / PERSIST_RECORD_BYTES)
+#define PERSIST_CHECK           0x5A
+#define PERSIST_TRIM_UNIT       16      // ppb
+#define PERSIST_NONE            0xFF    // persistLoad(): nothing saved
+
+#define PERSIST_24_HOUR         0x40    // record byte 1
+#define PERSIST_SYNCED          0x80
+#define PERSIST_HOURS           0x3F
+
+#if (PERSIST_SAVE_MINS < 1) || (PERSIST_SAVE_MINS > 1000)
+#error "PERSIST_SAVE_MINS: 1 to 1000"
+#endif
+#if (PERSIST_SLOTS > 128) || (HAL_NV_ROW_BYTES % PERSIST_RECORD_BYTES) || (HAL_NV_BYTES % HAL_NV_ROW_BYTES)
+#error "PERSIST: at most 128 slots, whole records in a row, whole rows in the store"
+#endif
+
+typedef struct
+{
+    nixieTime_t time;           // on the tubes
+    unsigned char synced;       // it's server time (NTP)
+    unsigned char dimLevel;
+    long trimPpb;               // tickTrimPpb, or ntpFreqPpb on a network clock
+#if PERSIST_WIDE
+    uint32_t utcSecs;
+    uint32_t rtcSecs;           // HAL_RTC_SECS() at the save, 0 = no RTC
+#endif
+} persistState_t;
+
+extern unsigned long persistSaves;      // since power-up
+extern unsigned int persistErases;
+
+// Fills in what the newest good record has (fields it can't vouch for are left alone, e.g. a
+// 12-hour time on a 24-hour build), returns its slot or PERSIST_NONE. Once, before the first save.
+unsigned char persistLoad(persistState_t *s);
+// Into the next slot, erasing its row first if it's the row's first slot. Stalls the CPU on the PIC
+// (a row erase + a row write, ~5ms), returns the slot it went in.
+unsigned char persistSave(const persistState_t *s);
+
+#endif // PERSIST_ENABLE
+
+#endif // NIXIE_PERSIST_H
@@ -0,0 +1,54 @@
+/*
+ * File:        Nixie_power.c
+ * Compiler:    XC8 v1.43
+ *
+ * Info:    Awake/idle duty cycle accounting (see Nixie_power.h)
+ *          The report functions divide, keep them out of the ISR and the tick path.
+ */
+
+#include "Nixie_hal.h"
+#include "Nixie_power.h"
+
+unsigned long powerAwake[POWER_MODES];
+unsigned long powerTotal[POWER_MODES];
+
+void powerAsleep(unsigned char mode, unsigned int awakeCounts)
+{
+    powerAwake[mode] += awakeCounts;
+}
+
+void powerWindow(unsigned char mode)
+{
+    powerTotal[mode] += POWER_WINDOW_COUNTS;
+}
+
+unsigned int powerDutyPermille(unsigned char mode)
+{
+    unsigned long awake, total;
+
+    // 32-bit counters the Timer1 ISR adds to, a byte at a time on this core: copy them in one go
+    HAL_IRQ_OFF();
+    awake = powerAwake[mode];
+    total = powerTotal[mode];
+    HAL_IRQ_ON();
+
+    if(total == 0)
+        return 0;
+    if(awake >= total) // awake time of the window still in progress
+        return 1000;
+
+    // scale both down first so awake x 1000 can't overflow 32 bits
+    while(total > 0x003FFFFFUL)
+    {
+        total >>= 1;
+        awake >>= 1;
+    }
+    return (unsigned int)((awake * 1000UL) / total);
+}
+
+unsigned int powerCurrentUa(unsigned char mode)
+{
+    unsigned long duty = powerDutyPermille(mode);
+
+    return (unsigned int)((duty * POWER_RUN_UA + (1000UL - duty) * POWER_IDLE_UA) / 1000UL);
+}
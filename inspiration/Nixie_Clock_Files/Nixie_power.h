@@ -0,0 +1,37 @@
+/*
+ * File:        Nixie_power.h
+ * Compiler:    XC8 v1.43
+ *
+ * Info:    Idle accounting for the Nixie clock.
+ *
+ *          main() puts the core in IDLE (SLEEP with CPUDOZEbits.IDLEN = 1) whenever
+ *          it has nothing to do. IDLE stops the CPU but keeps Fosc and all the
+ *          peripherals running, so Timer0 (the clock!), the MSSP and IOC carry on
+ *          and any of their interrupts wakes it back up straight away.
+ *          (Real SLEEP would stop the 12.288MHz crystal and Timer0 with it.)
+ *
+ *          Timer1 free runs at Fosc/4 / 8, so each of its overflows is a fixed
+ *          65,536 count (170.7ms) window. main() adds up how long it was awake
+ *          before every nap, the Timer1 overflow interrupt books the window to
+ *          the current mode. That gives the awake duty cycle per mode, and from
+ *          that an estimated MCU current for sizing the low-voltage rail.
+ */
+
+#ifndef NIXIE_POWER_H
+#define NIXIE_POWER_H
+
+#include "Nixie_config.h"
+
+#define POWER_MODES             4           // one slot per clock mode (MODE_FREE_RUNNING ... MODE_EDIT_SECS)
+#define POWER_WINDOW_COUNTS     65536UL     // Timer1 counts per overflow
+
+extern unsigned long powerAwake[POWER_MODES];   // Timer1 counts spent awake, per mode
+extern unsigned long powerTotal[POWER_MODES];   // Timer1 counts spent in total, per mode
+
+void powerAsleep(unsigned char mode, unsigned int awakeCounts); // main(), right before a nap
+void powerWindow(unsigned char mode);                           // Timer1 overflow ISR
+
+unsigned int powerDutyPermille(unsigned char mode);  // awake time in 1/1000ths (0-1000), main() with GIE on
+unsigned int powerCurrentUa(unsigned char mode);     // estimated average MCU current, in uA, same
+
+#endif // NIXIE_POWER_H
@@ -0,0 +1,35 @@
+/*
+ * File:        Nixie_sched.c
+ * Compiler:    XC8 v1.43
+ *
+ * Info:    Prioritized event scheduler (see Nixie_sched.h)
+ */
+
+#include "Nixie_sched.h"
+
+volatile unsigned char schedPending = 0;
+volatile unsigned int schedPostStamp[EVT_CLASSES];
+unsigned int schedLatencyMax[EVT_CLASSES];
+
+unsigned char schedNext(unsigned int now)
+{
+    unsigned char e = 0;
+    unsigned char mask = 1;
+    unsigned int latency = 0;
+
+    for(e=0; e<EVT_CLASSES; e++)
+    {
+        if(schedPending & mask)
+        {
+            schedPending &= (unsigned char)~mask;
+
+            latency = (now - schedPostStamp[e]) & 0xFFFF;
+            if(latency > schedLatencyMax[e])
+                schedLatencyMax[e] = latency;
+
+            return e;
+        }
+        mask <<= 1;
+    }
+    return EVT_NONE;
+}
@@ -0,0 +1,60 @@
+/*
+ * File:        Nixie_sched.h
+ * Compiler:    XC8 v1.43
+ *
+ * Info:    Run-to-completion event scheduler for main().
+ *
+ *          The ISR does the time critical part of everything (RCK pulse, SPI bytes,
+ *          quadrature decoding) and posts an event, main() picks the highest priority
+ *          pending event, runs its handler to completion, and naps when nothing is left.
+ *
+ *          The queue is fixed size: one pending bit per event class, no heap, no
+ *          function pointers. Events of the same class coalesce, whatever they carry
+ *          is counted elsewhere without locks (ticks in ticksOwed, detents in
+ *          encoderCount), so coalescing never loses anything.
+ *
+ *          Worst post --> dispatch latency per class, schedLatencyMax[] as the simulator measured it
+ *          (sim/, 12.288MHz, Tcy = 325ns, counted in Timer1 counts of 8 Tcy):
+ *                              make check          nixie_sim --fuzz 1 (make frame-check)
+ *              EVT_TICK        24 Tcy (7.8us)      24 Tcy
+ *              EVT_SPI_DONE    24 Tcy              24 Tcy
+ *              EVT_BUTTON       8 Tcy               8 Tcy
+ *              EVT_ENCODER      8 Tcy              56 Tcy (18us)
+ *              EVT_NET         not measured, no network on the PIC (on the network targets the
+ *                              packet's arrival time is stamped in the ISR, waiting here costs no accuracy)
+ *          make check is an hour with 4 button pushes and 5 knob turns (a 30 detent spin among them),
+ *          the fuzz run is 5 minutes of random pushes and turns at random speeds. The simulator only
+ *          charges time for SFR accesses, NOP() and interrupt entry/exit, not for the C in between
+ *          (see sim/nixie_sim.h), so these are lower bounds: a handler's own instructions come on top.
+ *          None of these are on the 1Hz latch deadline: the ISR pulses RCK by itself, main()
+ *          only has to get the next frame shifted in before the following second (~1sec of slack).
+ *          schedLatencyMax[] keeps the worst latency actually seen per class (Timer1 counts, 2.6us each),
+ *          keep an eye on it when adding handlers.
+ */
+
+#ifndef NIXIE_SCHED_H
+#define NIXIE_SCHED_H
+
+// Event classes, lower number = higher priority
+#define EVT_TICK        0   // 1Hz second boundary went by (RCK already pulsed by the ISR)
+#define EVT_SPI_DONE    1   // a frame finished shifting into the TPIC6595 chain
+#define EVT_BUTTON      2   // encoder push button pressed
+#define EVT_ENCODER     3   // encoder turned at least one detent
+#define EVT_NET         4   // a network packet came in (NTP_ENABLE targets only)
+#define EVT_CLASSES     5
+#define EVT_NONE        0xFF
+
+#define EVT_BIT(e)      (1 << (e))
+
+extern volatile unsigned char schedPending;             // one bit per event class
+extern volatile unsigned int schedPostStamp[EVT_CLASSES]; // Timer1 count when each class was last posted
+extern unsigned int schedLatencyMax[EVT_CLASSES];       // worst post --> dispatch seen, Timer1 counts
+
+// Post an event (e must be a constant, the OR then compiles to a single atomic BSF)
+#define schedPost(e, now)   do { schedPostStamp[e] = (now); schedPending |= EVT_BIT(e); } while(0)
+
+// main(): take the highest priority pending event, or EVT_NONE
+// Call with GIE = 0 (reads the stamps the ISR writes)
+unsigned char schedNext(unsigned int now);
+
+#endif // NIXIE_SCHED_H
@@ -0,0 +1,74 @@
+/*
+ * File:        Nixie_slot.c
+ * Compiler:    XC8 v1.43
+ *
+ * Info:    Cathode anti-poisoning frames and schedule (see Nixie_slot.h)
+ */
+
+#include "Nixie_config.h"
+#include "Nixie_tick.h"
+#include "Nixie_slot.h"
+#include "Nixie_display.h"
+
+#if SLOT_ENABLE
+
+#if (SLOT_BURST_SUBTICKS < 1) || (SLOT_BURST_SUBTICKS >= TICK_SUBTICKS)
+#error "SLOT_BURST_SUBTICKS: 1 to TICK_SUBTICKS-1, the last sub-tick of the second belongs to the time"
+#endif
+
+// Every tube's cathode count has to divide SLOT_FRAMES, or some cathodes get fewer turns
+#define SLOT_UNEVEN(name, n, shows, a)  || (SLOT_FRAMES % (n))
+#if (0 DISPLAY_FIELDS(SLOT_UNEVEN, 0))
+#error "SLOT_FRAMES: every field's cathode count (DISPLAY_FIELDS) has to divide it"
+#endif
+
+// Frame k: each reel at its own offset (its chain position, so they don't all roll in step),
+// each running through every cathode its tube has, neons just stay lit. Same byte layout as
+// encodeFrame() (see Nixie_frame.h), ki = (k, frame[] byte).
+#define SLOT_K(k, i)            (k)
+#define SLOT_I(k, i)            (i)
+#define SLOT_REEL(k, off, n)    (((k) + (off)) % (n))
+#define SLOT_BIT(name, n, shows, ki) \
+    | DISPLAY_BIT_IN(DISPLAY_##name##_AT + SLOT_REEL(SLOT_K ki, DISPLAY_##name##_AT, n), FRAME_INDEX(SLOT_I ki))
+#define SLOT_BYTE(k, i)         (0 DISPLAY_FIELDS(SLOT_BIT, (k, i))),
+#define SLOT_FRAME(k)           { FRAME_EACH_BYTE(SLOT_BYTE, k) }
+
+const unsigned char slotFrames[SLOT_FRAMES][FRAME_BYTES] =
+{
+    SLOT_FRAME(0),  SLOT_FRAME(1),  SLOT_FRAME(2),  SLOT_FRAME(3),  SLOT_FRAME(4),
+    SLOT_FRAME(5),  SLOT_FRAME(6),  SLOT_FRAME(7),  SLOT_FRAME(8),  SLOT_FRAME(9),
+    SLOT_FRAME(10), SLOT_FRAME(11), SLOT_FRAME(12), SLOT_FRAME(13), SLOT_FRAME(14),
+    SLOT_FRAME(15), SLOT_FRAME(16), SLOT_FRAME(17), SLOT_FRAME(18), SLOT_FRAME(19),
+    SLOT_FRAME(20), SLOT_FRAME(21), SLOT_FRAME(22), SLOT_FRAME(23), SLOT_FRAME(24),
+    SLOT_FRAME(25), SLOT_FRAME(26), SLOT_FRAME(27), SLOT_FRAME(28), SLOT_FRAME(29)
+};
+
+unsigned long slotFramesShown = 0;
+
+static unsigned char slotIndex = 0;     // carries on where the last burst stopped, so every frame gets its turn
+
+// Called once a second with the time that just went up, digits only (no divides)
+unsigned char slotDue(const nixieTime_t *t)
+{
+#if SLOT_WINDOW_MINS != 0
+    if((t->h1 == SLOT_WINDOW_HOUR / 10) && (t->h0 == SLOT_WINDOW_HOUR % 10) &&
+       ((unsigned char)(t->m1 * 10 + t->m0) < SLOT_WINDOW_MINS))
+        return TICK_SUBTICKS - 1;
+#endif
+    if((t->s1 == 0) && (t->s0 == 0))
+        return SLOT_BURST_SUBTICKS;
+    return 0;
+}
+
+const unsigned char *slotNextFrame(void)
+{
+    const unsigned char *f = slotFrames[slotIndex];
+
+    slotIndex++;
+    if(slotIndex >= SLOT_FRAMES)
+        slotIndex = 0;
+    slotFramesShown++;
+    return f;
+}
+
+#endif // SLOT_ENABLE
@@ -0,0 +1,52 @@
+/*
+ * File:        Nixie_slot.h
+ * Compiler:    XC8 v1.43
+ *
+ * Info:    Cathode anti-poisoning for the Nixie clock ("slot machine").
+ *
+ *          A cathode that never lights slowly gets coated by sputter from its busy
+ *          neighbours and stops glowing evenly (H1 is 1 most of the day, M1/S1 never
+ *          get past 5...). The cure is to light every cathode now and then, so the
+ *          tubes spin through SLOT_FRAMES precomputed frames, each one a different
+ *          cathode on every tube, SLOT_FRAME_HZ frames a second:
+ *              - for SLOT_BURST_SUBTICKS sub-ticks (1/15 sec each) at the top of every minute
+ *              - every second of the maintenance window, SLOT_WINDOW_HOUR:00 for SLOT_WINDOW_MINS
+ *                minutes (the hours as the tubes show them, so twice a day on a 12-hour clock),
+ *                all but the last sub-tick of each second
+ *          Only in free running mode, never while editing.
+ *
+ *          The frames are worked out by the compiler from DISPLAY_FIELDS and live in flash
+ *          (SLOT_FRAMES x FRAME_BYTES, 180 bytes on the v1 board), streaming one is just pointing
+ *          the SPI engine at it. Timer2 paces the stream (HAL_STREAM_xxx(), its interrupt shifts a
+ *          frame in, the SPI engine latches it the moment it's in, like a live frame, see "Frame
+ *          stream" in Nixie_frame.h), and each reel runs through all of its cathodes the same
+ *          number of times per SLOT_FRAMES (30 = every tube's cathode count divides it).
+ *
+ *          The 1Hz latch is never touched: a burst starts after the second's RCK (onTick()), and the
+ *          tick ISR stops it at sub-tick streamStopAt, at least one sub-tick (66ms) before the next
+ *          one. main() then shifts the real time back in (a live frame) and the next second behind
+ *          it (the pipeline frame), well under 1ms of SPI, so the next RCK edge shows exactly
+ *          the right time. The simulator checks all of that (make -C sim check / slot-check).
+ */
+
+#ifndef NIXIE_SLOT_H
+#define NIXIE_SLOT_H
+
+#include "Nixie_config.h"
+#include "Nixie_time.h"
+#include "Nixie_frame.h"
+
+#if SLOT_ENABLE
+
+#define SLOT_FRAMES         30
+
+extern const unsigned char slotFrames[SLOT_FRAMES][FRAME_BYTES];
+
+extern unsigned long slotFramesShown;   // frames streamed since reset
+
+unsigned char slotDue(const nixieTime_t *t);    // burst for the second t just started? 0 = no, else the stop sub-tick
+const unsigned char *slotNextFrame(void);       // ISR: next frame of the stream
+
+#endif // SLOT_ENABLE
+
+#endif // NIXIE_SLOT_H
@@ -0,0 +1,123 @@
+/*
+ * File:        Nixie_telem.c
+ * Compiler:    XC8 v1.43
+ *
+ * Info:    Telemetry ring and its UART drain (see Nixie_telem.h)
+ */
+
+#include "Nixie_config.h"
+#include "Nixie_hal.h"
+#include "Nixie_telem.h"
+
+#if TELEM_ENABLE
+
+static unsigned char telemRing[TELEM_RECORDS][TELEM_RECORD_BYTES];
+volatile unsigned char telemHead = 0;
+volatile unsigned char telemTail = 0;
+volatile unsigned char telemDropped = 0;
+
+static volatile unsigned char telemGap[TELEM_RECORDS];  // records lost right after the one in that slot
+static unsigned char dropNext = 0;      // TELEM_DROP to send before the next record
+static unsigned char txRecord[TELEM_RECORD_BYTES];  // record going out (its slot is already free again)
+static unsigned char txPos = 0;         // next byte of its frame, 0 = nothing started
+static unsigned char txSum;
+
+void telemInit(void)
+{
+    unsigned char opts = 0;
+
+#if CLOCK_24_HOUR
+    opts |= TELEM_OPT_24_HOUR;
+#endif
+#if SPI_USE_INTERRUPT
+    opts |= TELEM_OPT_SPI_IRQ;
+#endif
+#if NTP_ENABLE
+    opts |= TELEM_OPT_NTP;
+#endif
+#if SLOT_ENABLE
+    opts |= TELEM_OPT_SLOT;
+#endif
+#if FADE_ENABLE
+    opts |= TELEM_OPT_FADE;
+#endif
+#if PERSIST_ENABLE
+    opts |= TELEM_OPT_PERSIST;
+#endif
+    telemPut(TELEM_BOOT, TELEM_VERSION, opts, SPI_CLOCK_MODE);
+}
+
+void telemPut(unsigned char type, unsigned char d0, unsigned char d1, unsigned char d2)
+{
+    unsigned char head = telemHead;
+    unsigned char next = (unsigned char)((head + 1) & (TELEM_RECORDS - 1));
+    unsigned char *r;
+
+    if(next == telemTail)
+    {
+        // Full, the drain owns that slot. The loss goes after the newest record queued
+        telemDropped++;
+        head = (unsigned char)((head - 1) & (TELEM_RECORDS - 1));
+        if(telemGap[head] != 255)
+            telemGap[head]++;
+        return;
+    }
+    r = telemRing[head];
+    r[0] = type;
+    r[1] = d0;
+    r[2] = d1;
+    r[3] = d2;
+    telemGap[head] = 0;
+    telemHead = next;   // publish it, only now
+}
+
+unsigned char telemPending(void)
+{
+    return (txPos != 0) || (telemTail != telemHead) || (dropNext != 0);
+}
+
+void telemDrain(void)
+{
+    unsigned char tail, b, i;
+
+    while(HAL_UART_READY())
+    {
+        if(txPos == 0)
+        {
+            // Next frame: the records lost right after the last one sent, if any, then the ring
+            tail = telemTail;
+            if(dropNext != 0)
+            {
+                txRecord[0] = TELEM_DROP;
+                txRecord[1] = dropNext;
+                txRecord[2] = 0;
+                txRecord[3] = 0;
+                dropNext = 0;
+            }
+            else if(tail != telemHead)
+            {
+                for(i=0; i<TELEM_RECORD_BYTES; i++)
+                    txRecord[i] = telemRing[tail][i];
+                telemTail = (unsigned char)((tail + 1) & (TELEM_RECORDS - 1)); // slot's free for the ISR
+                dropNext = telemGap[tail];  // final now, nothing counts against a slot behind telemTail
+            }
+            else
+                return;
+            b = TELEM_FRAME_START;
+            txSum = 0;
+        }
+        else if(txPos == TELEM_FRAME_BYTES - 1)
+            b = (unsigned char)(0 - txSum);
+        else
+        {
+            b = txRecord[txPos - 1];
+            txSum += b;
+        }
+        HAL_UART_WRITE(b);
+        txPos++;
+        if(txPos == TELEM_FRAME_BYTES)
+            txPos = 0;
+    }
+}
+
+#endif // TELEM_ENABLE
@@ -0,0 +1,114 @@
+/*
+ * File:        Nixie_telem.h
+ * Compiler:    XC8 v1.43
+ *
+ * Info:    Timing telemetry for the Nixie clock.
+ *
+ *          The ISR (and main(), with interrupts off) drops 4-byte records into a RAM ring,
+ *          main() drains it out of a UART whenever it's between events, a byte whenever the
+ *          transmitter has room. TX only, 38400 8N1 (TELEM_BAUD):
+ *              PIC16F15325     EUSART TX on RA0 (the ICSPDAT pin, free once it's programmed)
+ *              Linux           appended to the file in NIXIE_TELEM, if it's set
+ *          sim/telem_decode turns the stream (a capture of the serial port, or nixie_sim --telem)
+ *          into histograms, make -C sim telem-check.
+ *
+ *          Ring: TELEM_RECORDS slots (a power of 2), one producer index (telemHead), one consumer
+ *          index (telemTail), both single bytes so reading either one can't tear. A record is written
+ *          first and only then published by moving telemHead, so the drain never sees half of one.
+ *          Producers are the ISR, or main() with interrupts off (TELEM_MAIN()), never both at once.
+ *          No locks anywhere else: a full ring drops the record and counts it against the newest
+ *          record still queued (telemGap), so the drain sends the TELEM_DROP right behind that one,
+ *          where the lost records belong in the stream.
+ *          (The drain reads the count only after it freed the slot: a producer never writes the slot
+ *          just behind telemTail, and never counts against it once the ring has room again.)
+ *          telemPut() is a few dozen instructions (by hand, the simulator doesn't count its RAM work), the tick
+ *          ISR calls it after the RCK, so the edge doesn't move.
+ *
+ *          On the wire every record is 6 bytes:
+ *              0x7E  type  d0  d1  d2  check       check = -(type + d0 + d1 + d2), so the 5 bytes sum to 0
+ *          No byte stuffing: a decoder that lands mid-stream (or on a 0x7E inside a record) slides
+ *          a byte at a time until the check adds up again.
+ *
+ *          Records (d0 d1 d2, 16-bit values low byte first):
+ *              TELEM_BOOT      TELEM_VERSION, option bits (TELEM_OPT_xxx), SPI_CLOCK_MODE
+ *              TELEM_TICK      TMR0 counts from the match to the RCK (| TELEM_TICK_MISSED: no frame was
+ *                              ready, nothing latched), Timer1 at the RCK (2.6us counts: the decoder gets
+ *                              the RCK to RCK period, i.e. the latch jitter, from consecutive ones)
+ *              TELEM_SHIFT     Timer1 counts from spiStartFrame() to the frame being in (latched, if it's
+ *                              live), TELEM_SHIFT_LIVE / _PIPELINE | button + encoder interrupts during it (0-63)
+ *              TELEM_STREAM    end of an anti-poisoning burst or a crossfade: STREAM_SLOT / STREAM_FADE,
+ *                              frames shifted (max 255), longest of them in Timer1 counts (max 255)
+ *              TELEM_MODE      the mode the button just put the clock in
+ *              TELEM_ENCODER   detents (accelerated, signed), mode
+ *              TELEM_NTP_SLEW  NTP update: offset in us (signed 24-bit, saturates at +/-8.3s)
+ *              TELEM_NTP_STEP  the clock was stepped: offset in ms (signed 24-bit, saturates)
+ *              TELEM_DROP      records lost to a full ring right here, between the record before it and
+ *                              the one after (saturates at 255)
+ *              TELEM_SAVE      state saved (Nixie_persist.h): slot, Timer1 counts it took (the CPU stall)
+ *              TELEM_RESTORE   power-up: slot the state came back from (PERSIST_NONE: nothing saved),
+ *                              Timer1 from halInit() to done
+ *          Stream frames (up to 1000 a second) only get the summary, a record each would swamp the UART.
+ */
+
+#ifndef NIXIE_TELEM_H
+#define NIXIE_TELEM_H
+
+#include "Nixie_config.h"
+#include "Nixie_hal.h"
+
+#define TELEM_VERSION       2
+#define TELEM_RECORD_BYTES  4
+#define TELEM_FRAME_BYTES   6
+#define TELEM_FRAME_START   0x7E
+
+#define TELEM_BOOT          0
+#define TELEM_TICK          1
+#define TELEM_SHIFT         2
+#define TELEM_STREAM        3
+#define TELEM_MODE          4
+#define TELEM_ENCODER       5
+#define TELEM_NTP_SLEW      6
+#define TELEM_NTP_STEP      7
+#define TELEM_DROP          8
+#define TELEM_SAVE          9
+#define TELEM_RESTORE       10
+#define TELEM_TYPES         11
+
+#define TELEM_TICK_MISSED   0x80    // TELEM_TICK d0
+#define TELEM_SHIFT_LIVE    0x40    // TELEM_SHIFT d2, top 2 bits
+#define TELEM_SHIFT_PIPELINE 0x00
+#define TELEM_SHIFT_IRQS    0x3F
+
+#define TELEM_OPT_24_HOUR   0x01    // TELEM_BOOT d1
+#define TELEM_OPT_SPI_IRQ   0x02
+#define TELEM_OPT_NTP       0x04
+#define TELEM_OPT_SLOT      0x08
+#define TELEM_OPT_FADE      0x10
+#define TELEM_OPT_PERSIST   0x20
+
+#if TELEM_ENABLE
+
+#if (TELEM_RECORDS & (TELEM_RECORDS - 1)) || (TELEM_RECORDS < 2) || (TELEM_RECORDS > 128)
+#error "TELEM_RECORDS: a power of 2, 2 to 128"
+#endif
+
+extern volatile unsigned char telemHead;    // next free slot (producers only)
+extern volatile unsigned char telemTail;    // oldest record not sent yet (telemDrain() only)
+extern volatile unsigned char telemDropped; // records lost to a full ring, all told (wraps)
+
+void telemInit(void);       // after halInit(), queues TELEM_BOOT
+void telemPut(unsigned char type, unsigned char d0, unsigned char d1, unsigned char d2);   // ISR / interrupts off
+void telemDrain(void);      // main(): as many bytes as the UART takes right now
+unsigned char telemPending(void);   // anything left to send (main(), before a nap)
+
+#define TELEM_ISR(t, a, b, c)   telemPut(t, a, b, c)
+#define TELEM_MAIN(t, a, b, c)  do { HAL_IRQ_OFF(); telemPut(t, a, b, c); HAL_IRQ_ON(); } while(0)
+
+#else
+
+#define TELEM_ISR(t, a, b, c)   do { } while(0)
+#define TELEM_MAIN(t, a, b, c)  do { } while(0)
+
+#endif // TELEM_ENABLE
+
+#endif // NIXIE_TELEM_H
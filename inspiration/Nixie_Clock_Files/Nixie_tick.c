@@ -0,0 +1,55 @@
+/*
+ * File:        Nixie_tick.c
+ * Compiler:    XC8 v1.43
+ *
+ * Info:    Fractional tick accumulator for the 1Hz clock (see Nixie_tick.h)
+ */
+
+#include "Nixie_config.h"
+#include "Nixie_tick.h"
+
+long tickTrimPpb = TICK_TRIM_PPB;
+signed char tickStretch = 0;
+
+static long tickAcc = 0;    // leftover fraction of a count, in 3 x ppb units
+
+void tickTrimSecond(void)
+{
+    long trim = tickTrimPpb;
+
+    if(trim > TICK_TRIM_MAX_PPB)
+        trim = TICK_TRIM_MAX_PPB;
+    if(trim < -TICK_TRIM_MAX_PPB)
+        trim = -TICK_TRIM_MAX_PPB;
+
+    // one second worth of error, in 1/3,000,000,000 sec units
+    tickAcc += 3 * trim;
+
+    // whole counts go out, the fraction stays for next time
+    tickStretch = 0;
+    while(tickAcc >= TICK_ACC_PER_COUNT)
+    {
+        tickAcc -= TICK_ACC_PER_COUNT;
+        tickStretch++;
+    }
+    while(tickAcc <= -TICK_ACC_PER_COUNT)
+    {
+        tickAcc += TICK_ACC_PER_COUNT;
+        tickStretch--;
+    }
+}
+
+unsigned char tickNextPeriod(void)
+{
+    if(tickStretch > 0)
+    {
+        tickStretch--;
+        return TICK_PERIOD;         // one count longer (crystal is fast)
+    }
+    if(tickStretch < 0)
+    {
+        tickStretch++;
+        return TICK_PERIOD - 2;     // one count shorter (crystal is slow)
+    }
+    return TICK_PERIOD - 1;
+}
@@ -0,0 +1,41 @@
+/*
+ * File:        Nixie_tick.h
+ * Compiler:    XC8 v1.43
+ *
+ * Info:    Drift-free 1Hz tick generation.
+ *
+ *          Timer0 runs in 8-bit compare mode: TMR0L counts, and when it matches
+ *          TMR0H the hardware clears it and raises TMR0IF. Nothing is reloaded
+ *          in software, so however late the ISR gets to it no counts are lost
+ *          (the old 16-bit preload method threw away every cycle between the
+ *          overflow and the reload, a different amount every second).
+ *
+ *          Fosc/4 = 3.072MHz, prescaler 1:1024 -> 3000 counts per second exactly
+ *          3000 counts = 15 sub-ticks of 200 counts (TMR0H = 199), the ISR counts
+ *          the sub-ticks and the 15th one is the second boundary.
+ *
+ *          Calibration: tickTrimPpb says how fast the crystal runs (in parts per
+ *          billion, + = fast). A Bresenham style accumulator turns that into whole
+ *          timer counts: one count is 1/3000 sec = 333,333.3ns, so adding
+ *          3 x trim every second and taking out 1,000,000 per count keeps it all
+ *          in exact integers, no rounding error ever builds up.
+ *          A count is added to (or taken off) one sub-tick at a time, so the
+ *          trim can go up to +/-15 counts per second = +/-5000ppm.
+ */
+
+#ifndef NIXIE_TICK_H
+#define NIXIE_TICK_H
+
+#define TICK_COUNTS_PER_SEC     3000        // TMR0 counts in one second (3.072MHz / 1024)
+#define TICK_SUBTICKS           15          // TMR0 matches per second
+#define TICK_PERIOD             200         // TMR0 counts per sub-tick (TMR0H = TICK_PERIOD - 1)
+#define TICK_ACC_PER_COUNT      1000000L    // accumulator units (3 x ppb) in one TMR0 count
+#define TICK_TRIM_MAX_PPB       5000000L    // +/-5000ppm, one count on every sub-tick
+
+extern long tickTrimPpb;            // crystal error to cancel, in ppb (+ = crystal fast)
+extern signed char tickStretch;     // counts still to add (+) or take off (-) this second
+
+void tickTrimSecond(void);          // once per second, works out this second's tickStretch
+unsigned char tickNextPeriod(void); // TMR0H value for the sub-tick that just started
+
+#endif // NIXIE_TICK_H
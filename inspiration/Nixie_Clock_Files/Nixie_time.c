@@ -0,0 +1,172 @@
+/*
+ * File:        Nixie_time.c
+ * Compiler:    XC8 v1.43
+ *
+ * Info:    Digit based (per-digit BCD) time core, see Nixie_time.h
+ */
+
+#include "Nixie_time.h"
+
+// Two digit 00-59 counter (mins or secs), returns 1 on the 59->00 wrap
+static unsigned char incBase60(unsigned char *tens, unsigned char *units)
+{
+    (*units)++;
+    if(*units < 10)
+        return 0;
+
+    *units = 0;
+    (*tens)++;
+    if(*tens < 6)
+        return 0;
+
+    *tens = 0;
+    return 1;
+}
+
+static void decBase60(unsigned char *tens, unsigned char *units)
+{
+    if(*units != 0)
+    {
+        (*units)--;
+        return;
+    }
+
+    *units = 9;
+    if(*tens != 0)
+        (*tens)--;
+    else
+        *tens = 5;  // 00 -> 59
+}
+
+void timeReset(nixieTime_t *t)
+{
+#if CLOCK_24_HOUR
+    t->h1 = 0;
+    t->h0 = 0;
+#else
+    t->h1 = 1; // a 12-hour clock starts at 12:00:00 (there is no 00 hour)
+    t->h0 = 2;
+#endif
+    t->m1 = 0;
+    t->m0 = 0;
+    t->s1 = 0;
+    t->s0 = 0;
+}
+
+void timeTick(nixieTime_t *t)
+{
+    if(incBase60(&t->s1, &t->s0))
+        if(incBase60(&t->m1, &t->m0))
+            timeIncHours(t);
+}
+
+// The one place that splits a count of seconds up, a network sync does it once,
+// never the tick path
+void timeSet(nixieTime_t *t, unsigned long secs)
+{
+    unsigned char h = (unsigned char)((secs / 3600) % 24);
+    unsigned char m = (unsigned char)((secs / 60) % 60);
+    unsigned char s = (unsigned char)(secs % 60);
+
+#if !CLOCK_24_HOUR
+    h %= 12;
+    if(h == 0)
+        h = 12;
+#endif
+    t->h1 = h / 10;
+    t->h0 = h % 10;
+    t->m1 = m / 10;
+    t->m0 = m % 10;
+    t->s1 = s / 10;
+    t->s0 = s % 10;
+}
+
+unsigned long timeSecs(const nixieTime_t *t)
+{
+    unsigned char h = (unsigned char)(t->h1 * 10 + t->h0);
+
+#if !CLOCK_24_HOUR
+    if(h == 12)
+        h = 0;
+#endif
+    return (unsigned long)h * 3600 + (t->m1 * 10 + t->m0) * 60 + t->s1 * 10 + t->s0;
+}
+
+unsigned char timeIncSecs(nixieTime_t *t)
+{
+    return incBase60(&t->s1, &t->s0);
+}
+
+unsigned char timeIncMins(nixieTime_t *t)
+{
+    return incBase60(&t->m1, &t->m0);
+}
+
+unsigned char timeIncHours(nixieTime_t *t)
+{
+#if CLOCK_24_HOUR
+    // 00, 01 ... 23, 00
+    t->h0++;
+    if((t->h1 == 2) && (t->h0 == 4))
+    {
+        t->h1 = 0;
+        t->h0 = 0;
+        return 1;
+    }
+#else
+    // 12, 01, 02 ... 11, 12 (the "12" is really hour 0 of the half day)
+    if((t->h1 == 1) && (t->h0 == 2))
+    {
+        t->h1 = 0;
+        t->h0 = 1;
+        return 0;
+    }
+    t->h0++;
+    if((t->h1 == 1) && (t->h0 == 2))
+        return 1;
+#endif
+    if(t->h0 >= 10)
+    {
+        t->h0 = 0;
+        t->h1++;
+    }
+    return 0;
+}
+
+void timeDecSecs(nixieTime_t *t)
+{
+    decBase60(&t->s1, &t->s0);
+}
+
+void timeDecMins(nixieTime_t *t)
+{
+    decBase60(&t->m1, &t->m0);
+}
+
+void timeDecHours(nixieTime_t *t)
+{
+#if CLOCK_24_HOUR
+    if((t->h1 == 0) && (t->h0 == 0)) // 00 -> 23
+    {
+        t->h1 = 2;
+        t->h0 = 3;
+        return;
+    }
+#else
+    if((t->h1 == 0) && (t->h0 == 1)) // 01 -> 12
+    {
+        t->h1 = 1;
+        t->h0 = 2;
+        return;
+    }
+#endif
+    if(t->h0 != 0)
+    {
+        t->h0--;
+    }
+    else
+    {
+        t->h0 = 9;
+        t->h1--;
+    }
+}
@@ -0,0 +1,46 @@
+/*
+ * File:        Nixie_time.h
+ * Compiler:    XC8 v1.43
+ *
+ * Info:    Division-free time keeping for the Nixie clock.
+ *          The time is kept as the six display digits (H1 H0 : M1 M0 : S1 S0)
+ *          instead of a count of seconds, so nothing ever has to be split
+ *          with / and % (this PIC has no hardware divider, each of those is
+ *          a long software loop).
+ *
+ *          A tick is a ripple-carry increment: S0 goes up, and only when it
+ *          wraps does S1 get touched, and so on. 59 times out of 60 that's
+ *          one increment and one compare.
+ */
+
+#ifndef NIXIE_TIME_H
+#define NIXIE_TIME_H
+
+#include "Nixie_config.h"
+
+typedef struct
+{
+    unsigned char h1;   // 12-hour: 0-1, 24-hour: 0-2
+    unsigned char h0;   // 0-9
+    unsigned char m1;   // 0-5
+    unsigned char m0;   // 0-9
+    unsigned char s1;   // 0-5
+    unsigned char s0;   // 0-9
+} nixieTime_t;
+
+void timeReset(nixieTime_t *t);         // 12:00:00 (12-hour) or 00:00:00 (24-hour)
+void timeTick(nixieTime_t *t);          // +1 second, carries into mins/hours
+void timeSet(nixieTime_t *t, unsigned long secs); // seconds since midnight (divides, only for a network sync)
+unsigned long timeSecs(const nixieTime_t *t);       // and back (multiplies, only for a restore, Nixie_persist.h)
+
+// Per-field adjust (used by the encoder edit modes and by timeTick())
+// The inc functions return 1 when the field wrapped around, but they never
+// carry into the next field themselves, so editing the minutes leaves the hours alone
+unsigned char timeIncSecs(nixieTime_t *t);
+unsigned char timeIncMins(nixieTime_t *t);
+unsigned char timeIncHours(nixieTime_t *t); // returns 1 going 11->12 (12-hour) or 23->00 (24-hour)
+void timeDecSecs(nixieTime_t *t);
+void timeDecMins(nixieTime_t *t);
+void timeDecHours(nixieTime_t *t);
+
+#endif // NIXIE_TIME_H
@@ -0,0 +1,70 @@
+/*
+ * File:        Nixie_tz.c
+ * Compiler:    gcc (Linux host build)
+ *
+ * Info:    Time zone / DST lookup over the generated transition table (see Nixie_tz.h)
+ */
+
+#include "Nixie_config.h"
+#include "Nixie_hal.h"
+#include "Nixie_tz.h"
+
+#if NTP_ENABLE
+
+#include "Nixie_tz_table.h"
+
+int32_t tzOffsetSecs = TZ_QUARTERS_START * 900L;
+uint32_t tzNextAt = TZ_EPOCH - 1;
+unsigned char tzIndex = 0;
+
+// tzIndex is the next transition, tzOffsetSecs whatever the one before it set
+static void tzLoad(void)
+{
+    if(tzIndex != 0)
+        tzOffsetSecs = HAL_FLASH_S8(&tzQuarters[tzIndex - 1]) * 900L;
+    else
+        tzOffsetSecs = TZ_QUARTERS_START * 900L;
+
+    if(tzIndex < TZ_COUNT)
+        tzNextAt = TZ_EPOCH + HAL_FLASH_U32(&tzAt[tzIndex]);
+    else
+        tzNextAt = TZ_EPOCH - 1;    // 136 years away, the last offset stays
+}
+
+void tzLocate(uint32_t utc)
+{
+    uint32_t t = utc - TZ_EPOCH;    // the table's seconds, right across the 2036 NTP era too
+    unsigned char lo = 0;
+    unsigned char hi = TZ_COUNT;
+    unsigned char mid;
+
+    // First entry still ahead of t
+    while(lo < hi)
+    {
+        mid = (unsigned char)((lo + hi) / 2);
+        if(HAL_FLASH_U32(&tzAt[mid]) <= t)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    tzIndex = lo;
+    tzLoad();
+}
+
+void tzAdvance(void)
+{
+    if(tzIndex < TZ_COUNT)
+        tzIndex++;
+    tzLoad();
+}
+
+uint32_t tzSecsOfDay(uint32_t utc)
+{
+    // Into the day first, so nothing overflows 32 bits near the end of the table either,
+    // then + a day so a west of UTC offset can't go under 0
+    int32_t secs = (int32_t)((uint32_t)(utc - TZ_EPOCH) % 86400UL);
+
+    return (uint32_t)((secs + 86400L + tzOffsetSecs) % 86400L);
+}
+
+#endif // NTP_ENABLE
@@ -0,0 +1,44 @@
+/*
+ * File:        Nixie_tz.h
+ * Compiler:    gcc (Linux host build), not built for the PIC (it never knows UTC)
+ *
+ * Info:    Time zone / DST for the network clock: UTC seconds (utcSecs) --> local seconds since midnight.
+ *
+ *          No rules at run time. sim/tzgen.c turns the zone rules into Nixie_tz_table.h at build time:
+ *          for the TZ_ZONE picked in Nixie_config.h, the sorted UTC times the offset changes at
+ *          (TZ_FIRST_YEAR to TZ_LAST_YEAR, 2 a year with DST) and the offset from each one on.
+ *          400 bytes of flash for a DST zone, 5 bytes for one without.
+ *
+ *          tzLocate(utc)   binary search (7 compares for 100 transitions), only after a step
+ *          tzAdvance()     the transition at tzNextAt just happened, O(1)
+ *          Every second in between costs one compare in onTick(): utcSecs == tzNextAt.
+ *          Past the end of the table the last offset just stays (and tzNextAt never comes).
+ *
+ *          Checked against the C library's zoneinfo for every transition in the table:
+ *          sim/tz_check.c (make -C sim tz-check), which also times the per-tick cost (make -C sim tz-bench).
+ */
+
+#ifndef NIXIE_TZ_H
+#define NIXIE_TZ_H
+
+#include <stdint.h>
+#include "Nixie_config.h"
+#include "Nixie_ntp.h"
+
+#if NTP_ENABLE
+
+#define TZ_EPOCH            ((uint32_t)NTP_BOOT_SECS)   // the table counts from here (2026-01-01 00:00 UTC)
+
+// All the UTC seconds are uint32_t, so they wrap in 2036 on every target, the Linux build (and
+// sim/tz_check) included, not just where unsigned long happens to be 32 bits
+extern int32_t tzOffsetSecs;            // local - UTC right now
+extern uint32_t tzNextAt;               // utcSecs of the next change (32-bit NTP seconds, wraps in 2036 like utcSecs)
+extern unsigned char tzIndex;           // table entry tzNextAt came from
+
+void tzLocate(uint32_t utc);            // after any jump in utcSecs
+void tzAdvance(void);                   // utcSecs just reached tzNextAt
+uint32_t tzSecsOfDay(uint32_t utc);     // local seconds since midnight (for timeSet())
+
+#endif // NTP_ENABLE
+
+#endif // NIXIE_TZ_H
@@ -0,0 +1,397 @@
+/*
+ * File:        Nixie_tz_table.h
+ * Compiler:    generated by sim/tzgen.c (make -C sim tz-table), don't edit
+ *
+ * Info:    UTC offset transitions 2026-2075 for every zone tzgen knows, one zone gets
+ *          compiled in (TZ_ZONE, Nixie_config.h). Times are UTC seconds since TZ_EPOCH
+ *          (2026-01-01 00:00 UTC), offsets are in quarter hours.
+ */
+
+#ifndef NIXIE_TZ_TABLE_H
+#define NIXIE_TZ_TABLE_H
+
+#define TZ_FIRST_YEAR   2026
+#define TZ_LAST_YEAR    2075
+
+#define TZ_UTC          0
+#define TZ_US_EASTERN   1
+#define TZ_US_CENTRAL   2
+#define TZ_US_MOUNTAIN  3
+#define TZ_US_ARIZONA   4
+#define TZ_US_PACIFIC   5
+#define TZ_US_ALASKA    6
+#define TZ_US_HAWAII    7
+#define TZ_EU_WESTERN   8
+#define TZ_EU_CENTRAL   9
+#define TZ_EU_EASTERN   10
+
+#if TZ_ZONE == TZ_UTC
+#define TZ_ZONE_NAME    "UTC"
+#define TZ_QUARTERS_START 0
+#define TZ_COUNT        0
+static const uint32_t tzAt[1] HAL_FLASH = { 0 };
+static const signed char tzQuarters[1] HAL_FLASH = { 0 };
+
+#elif TZ_ZONE == TZ_US_EASTERN
+#define TZ_ZONE_NAME    "America/New_York"
+#define TZ_QUARTERS_START -20
+#define TZ_COUNT        100
+static const uint32_t tzAt[TZ_COUNT] HAL_FLASH =
+{
+    5727600UL, 26287200UL, 37782000UL, 58341600UL,
+    69231600UL, 89791200UL, 100681200UL, 121240800UL,
+    132130800UL, 152690400UL, 163580400UL, 184140000UL,
+    195634800UL, 216194400UL, 227084400UL, 247644000UL,
+    258534000UL, 279093600UL, 289983600UL, 310543200UL,
+    321433200UL, 341992800UL, 352882800UL, 373442400UL,
+    384937200UL, 405496800UL, 416386800UL, 436946400UL,
+    447836400UL, 468396000UL, 479286000UL, 499845600UL,
+    510735600UL, 531295200UL, 542185200UL, 562744800UL,
+    574239600UL, 594799200UL, 605689200UL, 626248800UL,
+    637138800UL, 657698400UL, 668588400UL, 689148000UL,
+    700038000UL, 720597600UL, 732092400UL, 752652000UL,
+    763542000UL, 784101600UL, 794991600UL, 815551200UL,
+    826441200UL, 847000800UL, 857890800UL, 878450400UL,
+    889340400UL, 909900000UL, 921394800UL, 941954400UL,
+    952844400UL, 973404000UL, 984294000UL, 1004853600UL,
+    1015743600UL, 1036303200UL, 1047193200UL, 1067752800UL,
+    1079247600UL, 1099807200UL, 1110697200UL, 1131256800UL,
+    1142146800UL, 1162706400UL, 1173596400UL, 1194156000UL,
+    1205046000UL, 1225605600UL, 1236495600UL, 1257055200UL,
+    1268550000UL, 1289109600UL, 1299999600UL, 1320559200UL,
+    1331449200UL, 1352008800UL, 1362898800UL, 1383458400UL,
+    1394348400UL, 1414908000UL, 1425798000UL, 1446357600UL,
+    1457852400UL, 1478412000UL, 1489302000UL, 1509861600UL,
+    1520751600UL, 1541311200UL, 1552201200UL, 1572760800UL,
+};
+static const signed char tzQuarters[TZ_COUNT] HAL_FLASH =
+{
+    -16, -20, -16, -20, -16, -20, -16, -20, -16, -20, -16, -20, -16, -20, -16, -20,
+    -16, -20, -16, -20, -16, -20, -16, -20, -16, -20, -16, -20, -16, -20, -16, -20,
+    -16, -20, -16, -20, -16, -20, -16, -20, -16, -20, -16, -20, -16, -20, -16, -20,
+    -16, -20, -16, -20, -16, -20, -16, -20, -16, -20, -16, -20, -16, -20, -16, -20,
+    -16, -20, -16, -20, -16, -20, -16, -20, -16, -20, -16, -20, -16, -20, -16, -20,
+    -16, -20, -16, -20, -16, -20, -16, -20, -16, -20, -16, -20, -16, -20, -16, -20,
+    -16, -20, -16, -20,
+};
+
+#elif TZ_ZONE == TZ_US_CENTRAL
+#define TZ_ZONE_NAME    "America/Chicago"
+#define TZ_QUARTERS_START -24
+#define TZ_COUNT        100
+static const uint32_t tzAt[TZ_COUNT] HAL_FLASH =
+{
+    5731200UL, 26290800UL, 37785600UL, 58345200UL,
+    69235200UL, 89794800UL, 100684800UL, 121244400UL,
+    132134400UL, 152694000UL, 163584000UL, 184143600UL,
+    195638400UL, 216198000UL, 227088000UL, 247647600UL,
+    258537600UL, 279097200UL, 289987200UL, 310546800UL,
+    321436800UL, 341996400UL, 352886400UL, 373446000UL,
+    384940800UL, 405500400UL, 416390400UL, 436950000UL,
+    447840000UL, 468399600UL, 479289600UL, 499849200UL,
+    510739200UL, 531298800UL, 542188800UL, 562748400UL,
+    574243200UL, 594802800UL, 605692800UL, 626252400UL,
+    637142400UL, 657702000UL, 668592000UL, 689151600UL,
+    700041600UL, 720601200UL, 732096000UL, 752655600UL,
+    763545600UL, 784105200UL, 794995200UL, 815554800UL,
+    826444800UL, 847004400UL, 857894400UL, 878454000UL,
+    889344000UL, 909903600UL, 921398400UL, 941958000UL,
+    952848000UL, 973407600UL, 984297600UL, 1004857200UL,
+    1015747200UL, 1036306800UL, 1047196800UL, 1067756400UL,
+    1079251200UL, 1099810800UL, 1110700800UL, 1131260400UL,
+    1142150400UL, 1162710000UL, 1173600000UL, 1194159600UL,
+    1205049600UL, 1225609200UL, 1236499200UL, 1257058800UL,
+    1268553600UL, 1289113200UL, 1300003200UL, 1320562800UL,
+    1331452800UL, 1352012400UL, 1362902400UL, 1383462000UL,
+    1394352000UL, 1414911600UL, 1425801600UL, 1446361200UL,
+    1457856000UL, 1478415600UL, 1489305600UL, 1509865200UL,
+    1520755200UL, 1541314800UL, 1552204800UL, 1572764400UL,
+};
+static const signed char tzQuarters[TZ_COUNT] HAL_FLASH =
+{
+    -20, -24, -20, -24, -20, -24, -20, -24, -20, -24, -20, -24, -20, -24, -20, -24,
+    -20, -24, -20, -24, -20, -24, -20, -24, -20, -24, -20, -24, -20, -24, -20, -24,
+    -20, -24, -20, -24, -20, -24, -20, -24, -20, -24, -20, -24, -20, -24, -20, -24,
+    -20, -24, -20, -24, -20, -24, -20, -24, -20, -24, -20, -24, -20, -24, -20, -24,
+    -20, -24, -20, -24, -20, -24, -20, -24, -20, -24, -20, -24, -20, -24, -20, -24,
+    -20, -24, -20, -24, -20, -24, -20, -24, -20, -24, -20, -24, -20, -24, -20, -24,
+    -20, -24, -20, -24,
+};
+
+#elif TZ_ZONE == TZ_US_MOUNTAIN
+#define TZ_ZONE_NAME    "America/Denver"
+#define TZ_QUARTERS_START -28
+#define TZ_COUNT        100
+static const uint32_t tzAt[TZ_COUNT] HAL_FLASH =
+{
+    5734800UL, 26294400UL, 37789200UL, 58348800UL,
+    69238800UL, 89798400UL, 100688400UL, 121248000UL,
+    132138000UL, 152697600UL, 163587600UL, 184147200UL,
+    195642000UL, 216201600UL, 227091600UL, 247651200UL,
+    258541200UL, 279100800UL, 289990800UL, 310550400UL,
+    321440400UL, 342000000UL, 352890000UL, 373449600UL,
+    384944400UL, 405504000UL, 416394000UL, 436953600UL,
+    447843600UL, 468403200UL, 479293200UL, 499852800UL,
+    510742800UL, 531302400UL, 542192400UL, 562752000UL,
+    574246800UL, 594806400UL, 605696400UL, 626256000UL,
+    637146000UL, 657705600UL, 668595600UL, 689155200UL,
+    700045200UL, 720604800UL, 732099600UL, 752659200UL,
+    763549200UL, 784108800UL, 794998800UL, 815558400UL,
+    826448400UL, 847008000UL, 857898000UL, 878457600UL,
+    889347600UL, 909907200UL, 921402000UL, 941961600UL,
+    952851600UL, 973411200UL, 984301200UL, 1004860800UL,
+    1015750800UL, 1036310400UL, 1047200400UL, 1067760000UL,
+    1079254800UL, 1099814400UL, 1110704400UL, 1131264000UL,
+    1142154000UL, 1162713600UL, 1173603600UL, 1194163200UL,
+    1205053200UL, 1225612800UL, 1236502800UL, 1257062400UL,
+    1268557200UL, 1289116800UL, 1300006800UL, 1320566400UL,
+    1331456400UL, 1352016000UL, 1362906000UL, 1383465600UL,
+    1394355600UL, 1414915200UL, 1425805200UL, 1446364800UL,
+    1457859600UL, 1478419200UL, 1489309200UL, 1509868800UL,
+    1520758800UL, 1541318400UL, 1552208400UL, 1572768000UL,
+};
+static const signed char tzQuarters[TZ_COUNT] HAL_FLASH =
+{
+    -24, -28, -24, -28, -24, -28, -24, -28, -24, -28, -24, -28, -24, -28, -24, -28,
+    -24, -28, -24, -28, -24, -28, -24, -28, -24, -28, -24, -28, -24, -28, -24, -28,
+    -24, -28, -24, -28, -24, -28, -24, -28, -24, -28, -24, -28, -24, -28, -24, -28,
+    -24, -28, -24, -28, -24, -28, -24, -28, -24, -28, -24, -28, -24, -28, -24, -28,
+    -24, -28, -24, -28, -24, -28, -24, -28, -24, -28, -24, -28, -24, -28, -24, -28,
+    -24, -28, -24, -28, -24, -28, -24, -28, -24, -28, -24, -28, -24, -28, -24, -28,
+    -24, -28, -24, -28,
+};
+
+#elif TZ_ZONE == TZ_US_ARIZONA
+#define TZ_ZONE_NAME    "America/Phoenix"
+#define TZ_QUARTERS_START -28
+#define TZ_COUNT        0
+static const uint32_t tzAt[1] HAL_FLASH = { 0 };
+static const signed char tzQuarters[1] HAL_FLASH = { -28 };
+
+#elif TZ_ZONE == TZ_US_PACIFIC
+#define TZ_ZONE_NAME    "America/Los_Angeles"
+#define TZ_QUARTERS_START -32
+#define TZ_COUNT        100
+static const uint32_t tzAt[TZ_COUNT] HAL_FLASH =
+{
+    5738400UL, 26298000UL, 37792800UL, 58352400UL,
+    69242400UL, 89802000UL, 100692000UL, 121251600UL,
+    132141600UL, 152701200UL, 163591200UL, 184150800UL,
+    195645600UL, 216205200UL, 227095200UL, 247654800UL,
+    258544800UL, 279104400UL, 289994400UL, 310554000UL,
+    321444000UL, 342003600UL, 352893600UL, 373453200UL,
+    384948000UL, 405507600UL, 416397600UL, 436957200UL,
+    447847200UL, 468406800UL, 479296800UL, 499856400UL,
+    510746400UL, 531306000UL, 542196000UL, 562755600UL,
+    574250400UL, 594810000UL, 605700000UL, 626259600UL,
+    637149600UL, 657709200UL, 668599200UL, 689158800UL,
+    700048800UL, 720608400UL, 732103200UL, 752662800UL,
+    763552800UL, 784112400UL, 795002400UL, 815562000UL,
+    826452000UL, 847011600UL, 857901600UL, 878461200UL,
+    889351200UL, 909910800UL, 921405600UL, 941965200UL,
+    952855200UL, 973414800UL, 984304800UL, 1004864400UL,
+    1015754400UL, 1036314000UL, 1047204000UL, 1067763600UL,
+    1079258400UL, 1099818000UL, 1110708000UL, 1131267600UL,
+    1142157600UL, 1162717200UL, 1173607200UL, 1194166800UL,
+    1205056800UL, 1225616400UL, 1236506400UL, 1257066000UL,
+    1268560800UL, 1289120400UL, 1300010400UL, 1320570000UL,
+    1331460000UL, 1352019600UL, 1362909600UL, 1383469200UL,
+    1394359200UL, 1414918800UL, 1425808800UL, 1446368400UL,
+    1457863200UL, 1478422800UL, 1489312800UL, 1509872400UL,
+    1520762400UL, 1541322000UL, 1552212000UL, 1572771600UL,
+};
+static const signed char tzQuarters[TZ_COUNT] HAL_FLASH =
+{
+    -28, -32, -28, -32, -28, -32, -28, -32, -28, -32, -28, -32, -28, -32, -28, -32,
+    -28, -32, -28, -32, -28, -32, -28, -32, -28, -32, -28, -32, -28, -32, -28, -32,
+    -28, -32, -28, -32, -28, -32, -28, -32, -28, -32, -28, -32, -28, -32, -28, -32,
+    -28, -32, -28, -32, -28, -32, -28, -32, -28, -32, -28, -32, -28, -32, -28, -32,
+    -28, -32, -28, -32, -28, -32, -28, -32, -28, -32, -28, -32, -28, -32, -28, -32,
+    -28, -32, -28, -32, -28, -32, -28, -32, -28, -32, -28, -32, -28, -32, -28, -32,
+    -28, -32, -28, -32,
+};
+
+#elif TZ_ZONE == TZ_US_ALASKA
+#define TZ_ZONE_NAME    "America/Anchorage"
+#define TZ_QUARTERS_START -36
+#define TZ_COUNT        100
+static const uint32_t tzAt[TZ_COUNT] HAL_FLASH =
+{
+    5742000UL, 26301600UL, 37796400UL, 58356000UL,
+    69246000UL, 89805600UL, 100695600UL, 121255200UL,
+    132145200UL, 152704800UL, 163594800UL, 184154400UL,
+    195649200UL, 216208800UL, 227098800UL, 247658400UL,
+    258548400UL, 279108000UL, 289998000UL, 310557600UL,
+    321447600UL, 342007200UL, 352897200UL, 373456800UL,
+    384951600UL, 405511200UL, 416401200UL, 436960800UL,
+    447850800UL, 468410400UL, 479300400UL, 499860000UL,
+    510750000UL, 531309600UL, 542199600UL, 562759200UL,
+    574254000UL, 594813600UL, 605703600UL, 626263200UL,
+    637153200UL, 657712800UL, 668602800UL, 689162400UL,
+    700052400UL, 720612000UL, 732106800UL, 752666400UL,
+    763556400UL, 784116000UL, 795006000UL, 815565600UL,
+    826455600UL, 847015200UL, 857905200UL, 878464800UL,
+    889354800UL, 909914400UL, 921409200UL, 941968800UL,
+    952858800UL, 973418400UL, 984308400UL, 1004868000UL,
+    1015758000UL, 1036317600UL, 1047207600UL, 1067767200UL,
+    1079262000UL, 1099821600UL, 1110711600UL, 1131271200UL,
+    1142161200UL, 1162720800UL, 1173610800UL, 1194170400UL,
+    1205060400UL, 1225620000UL, 1236510000UL, 1257069600UL,
+    1268564400UL, 1289124000UL, 1300014000UL, 1320573600UL,
+    1331463600UL, 1352023200UL, 1362913200UL, 1383472800UL,
+    1394362800UL, 1414922400UL, 1425812400UL, 1446372000UL,
+    1457866800UL, 1478426400UL, 1489316400UL, 1509876000UL,
+    1520766000UL, 1541325600UL, 1552215600UL, 1572775200UL,
+};
+static const signed char tzQuarters[TZ_COUNT] HAL_FLASH =
+{
+    -32, -36, -32, -36, -32, -36, -32, -36, -32, -36, -32, -36, -32, -36, -32, -36,
+    -32, -36, -32, -36, -32, -36, -32, -36, -32, -36, -32, -36, -32, -36, -32, -36,
+    -32, -36, -32, -36, -32, -36, -32, -36, -32, -36, -32, -36, -32, -36, -32, -36,
+    -32, -36, -32, -36, -32, -36, -32, -36, -32, -36, -32, -36, -32, -36, -32, -36,
+    -32, -36, -32, -36, -32, -36, -32, -36, -32, -36, -32, -36, -32, -36, -32, -36,
+    -32, -36, -32, -36, -32, -36, -32, -36, -32, -36, -32, -36, -32, -36, -32, -36,
+    -32, -36, -32, -36,
+};
+
+#elif TZ_ZONE == TZ_US_HAWAII
+#define TZ_ZONE_NAME    "Pacific/Honolulu"
+#define TZ_QUARTERS_START -40
+#define TZ_COUNT        0
+static const uint32_t tzAt[1] HAL_FLASH = { 0 };
+static const signed char tzQuarters[1] HAL_FLASH = { -40 };
+
+#elif TZ_ZONE == TZ_EU_WESTERN
+#define TZ_ZONE_NAME    "Europe/London"
+#define TZ_QUARTERS_START 0
+#define TZ_COUNT        100
+static const uint32_t tzAt[TZ_COUNT] HAL_FLASH =
+{
+    7520400UL, 25664400UL, 38970000UL, 57718800UL,
+    70419600UL, 89168400UL, 101869200UL, 120618000UL,
+    133923600UL, 152067600UL, 165373200UL, 183517200UL,
+    196822800UL, 215571600UL, 228272400UL, 247021200UL,
+    259722000UL, 278470800UL, 291171600UL, 309920400UL,
+    323226000UL, 341370000UL, 354675600UL, 372819600UL,
+    386125200UL, 404874000UL, 417574800UL, 436323600UL,
+    449024400UL, 467773200UL, 481078800UL, 499222800UL,
+    512528400UL, 530672400UL, 543978000UL, 562122000UL,
+    575427600UL, 594176400UL, 606877200UL, 625626000UL,
+    638326800UL, 657075600UL, 670381200UL, 688525200UL,
+    701830800UL, 719974800UL, 733280400UL, 752029200UL,
+    764730000UL, 783478800UL, 796179600UL, 814928400UL,
+    828234000UL, 846378000UL, 859683600UL, 877827600UL,
+    891133200UL, 909277200UL, 922582800UL, 941331600UL,
+    954032400UL, 972781200UL, 985482000UL, 1004230800UL,
+    1017536400UL, 1035680400UL, 1048986000UL, 1067130000UL,
+    1080435600UL, 1099184400UL, 1111885200UL, 1130634000UL,
+    1143334800UL, 1162083600UL, 1174784400UL, 1193533200UL,
+    1206838800UL, 1224982800UL, 1238288400UL, 1256432400UL,
+    1269738000UL, 1288486800UL, 1301187600UL, 1319936400UL,
+    1332637200UL, 1351386000UL, 1364691600UL, 1382835600UL,
+    1396141200UL, 1414285200UL, 1427590800UL, 1445734800UL,
+    1459040400UL, 1477789200UL, 1490490000UL, 1509238800UL,
+    1521939600UL, 1540688400UL, 1553994000UL, 1572138000UL,
+};
+static const signed char tzQuarters[TZ_COUNT] HAL_FLASH =
+{
+    4, 0, 4, 0, 4, 0, 4, 0, 4, 0, 4, 0, 4, 0, 4, 0,
+    4, 0, 4, 0, 4, 0, 4, 0, 4, 0, 4, 0, 4, 0, 4, 0,
+    4, 0, 4, 0, 4, 0, 4, 0, 4, 0, 4, 0, 4, 0, 4, 0,
+    4, 0, 4, 0, 4, 0, 4, 0, 4, 0, 4, 0, 4, 0, 4, 0,
+    4, 0, 4, 0, 4, 0, 4, 0, 4, 0, 4, 0, 4, 0, 4, 0,
+    4, 0, 4, 0, 4, 0, 4, 0, 4, 0, 4, 0, 4, 0, 4, 0,
+    4, 0, 4, 0,
+};
+
+#elif TZ_ZONE == TZ_EU_CENTRAL
+#define TZ_ZONE_NAME    "Europe/Berlin"
+#define TZ_QUARTERS_START 4
+#define TZ_COUNT        100
+static const uint32_t tzAt[TZ_COUNT] HAL_FLASH =
+{
+    7520400UL, 25664400UL, 38970000UL, 57718800UL,
+    70419600UL, 89168400UL, 101869200UL, 120618000UL,
+    133923600UL, 152067600UL, 165373200UL, 183517200UL,
+    196822800UL, 215571600UL, 228272400UL, 247021200UL,
+    259722000UL, 278470800UL, 291171600UL, 309920400UL,
+    323226000UL, 341370000UL, 354675600UL, 372819600UL,
+    386125200UL, 404874000UL, 417574800UL, 436323600UL,
+    449024400UL, 467773200UL, 481078800UL, 499222800UL,
+    512528400UL, 530672400UL, 543978000UL, 562122000UL,
+    575427600UL, 594176400UL, 606877200UL, 625626000UL,
+    638326800UL, 657075600UL, 670381200UL, 688525200UL,
+    701830800UL, 719974800UL, 733280400UL, 752029200UL,
+    764730000UL, 783478800UL, 796179600UL, 814928400UL,
+    828234000UL, 846378000UL, 859683600UL, 877827600UL,
+    891133200UL, 909277200UL, 922582800UL, 941331600UL,
+    954032400UL, 972781200UL, 985482000UL, 1004230800UL,
+    1017536400UL, 1035680400UL, 1048986000UL, 1067130000UL,
+    1080435600UL, 1099184400UL, 1111885200UL, 1130634000UL,
+    1143334800UL, 1162083600UL, 1174784400UL, 1193533200UL,
+    1206838800UL, 1224982800UL, 1238288400UL, 1256432400UL,
+    1269738000UL, 1288486800UL, 1301187600UL, 1319936400UL,
+    1332637200UL, 1351386000UL, 1364691600UL, 1382835600UL,
+    1396141200UL, 1414285200UL, 1427590800UL, 1445734800UL,
+    1459040400UL, 1477789200UL, 1490490000UL, 1509238800UL,
+    1521939600UL, 1540688400UL, 1553994000UL, 1572138000UL,
+};
+static const signed char tzQuarters[TZ_COUNT] HAL_FLASH =
+{
+    8, 4, 8, 4, 8, 4, 8, 4, 8, 4, 8, 4, 8, 4, 8, 4,
+    8, 4, 8, 4, 8, 4, 8, 4, 8, 4, 8, 4, 8, 4, 8, 4,
+    8, 4, 8, 4, 8, 4, 8, 4, 8, 4, 8, 4, 8, 4, 8, 4,
+    8, 4, 8, 4, 8, 4, 8, 4, 8, 4, 8, 4, 8, 4, 8, 4,
+    8, 4, 8, 4, 8, 4, 8, 4, 8, 4, 8, 4, 8, 4, 8, 4,
+    8, 4, 8, 4, 8, 4, 8, 4, 8, 4, 8, 4, 8, 4, 8, 4,
+    8, 4, 8, 4,
+};
+
+#elif TZ_ZONE == TZ_EU_EASTERN
+#define TZ_ZONE_NAME    "Europe/Helsinki"
+#define TZ_QUARTERS_START 8
+#define TZ_COUNT        100
+static const uint32_t tzAt[TZ_COUNT] HAL_FLASH =
+{
+    7520400UL, 25664400UL, 38970000UL, 57718800UL,
+    70419600UL, 89168400UL, 101869200UL, 120618000UL,
+    133923600UL, 152067600UL, 165373200UL, 183517200UL,
+    196822800UL, 215571600UL, 228272400UL, 247021200UL,
+    259722000UL, 278470800UL, 291171600UL, 309920400UL,
+    323226000UL, 341370000UL, 354675600UL, 372819600UL,
+    386125200UL, 404874000UL, 417574800UL, 436323600UL,
+    449024400UL, 467773200UL, 481078800UL, 499222800UL,
+    512528400UL, 530672400UL, 543978000UL, 562122000UL,
+    575427600UL, 594176400UL, 606877200UL, 625626000UL,
+    638326800UL, 657075600UL, 670381200UL, 688525200UL,
+    701830800UL, 719974800UL, 733280400UL, 752029200UL,
+    764730000UL, 783478800UL, 796179600UL, 814928400UL,
+    828234000UL, 846378000UL, 859683600UL, 877827600UL,
+    891133200UL, 909277200UL, 922582800UL, 941331600UL,
+    954032400UL, 972781200UL, 985482000UL, 1004230800UL,
+    1017536400UL, 1035680400UL, 1048986000UL, 1067130000UL,
+    1080435600UL, 1099184400UL, 1111885200UL, 1130634000UL,
+    1143334800UL, 1162083600UL, 1174784400UL, 1193533200UL,
+    1206838800UL, 1224982800UL, 1238288400UL, 1256432400UL,
+    1269738000UL, 1288486800UL, 1301187600UL, 1319936400UL,
+    1332637200UL, 1351386000UL, 1364691600UL, 1382835600UL,
+    1396141200UL, 1414285200UL, 1427590800UL, 1445734800UL,
+    1459040400UL, 1477789200UL, 1490490000UL, 1509238800UL,
+    1521939600UL, 1540688400UL, 1553994000UL, 1572138000UL,
+};
+static const signed char tzQuarters[TZ_COUNT] HAL_FLASH =
+{
+    12, 8, 12, 8, 12, 8, 12, 8, 12, 8, 12, 8, 12, 8, 12, 8,
+    12, 8, 12, 8, 12, 8, 12, 8, 12, 8, 12, 8, 12, 8, 12, 8,
+    12, 8, 12, 8, 12, 8, 12, 8, 12, 8, 12, 8, 12, 8, 12, 8,
+    12, 8, 12, 8, 12, 8, 12, 8, 12, 8, 12, 8, 12, 8, 12, 8,
+    12, 8, 12, 8, 12, 8, 12, 8, 12, 8, 12, 8, 12, 8, 12, 8,
+    12, 8, 12, 8, 12, 8, 12, 8, 12, 8, 12, 8, 12, 8, 12, 8,
+    12, 8, 12, 8,
+};
+
+#else
+#error "TZ_ZONE: not a zone in Nixie_tz_table.h (add it to sim/tzgen.c)"
+#endif
+
+#endif // NIXIE_TZ_TABLE_H
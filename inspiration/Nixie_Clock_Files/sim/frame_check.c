@@ -0,0 +1,808 @@
+/*
+ * File:        sim/frame_check.c
+ * Compiler:    cc (Linux host)
+ *
+ * Info:    Golden-model check of the shift register frame (Nixie_frame.h), and of the time core and
+ *          encoder decoder that feed it, for the layout and format it was built with (-DDISPLAY_LAYOUT,
+ *          -DCLOCK_24_HOUR=0/1, the Makefile builds every layout both ways).
+ *
+ *          The model only takes the field list from Nixie_display.h (name, cathodes, what it shows) and
+ *          packs the chain itself, bit 0 up: every field is its lowest bit and its cathodes, a time is
+ *          one bit per field (cathode 0 for a neon), and a frame goes into the chain frame[0] first, MSB
+ *          first, the way spiStartFrame() and the MSSP shift it (so the bit that went in first ends up
+ *          at the far end).
+ *
+ *          frame_check [--fuzz N] [--seed S] [--trace] [--bench]
+ *              - the layout: every DISPLAY_<name>_AT, FRAME_BITS and FRAME_BYTES are where the model
+ *                packs them, every digit field has the cathodes its digit needs, a neon has one
+ *              - every time of day (43,200 12-hour / 86,400 24-hour), walked with timeTick() from
+ *                timeReset(): the digits are the model's, encodeFrame() gives the model's chain, and
+ *                the chain decodes to one cathode per field, the right one, nothing past FRAME_BITS
+ *              - the same walk, 86,400 seconds: the ripple-carry digits are what the original myTime
+ *                counter (myTime++ a second, split with / and %, myTimeDigits()) showed every second
+ *              - v1 board layout only: every one of those frames is byte for byte what the original
+ *                pow() encoder (powFrame(), kept here as the reference) made for the same digits
+ *              - timeSet() and timeSecs() for every second of the day
+ *              - every anti-poisoning frame (Nixie_slot.h) lights one cathode per field, one it has,
+ *                and between them every cathode gets lit
+ *              - scripted knob turns (knobScripts[]): slow, medium, fast, bounce, a reversal at a detent,
+ *                a Timer1 wrap, a missed edge, each an exact list of what encoderTake() gives per detent
+ *              - fuzz, N events (default 300,000): ticks, button presses, knob turns at random speeds
+ *                with contact bounce and missed edges, idle gaps long enough to wrap Timer1. They go
+ *                through encoderEdge() / encoderTake() and the time core, with the few lines of
+ *                onTick() / onButton() / onEncoder() that glue them together, and after every event
+ *                the mode, the time and the frame have to be the model's
+ *              - --bench: encodeFrame() on every time of the day, over and over, ns (and TSC cycles on
+ *                x86) a frame, and the table reads and stores a frame takes, counted from the model.
+ *                On the v1 layout the pow() reference too, same times (host numbers: the host has an
+ *                FPU, on the PIC every pow() is a soft-float library call, far worse than here)
+ *                (make frame-report adds the code and table sizes)
+ *              Exit 1 on any mismatch (make frame-check). Every build takes well under a second.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <math.h>
+
+#include "Nixie_config.h"
+#include "Nixie_time.h"
+#include "Nixie_frame.h"
+#include "Nixie_encoder.h"
+#include "Nixie_slot.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define HAVE_TSC        1
+#endif
+
+#if CLOCK_24_HOUR
+#define HOURS           24
+#else
+#define HOURS           12
+#endif
+#define DAY             86400L
+#define TMR1_PER_SEC    384000L     // Timer1 counts (2.6us)
+
+// The chain, field by field from the PIC end: cathodes wired, which time digit (H1 = 0 ... S0 = 5,
+// -1 a neon), where Nixie_display.h put it, and where the model does (checkLayout())
+typedef struct
+{
+    const char *name;
+    int cathodes;
+    int digit;
+    int declared;
+    int bit;
+} field_t;
+
+#define CHECK_FIELD(name, n, shows, a)  { #name, n, DISPLAY_DIGIT_##shows, DISPLAY_##name##_AT, 0 },
+static field_t fields[] = { DISPLAY_FIELDS(CHECK_FIELD, 0) };
+#define FIELDS          (int)(sizeof(fields) / sizeof(fields[0]))
+
+static const char *layoutNames[] = { "6_TUBE", "6_NEON", "4_TUBE", "CUSTOM" };
+static const int digitCathodes[6] = { HOURS == 24 ? 3 : 2, 10, 6, 10, 6, 10 };
+static int chainBits;
+
+static unsigned long failures;
+static int trace = 0;
+
+static void fail(const char *what, long at, long want, long got)
+{
+    if(failures < 10)
+        printf("  FAIL %s at %ld: want %ld, got %ld\n", what, at, want, got);
+    failures++;
+}
+
+#if DISPLAY_LAYOUT == DISPLAY_LAYOUT_6_TUBE
+// The original encoder, pow() and all (Nixie_main_v3.c before the tables), writing the bytes it
+// used to put in SSP1BUF. 12-hour only back then: the top byte mask gets H1's third cathode in
+// for a 24-hour build, the same 45-bit extension Nixie_frame.h made.
+static void powFrame(unsigned char *frame, const nixieTime_t *t)
+{
+    unsigned int bin_hour1, bin_hour0, bin_min1, bin_min0, bin_sec1, bin_sec0;
+
+    bin_hour1 = (unsigned int)pow(2,t->h1); //0-bit of shiftReg is connected to Nixie "0", and logically so on...
+    bin_hour0 = (unsigned int)pow(2,t->h0);
+    bin_min1  = (unsigned int)pow(2,t->m1);
+    bin_min0  = (unsigned int)pow(2,t->m0);
+    bin_sec1  = (unsigned int)pow(2,t->s1);
+    bin_sec0  = (unsigned int)pow(2,t->s0);
+
+    frame[0] = (unsigned char)((HOURS == 24 ? 0b00011111 : 0b00001111) & (((bin_hour1<<2)&0b11100) | ((bin_hour0>>8)&0b11)));
+    frame[1] = (unsigned char)bin_hour0;
+    frame[2] = (unsigned char)(((bin_min1<<2)&0b11111100) | ((bin_min0>>8)&0b11));
+    frame[3] = (unsigned char)bin_min0;
+    frame[4] = (unsigned char)(((bin_sec1<<2)&0b11111100) | ((bin_sec0>>8)&0b11));
+    frame[5] = (unsigned char)bin_sec0;
+}
+#define HAVE_POW_FRAME  1
+#endif
+
+// The model's digits for h:m:s (h 0-23, or 0-11 on a 12-hour clock where 0 shows as 12)
+static void modelDigits(int h, int m, int s, int d[6])
+{
+    if(HOURS == 12 && h == 0)
+        h = 12;
+    d[0] = h / 10;
+    d[1] = h % 10;
+    d[2] = m / 10;
+    d[3] = m % 10;
+    d[4] = s / 10;
+    d[5] = s % 10;
+}
+
+// The original sendDataOut() split (Nixie_main_v3.c before the ripple-carry digits), myTime the
+// seconds counter the ISR bumped. Wraps itself at the end of the day the way it did; 12-hour only
+// back then, so a 24-hour build wraps at 86,400 and skips the 0 -> 12.
+static void myTimeDigits(unsigned long *myTime, int d[6])
+{
+    unsigned long secs, mins, hours;
+
+    if(*myTime >= HOURS * 3600UL)
+        *myTime = 0;
+
+    secs = *myTime % 60;
+    d[4] = (int)(secs / 10);
+    d[5] = (int)(secs % 10);
+
+    mins = (*myTime / 60) % 60;
+    d[2] = (int)(mins / 10);
+    d[3] = (int)(mins % 10);
+
+    hours = *myTime / 3600;
+    if(HOURS == 12 && hours == 0)
+        hours = 12;
+    d[0] = (int)(hours / 10);
+    d[1] = (int)(hours % 10);
+}
+
+// Cathode field i has to show for the digits d (0 = any)
+static int modelCathode(int i, const int *d)
+{
+    if(fields[i].digit < 0)
+        return 0;
+    return d ? d[fields[i].digit] : -1;
+}
+
+static unsigned long long modelChain(const int d[6])
+{
+    unsigned long long c = 0;
+    int i;
+
+    for(i=0; i<FIELDS; i++)
+        c |= 1ULL << (fields[i].bit + modelCathode(i, d));
+    return c;
+}
+
+// The frame through the chain, bit by bit
+static unsigned long long shiftIn(const unsigned char *frame)
+{
+    unsigned long long c = 0;
+    int i, b;
+
+    for(i=0; i<FRAME_BYTES; i++)
+        for(b=7; b>=0; b--)
+            c = (c << 1) | ((frame[i] >> b) & 1);
+    return c;
+}
+
+// One cathode per field, one the field has, and nothing lit that isn't wired to a field.
+// d = the digits it has to be, or 0 for any (a neon is always cathode 0). Returns the cathodes it
+// found in got.
+static void checkChain(const char *what, long at, unsigned long long c, const int *d, int *got)
+{
+    unsigned long long wired = 0, f;
+    int i, k, lit, want;
+
+    for(i=0; i<FIELDS; i++)
+    {
+        f = (c >> fields[i].bit) & ((1ULL << fields[i].cathodes) - 1);
+        wired |= ((1ULL << fields[i].cathodes) - 1) << fields[i].bit;
+        got[i] = -1;
+        for(lit=0, k=0; k<fields[i].cathodes; k++)
+        {
+            if(f & (1ULL << k))
+            {
+                lit++;
+                got[i] = k;
+            }
+        }
+        want = modelCathode(i, d);
+        if(lit != 1)
+            fail(what, at, 1, lit);
+        else if(want >= 0 && got[i] != want)
+            fail(what, at, want, got[i]);
+    }
+    if(c & ~wired)
+        fail(what, at, 0, (long)(c & ~wired));
+}
+
+static int sameDigits(const nixieTime_t *t, const int d[6])
+{
+    return t->h1 == d[0] && t->h0 == d[1] && t->m1 == d[2] && t->m0 == d[3] && t->s1 == d[4] && t->s0 == d[5];
+}
+
+static long digitsSecs(const nixieTime_t *t)
+{
+    return ((t->h1 * 10 + t->h0) * 60L + t->m1 * 10 + t->m0) * 60 + t->s1 * 10 + t->s0;
+}
+
+// Pack the fields the model's way and hold Nixie_display.h / Nixie_frame.h to it
+static void checkLayout(void)
+{
+    int i;
+
+    chainBits = 0;
+    for(i=0; i<FIELDS; i++)
+    {
+        fields[i].bit = chainBits;
+        chainBits += fields[i].cathodes;
+        if(fields[i].declared != fields[i].bit)
+            fail(fields[i].name, i, fields[i].bit, fields[i].declared);
+        if(fields[i].digit < 0 && fields[i].cathodes != 1)
+            fail("neon cathodes", i, 1, fields[i].cathodes);
+        if(fields[i].digit >= 0 && fields[i].cathodes < digitCathodes[fields[i].digit])
+            fail("digit cathodes", i, digitCathodes[fields[i].digit], fields[i].cathodes);
+    }
+    if(chainBits != FRAME_BITS)
+        fail("FRAME_BITS", 0, chainBits, FRAME_BITS);
+    if((chainBits + 7) / 8 != FRAME_BYTES)
+        fail("FRAME_BYTES", 0, (chainBits + 7) / 8, FRAME_BYTES);
+}
+
+// Every second of the day, one timeTick() at a time, as the clock goes
+static void checkDay(void)
+{
+    static unsigned char seen[DAY];
+    nixieTime_t t, u;
+    unsigned char frame[FRAME_BYTES];
+    int d[6], got[FIELDS];
+    long secs, distinct = 0;
+    unsigned long myTime = 0;
+
+    timeReset(&t);
+    for(secs=0; secs<DAY; secs++)
+    {
+        myTimeDigits(&myTime, d);
+        if(!sameDigits(&t, d))
+            fail("timeTick() digits vs myTime", secs, d[0] * 100000L + d[1] * 10000L + d[2] * 1000 + d[3] * 100 + d[4] * 10 + d[5],
+                 t.h1 * 100000L + t.h0 * 10000L + t.m1 * 1000 + t.m0 * 100 + t.s1 * 10 + t.s0);
+        myTime++;
+
+        modelDigits((int)(secs / 3600 % HOURS), (int)(secs / 60 % 60), (int)(secs % 60), d);
+        if(!sameDigits(&t, d))
+            fail("timeTick() digits", secs, d[0] * 100000L + d[1] * 10000L + d[2] * 1000 + d[3] * 100 + d[4] * 10 + d[5],
+                 t.h1 * 100000L + t.h0 * 10000L + t.m1 * 1000 + t.m0 * 100 + t.s1 * 10 + t.s0);
+        encodeFrame(frame, &t);
+        if(shiftIn(frame) != modelChain(d))
+            fail("encodeFrame() chain", secs, (long)modelChain(d), (long)shiftIn(frame));
+        checkChain("tube", secs, shiftIn(frame), d, got);
+#if HAVE_POW_FRAME
+        {
+            unsigned char ref[FRAME_BYTES];
+            int i;
+
+            powFrame(ref, &t);
+            for(i=0; i<FRAME_BYTES; i++)
+                if(ref[i] != frame[i])
+                    fail("encodeFrame() vs the pow() encoder", secs * 10 + i, ref[i], frame[i]);
+        }
+#endif
+        if(!seen[digitsSecs(&t)])
+        {
+            seen[digitsSecs(&t)] = 1;
+            distinct++;
+        }
+
+        // And a sync straight to it, and back
+        timeSet(&u, (unsigned long)secs);
+        if(!sameDigits(&u, d))
+            fail("timeSet()", secs, 0, digitsSecs(&u));
+        if((long)timeSecs(&t) != secs % (HOURS * 3600L))
+            fail("timeSecs()", secs, secs % (HOURS * 3600L), (long)timeSecs(&t));
+
+        timeTick(&t);
+    }
+    timeReset(&u);
+    if(!sameDigits(&t, (modelDigits(0, 0, 0, d), d)))
+        fail("a day of ticks back to the start", DAY, digitsSecs(&u), digitsSecs(&t));
+    if(distinct != HOURS * 3600L)
+        fail("distinct times on the tubes", DAY, HOURS * 3600L, distinct);
+}
+
+static void checkSlot(void)
+{
+#if SLOT_ENABLE
+    unsigned int used[FIELDS];
+    int got[FIELDS];
+    int k, i;
+
+    memset(used, 0, sizeof(used));
+    for(k=0; k<SLOT_FRAMES; k++)
+    {
+        checkChain("anti-poisoning frame", k, shiftIn(slotFrames[k]), 0, got);
+        for(i=0; i<FIELDS; i++)
+            if(got[i] >= 0)
+                used[i] |= 1u << got[i];
+    }
+    for(i=0; i<FIELDS; i++)
+        if(used[i] != (1u << fields[i].cathodes) - 1)
+            fail("cathodes the anti-poisoning frames never light", i, (1L << fields[i].cathodes) - 1, used[i]);
+#endif
+}
+
+/*
+ * Fuzz. The firmware side: time, mode, encoder, the glue from Nixie_main_v3.c. The model: h/m/s as plain
+ * numbers, the mode, and the knob as the quarter steps it really moved (legal edges only, a missed
+ * edge is lost, never counted as a step either way).
+ */
+static unsigned long long rngState;
+
+static unsigned long rnd(unsigned long n)
+{
+    rngState ^= rngState << 13;
+    rngState ^= rngState >> 7;
+    rngState ^= rngState << 17;
+    return (unsigned long)(rngState % n);
+}
+
+// Knob positions, clockwise: 00 -> 10 -> 11 -> 01 (bit 1 = A, bit 0 = B)
+static const unsigned char knobAB[4] = { 0x0, 0x2, 0x3, 0x1 };
+
+static nixieTime_t fwTime;
+static unsigned char fwMode;
+static unsigned long long now;      // Timer1, 64-bit, the firmware sees the low 16
+static unsigned long long lastEdge; // for its "Timer1 wrapped" count (timer1Wraps - encoderWraps)
+
+static int mh, mm, ms, mMode;
+static int knob;                    // where the knob really is, quarter steps
+static int counted, lastDetent;     // quarter steps the decoder should have counted, and where it last saw a detent
+static unsigned long long lastDetentAt;
+static int firstDetent = 1;
+static int owed;                    // detents (accelerated) the model expects main() to pick up
+
+static void fwEdge(void)
+{
+    encoderEdge(knobAB[knob & 3], (unsigned int)(now & 0xFFFF),
+                (unsigned char)((now >> 16) - (lastEdge >> 16)));
+    lastEdge = now;
+}
+
+// One legal edge, dir +1 / -1
+static void edge(int dir)
+{
+    int step = 1;
+    unsigned long long took;
+
+    knob += dir;
+    counted += dir;
+    fwEdge();
+    if(counted - lastDetent >= ENCODER_STEPS_PER_DETENT || lastDetent - counted >= ENCODER_STEPS_PER_DETENT)
+    {
+        took = now - lastDetentAt;
+        if(!firstDetent && took < ENCODER_FAST_COUNTS)
+            step = ENCODER_ACCEL_FAST;
+        else if(!firstDetent && took < ENCODER_MEDIUM_COUNTS)
+            step = ENCODER_ACCEL_MEDIUM;
+        owed += (counted > lastDetent) ? step : -step;
+        lastDetent = counted;
+        lastDetentAt = now;
+        firstDetent = 0;
+    }
+}
+
+// onEncoder()
+static void fwEncoder(void)
+{
+    signed char steps = encoderTake();
+
+    if(steps != owed)
+        fail("detents from encoderTake()", (long)(now / TMR1_PER_SEC), owed, steps);
+    owed = 0;
+    if((steps == 0) || (fwMode == 0))
+        return;
+    for(; steps > 0; steps--)
+    {
+        if(fwMode == 1)
+            timeIncHours(&fwTime);
+        else if(fwMode == 2)
+            timeIncMins(&fwTime);
+        else
+            timeIncSecs(&fwTime);
+    }
+    for(; steps < 0; steps++)
+    {
+        if(fwMode == 1)
+            timeDecHours(&fwTime);
+        else if(fwMode == 2)
+            timeDecMins(&fwTime);
+        else
+            timeDecSecs(&fwTime);
+    }
+}
+
+static void modelEncoder(void)
+{
+    int n = owed;
+
+    if(mMode == 1)
+        mh = ((mh + n) % HOURS + HOURS) % HOURS;
+    else if(mMode == 2)
+        mm = ((mm + n) % 60 + 60) % 60;
+    else if(mMode == 3)
+        ms = ((ms + n) % 60 + 60) % 60;
+}
+
+static void modelTick(void)
+{
+    if(++ms < 60)
+        return;
+    ms = 0;
+    if(++mm < 60)
+        return;
+    mm = 0;
+    mh = (mh + 1) % HOURS;
+}
+
+static void fuzz(unsigned long events)
+{
+    static const char *names[] = { "tick", "press", "turn", "bounce", "missed edge", "gap", "encoder" };
+    unsigned char frame[FRAME_BYTES];
+    unsigned long e;
+    unsigned long long nextTick = TMR1_PER_SEC;
+    int d[6], got[FIELDS];
+    int what, n, dir, k, gap;
+
+    timeReset(&fwTime);
+    fwMode = 0;
+    encoderReset(knobAB[0]);
+    for(e=0; e<events; e++)
+    {
+        what = (int)rnd(20);
+        if(what < 4)
+        {
+            // The second is up (onTick()), the clock runs in every mode
+            now = nextTick;
+            nextTick += TMR1_PER_SEC;
+            timeTick(&fwTime);
+            modelTick();
+            what = 0;
+        }
+        else if(what < 6)
+        {
+            // main() gets to a pending EVT_ENCODER first half the time...
+            if(rnd(2))
+            {
+                modelEncoder();
+                fwEncoder();
+            }
+            // ...then onButton(): next mode, whatever was turned in the last one is dropped
+            fwMode = (unsigned char)((fwMode + 1) & 3);
+            encoderTake();
+            mMode = (mMode + 1) & 3;
+            owed = 0;
+            now += 1 + rnd(3000);
+            what = 1;
+        }
+        else if(what < 14)
+        {
+            // A few detents, slow, medium or fast, the odd edge chattering
+            dir = rnd(2) ? 1 : -1;
+            n = 1 + (int)rnd(6);
+            gap = (int)(ENCODER_FAST_COUNTS / 8 + rnd(ENCODER_MEDIUM_COUNTS + 20000));
+            for(k=0; k<n * ENCODER_STEPS_PER_DETENT; k++)
+            {
+                now += 1 + rnd((unsigned long)gap);
+                edge(dir);
+                if(rnd(8) == 0)
+                {
+                    now += 1 + rnd(40);
+                    edge(-dir);
+                    now += 1 + rnd(40);
+                    edge(dir);
+                }
+            }
+            what = 2;
+        }
+        else if(what < 15)
+        {
+            // Half a detent forward and back (a wobble that never clicks)
+            dir = rnd(2) ? 1 : -1;
+            now += 1 + rnd(2000);
+            edge(dir);
+            now += 1 + rnd(2000);
+            edge(-dir);
+            what = 3;
+        }
+        else if(what < 16)
+        {
+            // Both channels changed before the ISR looked: the decoder can't tell which way, counts nothing
+            knob += rnd(2) ? 2 : -2;
+            now += 1 + rnd(5000);
+            fwEdge();
+            what = 4;
+        }
+        else if(what < 18)
+        {
+            now += rnd(4 * 65536);     // nobody touches it for a while, Timer1 wraps (or doesn't)
+            what = 5;
+        }
+        else
+            what = 6;
+
+        if(now >= nextTick)
+        {
+            // Ticks that came due in the middle of a turn, the clock kept going
+            while(nextTick <= now)
+            {
+                nextTick += TMR1_PER_SEC;
+                timeTick(&fwTime);
+                modelTick();
+            }
+        }
+        if(what == 6 || (what == 2 && rnd(2)) || owed > 100 || owed < -100)
+        {
+            modelEncoder();
+            fwEncoder();
+        }
+
+        // Mode, time, frame: all the model's
+        modelDigits(mh, mm, ms, d);
+        if(fwMode != mMode)
+            fail("mode", (long)e, mMode, fwMode);
+        if(!sameDigits(&fwTime, d))
+            fail(names[what], (long)e, (mh * 100L + mm) * 100 + ms, digitsSecs(&fwTime));
+        encodeFrame(frame, &fwTime);
+        checkChain(names[what], (long)e, shiftIn(frame), d, got);
+        if(trace)
+            printf("%8lu %-12s mode %d  %d%d:%d%d:%d%d  owed %d\n", e, names[what], mMode, d[0], d[1], d[2], d[3],
+                   d[4], d[5], owed);
+        if(failures >= 10)
+            break;
+    }
+}
+
+/*
+ * Scripted knob turns, each one a fixed A/B waveform with exactly the detents and acceleration steps it
+ * has to give (the fuzz only checks the decoder against the model, these pin the numbers down).
+ * Path, one character per thing the knob does, gap Timer1 counts after the edge before it:
+ *      + / -   one legal edge, a quarter step clockwise / anticlockwise
+ *      b       contact bounce on the edge before it: back a quarter and forward again, 20 counts apart
+ *      x       both channels changed before the ISR looked (2 quarters at once, counts nothing)
+ *      .       hands off for 70,000 counts, Timer1 wraps once
+ * want: encoderTake() after every detent, in order. The first detent after encoderReset() is never an
+ * accelerated one, and a reversal keeps the speed from the detent before it (direction doesn't matter).
+ */
+typedef struct
+{
+    const char *name;
+    unsigned int gap;
+    const char *path;
+    signed char want[6];
+} knobScript_t;
+
+static const knobScript_t knobScripts[] =
+{
+    //  name                    gap     path                        detents
+    { "slow",                   10000,  "++++++++",                 { 1, 1 } },             // 40,000 a detent
+    { "medium",                 3000,   "++++++++++++",             { 1, 2, 2 } },          // 12,000
+    { "fast",                   1000,   "++++++++++++",             { 1, 5, 5 } },          // 4,000
+    { "fast, anticlockwise",    1000,   "------------",             { -1, -5, -5 } },
+    { "fast after a wrap",      1000,   "++++.++++",                { 1, 1 } },             // 74,000, not 8,464
+    { "slow with bounce",       10000,  "+b+b+b+b+b+b+b+b",         { 1, 1 } },
+    { "fast with bounce",       1000,   "+b+b+b+b+b+b+b+b",         { 1, 5 } },             // 4,160
+    { "reversal at a detent",   1000,   "++++++++--------",         { 1, 5, -5, -5 } },
+    { "slow reversal",          10000,  "++++++++--------",         { 1, 1, -1, -1 } },
+    { "half a detent and back", 3000,   "++------",                 { -1 } },
+    { "missed edge",            3000,   "+x+++",                    { 1 } },
+};
+#define KNOB_SCRIPTS    (int)(sizeof(knobScripts) / sizeof(knobScripts[0]))
+
+static void checkEncoder(void)
+{
+    const knobScript_t *s;
+    unsigned long long t, last;
+    int i, k, m, pos, detents, n, nm;
+    int moves[2];
+    signed char got;
+
+#if ENCODER_STEPS_PER_DETENT != 4
+    printf("  scripted knob turns skipped, they're written for ENCODER_STEPS_PER_DETENT 4\n");
+    return;
+#endif
+    for(i=0; i<KNOB_SCRIPTS; i++)
+    {
+        s = &knobScripts[i];
+        for(n=0; n<6 && s->want[n] != 0; n++)
+            ;
+        t = last = 0;
+        pos = 0;
+        detents = 0;
+        encoderReset(knobAB[0]);
+        encoderTake();
+        for(k=0; s->path[k]; k++)
+        {
+            nm = 0;
+            if(s->path[k] == '.')
+            {
+                t += 70000;
+                continue;
+            }
+            if(s->path[k] == '+' || s->path[k] == '-')
+                moves[nm++] = (s->path[k] == '+') ? 1 : -1;
+            else if(s->path[k] == 'b')
+            {
+                moves[nm++] = (s->path[k - 1] == '+') ? -1 : 1;
+                moves[nm++] = (s->path[k - 1] == '+') ? 1 : -1;
+            }
+            else
+                moves[nm++] = 2;
+            for(m=0; m<nm; m++)
+            {
+                t += (s->path[k] == 'b') ? 20 : s->gap;
+                pos += moves[m];
+                if(!encoderEdge(knobAB[pos & 3], (unsigned int)(t & 0xFFFF), (unsigned char)((t >> 16) - (last >> 16))))
+                {
+                    last = t;
+                    continue;
+                }
+                last = t;
+                got = encoderTake();
+                if(detents >= n)
+                    fail(s->name, k, 0, got);
+                else if(got != s->want[detents])
+                    fail(s->name, k, s->want[detents], got);
+                detents++;
+            }
+        }
+        if(detents != n)
+            fail(s->name, -1, n, detents);  // detents, all told
+        if(trace)
+            printf("  knob: %-24s %d detents\n", s->name, detents);
+    }
+}
+
+static double msNow(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+}
+
+// encodeFrame() on the whole day, BENCH_ROUNDS times (the times are worked out before the clock starts)
+#define BENCH_ROUNDS    100
+
+static void bench(void)
+{
+    static nixieTime_t day[DAY];
+    unsigned char frame[FRAME_BYTES];
+    long i, n = HOURS * 3600L;
+    int k, r, reads = 0, stores = 0, ors = 0;
+    unsigned long sum = 0;
+    double ms;
+#if HAVE_TSC
+    unsigned long long tsc;
+#endif
+#if HAVE_POW_FRAME
+    unsigned long powSum = 0;
+    double powMs;
+#if HAVE_TSC
+    unsigned long long powTsc;
+#endif
+#endif
+
+    timeReset(&day[0]);
+    for(i=1; i<n; i++)
+    {
+        day[i] = day[i - 1];
+        timeTick(&day[i]);
+    }
+
+    ms = msNow();
+#if HAVE_TSC
+    tsc = __rdtsc();
+#endif
+    for(k=0; k<BENCH_ROUNDS; k++)
+    {
+        for(i=0; i<n; i++)
+        {
+            encodeFrame(frame, &day[i]);
+            sum += frame[i % FRAME_BYTES];
+        }
+    }
+#if HAVE_TSC
+    tsc = __rdtsc() - tsc;
+#endif
+    ms = msNow() - ms;
+
+#if HAVE_POW_FRAME
+    // The same frames the old way (the sums have to agree, and keep both loops from being optimised out)
+    powMs = msNow();
+#if HAVE_TSC
+    powTsc = __rdtsc();
+#endif
+    for(k=0; k<BENCH_ROUNDS; k++)
+    {
+        for(i=0; i<n; i++)
+        {
+            powFrame(frame, &day[i]);
+            powSum += frame[i % FRAME_BYTES];
+        }
+    }
+#if HAVE_TSC
+    powTsc = __rdtsc() - powTsc;
+#endif
+    powMs = msNow() - powMs;
+    if(powSum != sum)
+        fail("bench frames, pow() vs tables", 0, (long)powSum, (long)sum);
+#endif
+
+    // What the generated encoder does, from the model's packing: a store per byte a field touches,
+    // an OR if a field below already put bits in that byte, a table read for each of them
+    // (a neon's is a constant, the compiler folds it)
+    for(i=0; i<FIELDS; i++)
+    {
+        r = (fields[i].bit + fields[i].cathodes - 1) / 8 - fields[i].bit / 8 + 1;
+        if(fields[i].digit >= 0)
+            reads += r;
+        if(fields[i].bit % 8)
+            ors++;
+        stores += r;
+    }
+    stores -= ors;
+
+    printf("  encodeFrame(): %.2f ns a frame", ms * 1e6 / ((double)n * BENCH_ROUNDS));
+#if HAVE_TSC
+    printf(", %.1f TSC cycles", (double)tsc / ((double)n * BENCH_ROUNDS));
+#endif
+    printf("\n  %d fields, %d table reads a frame, %d stores + %d ORs into %d bytes\n",
+           FIELDS, reads, stores, ors, FRAME_BYTES);
+#if HAVE_POW_FRAME
+    printf("  pow() encoder: %.2f ns a frame", powMs * 1e6 / ((double)n * BENCH_ROUNDS));
+#if HAVE_TSC
+    printf(", %.1f TSC cycles", (double)powTsc / ((double)n * BENCH_ROUNDS));
+#endif
+    printf(", %.1fx the tables\n", powMs / (ms > 0 ? ms : 1e-9));
+#endif
+}
+
+int main(int argc, char **argv)
+{
+    unsigned long events = 300000, seed = 1;
+    double start = msNow();
+    int i, doBench = 0;
+
+    for(i=1; i<argc; i++)
+    {
+        if(!strcmp(argv[i], "--fuzz") && i + 1 < argc)
+            events = strtoul(argv[++i], 0, 0);
+        else if(!strcmp(argv[i], "--seed") && i + 1 < argc)
+            seed = strtoul(argv[++i], 0, 0);
+        else if(!strcmp(argv[i], "--trace"))
+            trace = 1;
+        else if(!strcmp(argv[i], "--bench"))
+            doBench = 1;
+        else
+        {
+            fprintf(stderr, "usage: %s [--fuzz N] [--seed S] [--trace] [--bench]\n", argv[0]);
+            return 2;
+        }
+    }
+    rngState = seed * 0x9E3779B97F4A7C15ULL + 1;
+
+    printf("%s, %d-hour frames (%d bits):\n", layoutNames[DISPLAY_LAYOUT], HOURS, FRAME_BITS);
+    checkLayout();
+    checkDay();
+    checkSlot();
+    checkEncoder();
+    fuzz(events);
+    printf("  %ld times, %d knob scripts, %lu fuzz events (seed %lu), %.0f ms\n", HOURS * 3600L, KNOB_SCRIPTS, events,
+           seed, msNow() - start);
+    if(doBench)
+        bench();
+
+    printf("  %s\n", failures ? "FAIL" : "PASS");
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,599 @@
+/*
+ * File:        sim/nixie_fleet.cpp
+ * Compiler:    g++ (host only)
+ *
+ * Info:    Monte Carlo fleet: how far a few thousand clocks drift, each one with its own crystal,
+ *          its own room and its own interrupt latency, free running or kept on time by NTP.
+ *
+ *          Every clock is drawn from --seed and its number, so a fleet is the same run whatever
+ *          the number of jobs:
+ *              crystal     error at 25C uniform in +/- --ppm, aging uniform in +/- --aging ppm a year,
+ *                          AT-cut temperature curve: a cubic (AT_CUT_A3) around AT_CUT_TURN_C plus a
+ *                          linear term from the cut angle, uniform in +/- AT_CUT_A1 ppm/K
+ *              room        21-33C inside the case, a daily swing of 0.5-4C peaking at a random hour,
+ *                          and a random walk on top (heating, sun, a window), a new temperature each minute
+ *              latency     Timer0 match --> ISR: LAG_BASE_TCY, plus up to 20% of the matches held up by
+ *                          another interrupt for up to 20-150 Tcy
+ *              trim        TICK_TRIM_PPB, or with --cal P as if each one was built with its own, measured
+ *                          to +/- P ppm at 25C
+ *              network     (--ntp) one way delay, exponential jitter, asymmetry and loss each drawn up to
+ *                          the option's value, and powered up +/- --start-error off
+ *          Each second is exactly what the firmware makes of it: 3000 + tickStretch counts of a crystal
+ *          running that second's frequency, tickStretch from the real tickTrimSecond() (Nixie_tick.c),
+ *          with --ntp the real client (Nixie_ntp.c) working tickTrimPpb, the packets go through
+ *          a model of the network instead of a socket (see ntp_harness.cpp for the real UDP).
+ *
+ *          Latency never builds up: Timer0 restarts itself at the match, a late ISR only moves that
+ *          second's RCK (reported as the tube lag). --preload is the old 16-bit preload method
+ *          instead, which lost every cycle between the overflow and the reload, once a second.
+ *
+ *          The firmware keeps its state in globals, one clock per address space, so every clock runs
+ *          in a process of its own (fork()), up to --jobs of them at once, and the drift curves come
+ *          back through shared memory. Nothing is shared between running clocks, so it scales with
+ *          the cores (--bench).
+ *
+ *          nixie_fleet [--clocks N] [--days D] [--jobs J] [--seed N] [--ppm P] [--aging P] [--cal P] [--preload]
+ *                      [--ntp] [--delay MS] [--jitter MS] [--asym MS] [--loss P] [--start-error S] [--lock-us US]
+ *                      [--bench]
+ *              --clocks N      fleet size (default 1000)
+ *              --days D        simulated days (default 30)
+ *              --jobs J        clocks at once (default: every core)
+ *              --ppm P         crystal tolerance (default 20)
+ *              --aging P       ppm a year (default 3)
+ *              --cal P         per-clock trim, measured to +/- P ppm (default: none, TICK_TRIM_PPB)
+ *              --preload       the old Timer0 preload: the ISR latency is lost every second
+ *              --ntp           every clock syncs, --delay (30), --jitter (5), --asym (1), --loss (0.1),
+ *                              --start-error (5), converged = |error| under --lock-us (3000) after 6 hours
+ *                              (a few ms: a burst that lost most of its replies leaves one jittery sample)
+ *              --bench         the fleet at 1, 2, 4 ... --jobs, clock-days per second for each
+ *
+ *          Prints the drift curve, percentiles of |clock - true time| over the fleet. Exit status 1 if
+ *          a clock crashed, with --ntp if one never synced, got stepped after it, skipped or repeated
+ *          a second or didn't converge, and with --bench if the job count changed the results.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <algorithm>
+#include <chrono>
+#include <vector>
+#include "../Nixie_config.h"
+#include "../Nixie_tick.h"
+#include "../Nixie_ntp.h"
+
+#define TRUE_SECS       (NTP_BOOT_SECS + 200UL * 86400)   // true time at the start of the run (whole seconds)
+#define TCY_HZ          3072000.0       // Fosc/4
+#define YEAR_SECS       (365.25 * 86400)
+#define SETTLE_SECS     (6 * 3600.0)    // --ntp: convergence is checked from here on
+
+#define AT_CUT_TURN_C   25.0            // inflection of the AT-cut curve
+#define AT_CUT_A1       0.17            // ppm/K, linear term for a cut angle off by up to 2'
+#define AT_CUT_A3       1.0e-4          // ppm/K^3
+#define ROOM_TAU_SECS   (3 * 3600.0)    // how fast the random walk forgets
+
+#define LAG_BASE_TCY    11              // Timer0 match --> RCK with nothing in the way (make report, a lower bound)
+#define LAG_TABLE       256             // latency samples drawn per clock, picked at random every second
+
+struct Clock
+{
+    double ppm;                 // crystal error at 25C, + = fast
+    double agingPpm;            // a year
+    double a1;                  // ppm/K
+    double roomC, swingC, peakHour, wanderC;
+    long trimPpb;
+    float lag[LAG_TABLE];       // Tcy
+    double delayMs, jitterMs, asymMs, loss;
+    double startError;
+};
+
+struct Result
+{
+    double lagMeanTcy, lagMaxTcy;
+    double worstUs;             // --ntp: largest |error| after SETTLE_SECS, what the asymmetry hides taken off
+    unsigned long stepsAfterSync, sequenceErrors;
+    unsigned char synced;
+    unsigned char done;
+};
+
+// Options
+static long clocks = 1000;
+static double days = 30;
+static int jobs;
+static unsigned long long seed = 1;
+static double tolPpm = 20, agingPpm = 3, calPpm = -1;
+static int preload = 0, ntp = 0, bench = 0;
+static double delayMs = 30, jitterMs = 5, asymMs = 1, loss = 0.1, startError = 5, lockUs = 3000;
+
+// The fleet, in memory shared with the clock processes
+static Result *results;
+static float *curves;           // clocks x samples, clock - true time at every hour, seconds
+static long samples;
+
+// One clock's simulation (each in its own process)
+static unsigned long long rngState;
+static Clock clk;
+static double now;              // true time, seconds since the start of the run
+static unsigned long long localSecs;
+static double secStart, secLen;
+static double cps;              // Timer0 counts a second right now
+
+struct Packet
+{
+    double at;
+    unsigned char data[NTP_PACKET_BYTES];
+};
+static std::vector<Packet> inFlight;
+
+// xorshift, seeded per clock through splitmix so neighbouring clocks have nothing in common
+static unsigned long long rnd(void)
+{
+    rngState ^= rngState << 13;
+    rngState ^= rngState >> 7;
+    rngState ^= rngState << 17;
+    return rngState;
+}
+
+static double uniform(double lo, double hi)
+{
+    return lo + (hi - lo) * ((rnd() >> 11) * (1.0 / 9007199254740992.0));
+}
+
+static double gauss(void)
+{
+    return sqrt(-2 * log(uniform(1e-300, 1))) * cos(2 * M_PI * uniform(0, 1));
+}
+
+static void seedClock(long n)
+{
+    unsigned long long z = seed * 0x9E3779B97F4A7C15ULL + (unsigned long long)n + 1;
+
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    rngState = (z ^ (z >> 31)) | 1;
+}
+
+static void drawClock(long n)
+{
+    double busy, busyTcy;
+    int i;
+
+    seedClock(n);
+    clk.ppm = uniform(-tolPpm, tolPpm);
+    clk.agingPpm = uniform(-agingPpm, agingPpm);
+    clk.a1 = uniform(-AT_CUT_A1, AT_CUT_A1);
+    clk.roomC = uniform(21, 33);
+    clk.swingC = uniform(0.5, 4);
+    clk.peakHour = uniform(0, 24);
+    clk.wanderC = uniform(0.2, 1.5);
+    clk.trimPpb = (calPpm >= 0) ? TICK_TRIM_PPB + (long)((clk.ppm + uniform(-calPpm, calPpm)) * 1000) : TICK_TRIM_PPB;
+
+    busy = uniform(0, 0.2);
+    busyTcy = uniform(20, 150);
+    for(i=0; i<LAG_TABLE; i++)
+        clk.lag[i] = (float)(LAG_BASE_TCY + ((uniform(0, 1) < busy) ? uniform(0, busyTcy) : 0));
+
+    clk.delayMs = uniform(1, delayMs);
+    clk.jitterMs = uniform(0, jitterMs);
+    clk.asymMs = uniform(0, asymMs);
+    clk.loss = uniform(0, loss);
+    clk.startError = uniform(-startError, startError);
+}
+
+static double crystalPpm(double t, double tempC)
+{
+    double d = tempC - AT_CUT_TURN_C;
+
+    return clk.ppm + clk.agingPpm * t / YEAR_SECS + clk.a1 * d + AT_CUT_A3 * d * d * d;
+}
+
+// --- what Nixie_main_v3.c provides to the NTP client, as in ntp_harness.cpp ---
+
+static long elapsedCounts(void)
+{
+    return (long)floor((now - secStart) * cps);
+}
+
+static ntpStamp_t toStamp(double secs)
+{
+    double whole = floor(secs);
+
+    return ((ntpStamp_t)(TRUE_SECS + (long long)whole) << 32) + (ntpStamp_t)((secs - whole) * 4294967296.0);
+}
+
+ntpStamp_t ntpClockRead(void)
+{
+    return ((ntpStamp_t)localSecs << 32) + ((((ntpStamp_t)elapsedCounts() * 2 + 1) << 31) / TICK_COUNTS_PER_SEC);
+}
+
+void ntpClockStep(long long ns)
+{
+    long e = elapsedCounts();
+    ntpStamp_t t = ntpClockRead() + (ntpStamp_t)ntpNsToStamp(ns);
+    unsigned long long secs = t >> 32;
+    long counts = (long)(((t & 0xFFFFFFFFULL) * TICK_COUNTS_PER_SEC) >> 32) - (e % TICK_PERIOD) + TICK_PERIOD / 2;
+    long sub;
+
+    if(counts < 0)
+    {
+        counts += TICK_COUNTS_PER_SEC;
+        secs--;
+    }
+    sub = counts / TICK_PERIOD;
+    if(sub >= TICK_SUBTICKS)
+    {
+        sub -= TICK_SUBTICKS;
+        secs++;
+    }
+    localSecs = secs;
+    secStart = now - (sub * TICK_PERIOD + e % TICK_PERIOD) / cps;
+}
+
+static double netDelay(void)
+{
+    return (clk.delayMs - clk.jitterMs * log(uniform(1e-300, 1))) / 1000;
+}
+
+// The server is the true time, its answer is put straight into the flight queue
+void ntpNetSend(const unsigned char *pkt)
+{
+    double up, down;
+    ntpStamp_t t2, t3;
+    Packet p;
+    int i;
+
+    if(uniform(0, 1) < clk.loss || uniform(0, 1) < clk.loss)
+        return;
+    up = netDelay();
+    down = netDelay() + clk.asymMs / 1000;
+    t2 = toStamp(now + up);
+    t3 = t2 + (50ULL << 32) / 1000000;  // 50us to answer
+
+    memset(p.data, 0, sizeof(p.data));
+    p.data[0] = (0 << 6) | (4 << 3) | 4;
+    p.data[1] = 2;
+    memcpy(p.data + 24, pkt + 40, 8);
+    for(i=0; i<8; i++)
+    {
+        p.data[32 + i] = (unsigned char)(t2 >> (56 - 8 * i));
+        p.data[40 + i] = (unsigned char)(t3 >> (56 - 8 * i));
+    }
+    p.at = now + up + 50e-6 + down;
+    inFlight.push_back(p);
+}
+
+// One clock from power-up to the end of the run, into results[n] and its curve
+static void runClock(long n)
+{
+    Result *r = &results[n];
+    float *curve = curves + n * samples;
+    double end = days * 86400, nextMinute = 0, wander = 0, tempC, ppm = 0, lag, lagSum = 0, bias, e;
+    unsigned long long prevSecs;
+    unsigned long prevSteps = 0;
+    long nextSample = 0;
+    size_t i, k;
+
+    drawClock(n);
+    memset(r, 0, sizeof(*r));
+    bias = -clk.asymMs / 2000;      // where NTP settles with an asymmetric path (it can't tell)
+
+    wander = clk.wanderC * gauss();
+    tempC = clk.roomC;
+    cps = TICK_COUNTS_PER_SEC * (1.0 + crystalPpm(0, tempC) * 1e-6);
+
+    // Power up: set by hand to the second, or with NTP however far off it was
+    now = 0;
+    localSecs = TRUE_SECS;
+    secStart = 0;
+    if(ntp)
+    {
+        localSecs += (unsigned long long)(long long)floor(clk.startError);
+        secStart = -(clk.startError - floor(clk.startError)) / (cps / TICK_COUNTS_PER_SEC);
+    }
+    tickTrimPpb = clk.trimPpb;
+    tickTrimSecond();
+    secLen = (TICK_COUNTS_PER_SEC + tickStretch) / cps;
+    if(ntp)
+        ntpInit();
+
+    while(secStart < end)
+    {
+        // A new room temperature every minute, the crystal follows
+        if(secStart >= nextMinute)
+        {
+            wander += -wander * 60 / ROOM_TAU_SECS + clk.wanderC * sqrt(2 * 60 / ROOM_TAU_SECS) * gauss();
+            tempC = clk.roomC + wander + clk.swingC * cos(2 * M_PI * (secStart / 86400 - clk.peakHour / 24));
+            ppm = crystalPpm(secStart, tempC);
+            nextMinute += 60;
+        }
+
+        // Replies that get here before the end of this second
+        while(!inFlight.empty())
+        {
+            for(k=0, i=1; i<inFlight.size(); i++)
+                if(inFlight[i].at < inFlight[k].at)
+                    k = i;
+            if(inFlight[k].at >= secStart + secLen)
+                break;
+            Packet p = inFlight[k];
+            inFlight.erase(inFlight.begin() + k);
+            now = p.at;
+            ntpReceive(p.data, NTP_PACKET_BYTES, ntpClockRead());
+        }
+
+        // Second boundary: the match, the ISR however late, next second's stretch, then main()
+        now = secStart + secLen;
+        secStart = now;
+        prevSecs = localSecs;
+        localSecs++;
+        cps = TICK_COUNTS_PER_SEC * (1.0 + ppm * 1e-6);
+        lag = clk.lag[rnd() % LAG_TABLE];
+        lagSum += lag;
+        if(lag > r->lagMaxTcy)
+            r->lagMaxTcy = lag;
+        tickTrimSecond();
+        secLen = (TICK_COUNTS_PER_SEC + tickStretch) / cps;
+        if(preload)
+            secLen += lag / (TCY_HZ * (1.0 + ppm * 1e-6));
+
+        if(ntp)
+        {
+            ntpSecond();
+            if(ntpSteps != prevSteps)
+            {
+                if(prevSteps != 0)
+                    r->stepsAfterSync++;
+                prevSteps = ntpSteps;
+            }
+            else if(localSecs != prevSecs + 1)
+                r->sequenceErrors++;
+            if(secStart >= SETTLE_SECS)
+            {
+                e = fabs((double)(long long)(localSecs - TRUE_SECS) - secStart - bias) * 1e6;
+                if(e > r->worstUs)
+                    r->worstUs = e;
+            }
+        }
+
+        while(nextSample < samples && secStart >= nextSample * 3600.0)
+            curve[nextSample++] = (float)((double)(long long)(localSecs - TRUE_SECS) - secStart);
+    }
+
+    r->lagMeanTcy = lagSum / (days * 86400);
+    if(ntp)
+    {
+        r->synced = ntpSynced;
+    }
+    r->done = 1;
+}
+
+// Every clock in a process of its own, up to 'j' at once. Returns the wall time.
+static double runFleet(int j)
+{
+    int running = 0, status;
+    long next = 0;
+    pid_t child;
+
+    memset(results, 0, clocks * sizeof(Result));
+    std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+    while(next < clocks || running > 0)
+    {
+        if(next < clocks && running < j)
+        {
+            fflush(stdout);
+            child = fork();
+            if(child < 0)
+            {
+                perror("fork");
+                exit(2);
+            }
+            if(child == 0)
+            {
+                runClock(next);
+                _exit(0);
+            }
+            next++;
+            running++;
+            continue;
+        }
+        if(wait(&status) > 0)
+            running--;
+    }
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+}
+
+// Nearest rank, v sorted
+static double percentile(const std::vector<double> &v, double p)
+{
+    size_t i = (size_t)ceil(p / 100 * v.size());
+
+    return v.empty() ? 0 : v[(i > 0 ? i : 1) - 1];
+}
+
+static void printCurve(void)
+{
+    std::vector<double> v;
+    long hours = samples - 1, step = 24, h, n;
+
+    if(days > 30)
+        step = 24 * (long)ceil(days / 30);
+    printf("    time    |clock - true time| over the fleet, ms                 p99 as ppm\n"
+           "                  p50         p90         p99         max\n");
+    for(h=1; h<=hours; h++)
+    {
+        if(!(h == 1 || h == 6 || (h == 12 && hours < 48) || h % step == 0 || h == hours))
+            continue;
+        v.clear();
+        for(n=0; n<clocks; n++)
+            if(results[n].done)
+                v.push_back(fabs(curves[n * samples + h]));
+        std::sort(v.begin(), v.end());
+        if(h % 24 == 0)
+            printf("%6ld d", h / 24);
+        else
+            printf("%6ld h", h);
+        printf("  %11.3f %11.3f %11.3f %11.3f   %8.3f\n", percentile(v, 50) * 1e3, percentile(v, 90) * 1e3,
+               percentile(v, 99) * 1e3, percentile(v, 100) * 1e3, percentile(v, 99) / (h * 3600.0) * 1e6);
+    }
+}
+
+// FNV-1a over the curves, the same fleet has to give the same answer whatever the job count
+static unsigned long long fingerprint(void)
+{
+    const unsigned char *p = (const unsigned char *)curves;
+    unsigned long long h = 0xCBF29CE484222325ULL;
+    size_t i;
+
+    for(i=0; i<(size_t)clocks * samples * sizeof(float); i++)
+        h = (h ^ p[i]) * 0x100000001B3ULL;
+    return h;
+}
+
+int main(int argc, char **argv)
+{
+    std::vector<double> lagMean, lagMax;
+    unsigned long long print0 = 0;
+    long n, crashed = 0, unsynced = 0, stepped = 0, skipped = 0, diverged = 0;
+    double wall, one = 0, worst = 0;
+    int i, j, same, fail = 0;
+    size_t bytes;
+
+    jobs = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    for(i=1; i<argc; i++)
+    {
+        const char *a = argv[i];
+        const char *v = (i + 1 < argc) ? argv[i + 1] : 0;
+
+        if(!strcmp(a, "--preload") || !strcmp(a, "--ntp") || !strcmp(a, "--bench"))
+        {
+            preload |= !strcmp(a, "--preload");
+            ntp |= !strcmp(a, "--ntp");
+            bench |= !strcmp(a, "--bench");
+            continue;
+        }
+        if(!v)
+            a = "?";
+        if(!strcmp(a, "--clocks"))
+            clocks = atol(v);
+        else if(!strcmp(a, "--days"))
+            days = atof(v);
+        else if(!strcmp(a, "--jobs"))
+            jobs = atoi(v);
+        else if(!strcmp(a, "--seed"))
+            seed = strtoull(v, 0, 0);
+        else if(!strcmp(a, "--ppm"))
+            tolPpm = atof(v);
+        else if(!strcmp(a, "--aging"))
+            agingPpm = atof(v);
+        else if(!strcmp(a, "--cal"))
+            calPpm = atof(v);
+        else if(!strcmp(a, "--delay"))
+            delayMs = atof(v);
+        else if(!strcmp(a, "--jitter"))
+            jitterMs = atof(v);
+        else if(!strcmp(a, "--asym"))
+            asymMs = atof(v);
+        else if(!strcmp(a, "--loss"))
+            loss = atof(v);
+        else if(!strcmp(a, "--start-error"))
+            startError = atof(v);
+        else if(!strcmp(a, "--lock-us"))
+            lockUs = atof(v);
+        else
+        {
+            fprintf(stderr, "usage: %s [--clocks N] [--days D] [--jobs J] [--seed N] [--ppm P] [--aging P] [--cal P] [--preload]\n"
+                            "       [--ntp] [--delay MS] [--jitter MS] [--asym MS] [--loss P] [--start-error S] [--lock-us US] [--bench]\n", argv[0]);
+            return 2;
+        }
+        i++;
+    }
+    if(clocks < 1 || days * 24 < 1 || jobs < 1)
+    {
+        fprintf(stderr, "%s: at least one clock, an hour and a job\n", argv[0]);
+        return 2;
+    }
+
+    samples = (long)floor(days * 24) + 1;
+    bytes = clocks * sizeof(Result) + (size_t)clocks * samples * sizeof(float);
+    results = (Result *)mmap(0, bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if(results == MAP_FAILED)
+    {
+        perror("mmap");
+        return 2;
+    }
+    curves = (float *)(results + clocks);
+
+    printf("fleet: %ld clocks x %g days, crystal +/-%g ppm, aging +/-%g ppm/year, AT-cut, ", clocks, days, tolPpm, agingPpm);
+    if(calPpm >= 0)
+        printf("trimmed to +/-%g ppm, ", calPpm);
+    printf("%s\n", preload ? "Timer0 preload (latency lost every second)" : "Timer0 compare restart");
+    if(ntp)
+        printf("       NTP: delay up to %g ms, jitter up to %g ms, asymmetry up to %g ms, loss up to %.0f%%, power-up +/-%g s off\n",
+               delayMs, jitterMs, asymMs, loss * 100, startError);
+
+    if(bench)
+    {
+        printf("%ld cores\n  jobs      wall   clock-days/s   speedup   per job\n", sysconf(_SC_NPROCESSORS_ONLN));
+        for(j=1; j<=jobs; j = (j < jobs && j * 2 > jobs) ? jobs : j * 2)
+        {
+            wall = runFleet(j);
+            if(j == 1)
+            {
+                one = wall;
+                print0 = fingerprint();
+            }
+            same = (fingerprint() == print0);
+            fail |= !same;
+            printf("  %4d %8.2f s %12.0f %9.2f %9.0f%s\n", j, wall, clocks * days / wall, one / wall,
+                   clocks * days / wall / j, same ? "" : "  DIFFERENT RESULTS");
+        }
+    }
+    else
+    {
+        wall = runFleet(jobs);
+        printf("%d jobs: %.2f s wall, %.0f clock-days/s\n", jobs, wall, clocks * days / wall);
+    }
+
+    printCurve();
+
+    for(n=0; n<clocks; n++)
+    {
+        const Result *r = &results[n];
+
+        if(!r->done)
+        {
+            crashed++;
+            continue;
+        }
+        lagMean.push_back(r->lagMeanTcy);
+        lagMax.push_back(r->lagMaxTcy);
+        if(!ntp)
+            continue;
+        unsynced += !r->synced;
+        stepped += (r->stepsAfterSync != 0);
+        skipped += (r->sequenceErrors != 0);
+        diverged += (r->worstUs > lockUs);
+        if(r->worstUs > worst)
+            worst = r->worstUs;
+    }
+    std::sort(lagMean.begin(), lagMean.end());
+    std::sort(lagMax.begin(), lagMax.end());
+    printf("tube lag (Timer0 match --> RCK, %s): mean p50 %.1f us, p99 %.1f us, worst second %.1f us\n",
+           preload ? "and lost every second" : "never adds up", percentile(lagMean, 50) / TCY_HZ * 1e6,
+           percentile(lagMean, 99) / TCY_HZ * 1e6, percentile(lagMax, 100) / TCY_HZ * 1e6);
+    if(ntp)
+        printf("NTP after %.0f h: worst %.1f us off (asymmetry taken off), %ld over %.0f us, %ld never synced, "
+               "%ld stepped after the first sync, %ld skipped or repeated a second\n",
+               SETTLE_SECS / 3600, worst, diverged, lockUs, unsynced, stepped, skipped);
+    if(crashed)
+        printf("%ld clocks crashed\n", crashed);
+
+    fail |= (crashed != 0) || (ntp && (unsynced || stepped || skipped || diverged || days * 86400 <= SETTLE_SECS));
+    if(ntp || bench || fail)
+        printf("%s\n", fail ? "FAIL" : "PASS");
+    return fail;
+}
@@ -0,0 +1,1014 @@
+/*
+ * File:        sim/nixie_sim.cpp
+ * Compiler:    g++ (host only)
+ *
+ * Info:    Peripheral models behind sim/xc.h (see nixie_sim.h).
+ *          Everything is event driven: the next Timer0 match, Timer1 overflow, Timer2 period (+ PWM3),
+ *          end of SPI byte, end of UART byte and stimulus edge are kept as absolute Tcy stamps,
+ *          so a SLEEP() jumps straight to the next one and a simulated week
+ *          is only a few hundred million register accesses.
+ */
+
+#include <stdio.h>
+#include <queue>
+#include <vector>
+#include "nixie_sim.h"
+#include "../Nixie_display.h"
+
+// One instance of every SFR proxy / bits union (they hold no state)
+#define SIM_SFR_DEF(n) SimSfr<SFR_##n> n;
+SIM_SFR_LIST(SIM_SFR_DEF)
+#undef SIM_SFR_DEF
+
+PORTCbits_t PORTCbits;
+LATCbits_t LATCbits;
+INTCONbits_t INTCONbits;
+PIE0bits_t PIE0bits;
+PIR0bits_t PIR0bits;
+PIE3bits_t PIE3bits;
+PIR3bits_t PIR3bits;
+PIE4bits_t PIE4bits;
+PIR4bits_t PIR4bits;
+T0CON0bits_t T0CON0bits;
+T0CON1bits_t T0CON1bits;
+SSP1CON1bits_t SSP1CON1bits;
+SSP1STATbits_t SSP1STATbits;
+CPUDOZEbits_t CPUDOZEbits;
+ADCON0bits_t ADCON0bits;
+NVMCON1bits_t NVMCON1bits;
+
+simCycle_t simNow = 0;
+simCycle_t simEnd = 0;
+SimStats simStats;
+void (*simOnLatch)(unsigned long long outputs, int tick, simCycle_t lag) = 0;
+void (*simOnUart)(unsigned char b) = 0;
+void (*simOnNvmWrite)(int row) = 0;
+unsigned short simSaf[SIM_SAF_WORDS];
+
+// A new chip: the SAF is erased (simReset() leaves it alone, it's what survives a power cut)
+static struct SafBlank
+{
+    SafBlank() { for(int i=0; i<SIM_SAF_WORDS; i++) simSaf[i] = SIM_SAF_BLANK; }
+} safBlank;
+
+#define NEVER               0x7FFFFFFFFFFFFFFFLL
+#define CHAIN_BYTES         ((DISPLAY_BITS + 7) / 8)   // TPIC6595s
+#define CHAIN_MASK          (~0ULL >> (64 - 8 * CHAIN_BYTES))
+
+// Bits the models care about
+#define GIE_BIT             0x80
+#define PEIE_BIT            0x40
+#define INTEDG_BIT          0x01
+#define TMR0IF_BIT          0x20
+#define IOCIF_BIT           0x10
+#define INTF_BIT            0x01
+#define SSP1IF_BIT          0x01
+#define TX1IF_BIT           0x10
+#define TXEN_BIT            0x20
+#define BRGH_BIT            0x04
+#define SPEN_BIT            0x80
+#define BRG16_BIT           0x08
+#define TMR1IF_BIT          0x01
+#define TMR2IF_BIT          0x02
+#define BF_BIT              0x01
+#define SSPEN_BIT           0x20
+#define SSPOV_BIT           0x40
+#define WCOL_BIT            0x80
+#define RCK_BIT             0x04    // RC2
+#define BUTTON_BIT          0x04    // RA2/INT
+#define ENCODER_BITS        0x18    // RC4, RC3
+#define G_BIT               0x20    // RC5
+#define PWM_OUT_PPS         0x0B    // RxyPPS code for PWM3OUT
+#define PWMEN_BIT           0x80
+#define PWMPOL_BIT          0x10
+#define ADON_BIT            0x01
+#define GO_BIT              0x02
+#define NVM_RD_BIT          0x01
+#define NVM_WR_BIT          0x02
+#define NVM_WREN_BIT        0x04
+#define NVM_WRERR_BIT       0x08
+#define NVM_FREE_BIT        0x10
+#define NVM_LWLO_BIT        0x20
+#define NVM_REGS_BIT        0x40
+
+static unsigned char sfr[SFR_COUNT];
+static unsigned char pinsA, pinsC;  // levels driven from outside
+
+// Timer0
+static int t0On;
+static simCycle_t t0Ps;             // Tcy per count
+static simCycle_t t0Base;           // when TMR0L was last 0
+static simCycle_t t0Next;           // next TMR0L == TMR0H --> 0 rollover
+static simCycle_t t0LastMatch;
+static unsigned char t0Frozen;      // TMR0L while stopped
+static unsigned char t0PostCount;
+
+// Timer1
+static int t1On;
+static simCycle_t t1Ps;
+static simCycle_t t1Base;           // when TMR1 was last 0
+static simCycle_t t1Next;           // next overflow
+static unsigned char t1HighLatch;   // RD16 buffer
+
+// Timer2
+static int t2On;
+static simCycle_t t2Ps;
+static simCycle_t t2Base;           // when T2TMR was last 0
+static simCycle_t t2Next;           // next T2TMR == T2PR --> 0
+static unsigned char t2PostCount;
+static unsigned int pwmDuty;        // PWM3 duty in force this period (loaded from PWM3DCH:DCL at each period)
+
+// ADC
+static unsigned char ambient;
+
+// Frame stream accounting
+static simCycle_t streamSince;      // when TMR2IE last went on
+
+// MSSP1 + TPIC6595 chain
+static simCycle_t spiDone;          // end of the byte shifting now, NEVER when idle
+static unsigned char spiByte;
+static unsigned long long chain;    // shift stage
+static unsigned long long outputs;  // output latch (what the tubes show)
+
+// EUSART1 transmitter
+static simCycle_t uartDone;         // stop bit of the byte in the shift register is out, NEVER when idle
+static unsigned char uartTsr;       // byte in the shift register
+static int uartFull;                // TX1REG holds a byte waiting for the shift register
+static unsigned char uartReg;
+
+// NVM (SAF only, anything else in program memory is an error)
+static unsigned short nvmLatch[SIM_SAF_ROW_WORDS];  // write latches, 0x3FFF = not loaded
+static int nvmUnlock;               // 0x55 then 0xAA written to NVMCON2 (2 = WR may go)
+static simCycle_t nvmStallFrom = NEVER, nvmStallTo = NEVER;    // the last erase / write
+
+// Stimulus
+struct Stim
+{
+    simCycle_t when;
+    unsigned long seq;
+    unsigned char port, mask, levels;
+    bool operator>(const Stim &o) const { return (when != o.when) ? (when > o.when) : (seq > o.seq); }
+};
+static std::priority_queue<Stim, std::vector<Stim>, std::greater<Stim> > stims;
+static unsigned long stimSeq;
+
+static simCycle_t nextEvent;
+static int inIsr;
+static unsigned char isrCause;      // PIR0 at ISR entry
+static int irqCheck;                // a flag or enable changed since the last look
+
+static void recalcNext(void)
+{
+    nextEvent = NEVER;
+    if(t0On && t0Next < nextEvent)
+        nextEvent = t0Next;
+    if(t1On && t1Next < nextEvent)
+        nextEvent = t1Next;
+    if(t2On && (sfr[SFR_PIE4] & TMR2IF_BIT) && t2Next < nextEvent)
+        nextEvent = t2Next;     // only an event while it can interrupt, t2CatchUp() does the rest
+    if(spiDone < nextEvent)
+        nextEvent = spiDone;
+    if(uartDone < nextEvent)
+        nextEvent = uartDone;
+    if(!stims.empty() && stims.top().when < nextEvent)
+        nextEvent = stims.top().when;
+}
+
+static void t0Schedule(void)
+{
+    t0Next = t0Base + ((simCycle_t)sfr[SFR_TMR0H] + 1) * t0Ps;
+    while(t0Next <= simNow)
+    {
+        // TMR0L already past the new TMR0H, it runs up to 255 and wraps first
+        t0Base += 256 * t0Ps;
+        t0Next = t0Base + ((simCycle_t)sfr[SFR_TMR0H] + 1) * t0Ps;
+    }
+}
+
+static unsigned char t0Count(void)
+{
+    if(!t0On)
+        return t0Frozen;
+    return (unsigned char)((simNow - t0Base) / t0Ps);
+}
+
+static unsigned int t1Count(void)
+{
+    if(!t1On)
+        return ((unsigned int)sfr[SFR_TMR1H] << 8) | sfr[SFR_TMR1L];
+    return (unsigned int)(((simNow - t1Base) / t1Ps) & 0xFFFF);
+}
+
+static unsigned char t2Count(void)
+{
+    if(!t2On)
+        return sfr[SFR_T2TMR];
+    return (unsigned char)((simNow - t2Base) / t2Ps);
+}
+
+static void t2Schedule(void)
+{
+    t2Next = t2Base + ((simCycle_t)sfr[SFR_T2PR] + 1) * t2Ps;
+    while(t2Next <= simNow)
+    {
+        t2Base += 256 * t2Ps;   // already past the new period, wraps at 255 first
+        t2Next = t2Base + ((simCycle_t)sfr[SFR_T2PR] + 1) * t2Ps;
+    }
+}
+
+// With TMR2IE off Timer2 is just the PWM period, ~1000 of them a second that nothing can see
+// until something looks: the periods that went by since are done here all at once, before any
+// access to a register they'd have changed (and before simBrightness()). Same PIR4, postscaler
+// and PWM duty as firing every one of them, without the events.
+static void t2CatchUp(void)
+{
+    simCycle_t period, n;
+    unsigned int post;
+
+    if(!t2On || t2Next > simNow)
+        return;
+    period = ((simCycle_t)sfr[SFR_T2PR] + 1) * t2Ps;
+    n = (simNow - t2Next) / period + 1;
+    t2Base = t2Next + (n - 1) * period;
+    pwmDuty = ((unsigned int)sfr[SFR_PWM3DCH] << 2) | (sfr[SFR_PWM3DCL] >> 6);
+    post = sfr[SFR_T2CON] & 0x0F;
+    if(t2PostCount + n > post)
+    {
+        sfr[SFR_PIR4] |= TMR2IF_BIT;
+        irqCheck = 1;
+    }
+    t2PostCount = (unsigned char)((t2PostCount + n) % (post + 1));
+    t2Schedule();
+}
+
+static void t2Touch(int r)
+{
+    switch(r)
+    {
+    case SFR_T2CON:
+    case SFR_T2TMR:
+    case SFR_T2PR:
+    case SFR_PIE4:
+    case SFR_PIR4:
+    case SFR_PWM3DCH:
+    case SFR_PWM3DCL:
+        t2CatchUp();
+        break;
+    }
+}
+
+// TX1IF: the transmitter is on and TX1REG is empty
+static void uartFlag(void)
+{
+    if((sfr[SFR_TX1STA] & TXEN_BIT) && !uartFull)
+        sfr[SFR_PIR3] |= TX1IF_BIT;
+    else
+        sfr[SFR_PIR3] &= (unsigned char)~TX1IF_BIT;
+    irqCheck = 1;
+}
+
+// 10 bits (start, 8 data, stop), Tcy per bit from the baud rate generator
+static void uartStart(unsigned char b)
+{
+    unsigned int brg = sfr[SFR_SP1BRGL];
+    simCycle_t bit;
+
+    if(sfr[SFR_BAUD1CON] & BRG16_BIT)
+        brg |= (unsigned int)sfr[SFR_SP1BRGH] << 8;
+    if((sfr[SFR_BAUD1CON] & BRG16_BIT) && (sfr[SFR_TX1STA] & BRGH_BIT))
+        bit = brg + 1;                      // Fosc / (4 (n+1))
+    else if((sfr[SFR_BAUD1CON] & BRG16_BIT) || (sfr[SFR_TX1STA] & BRGH_BIT))
+        bit = 4 * ((simCycle_t)brg + 1);    // Fosc / (16 (n+1))
+    else
+        bit = 16 * ((simCycle_t)brg + 1);   // Fosc / (64 (n+1))
+    uartTsr = b;
+    uartDone = simNow + 10 * bit;
+}
+
+static void applyPins(unsigned char port, unsigned char mask, unsigned char levels)
+{
+    unsigned char old, now, rise, fall;
+
+    if(port == 'A')
+    {
+        old = pinsA;
+        pinsA = (unsigned char)((pinsA & ~mask) | (levels & mask));
+        rise = (unsigned char)(~old & pinsA);
+        fall = (unsigned char)(old & ~pinsA);
+        if(((sfr[SFR_INTCON] & INTEDG_BIT) ? rise : fall) & BUTTON_BIT)
+            sfr[SFR_PIR0] |= INTF_BIT;
+    }
+    else
+    {
+        old = pinsC;
+        pinsC = (unsigned char)((pinsC & ~mask) | (levels & mask));
+        now = pinsC;
+        rise = (unsigned char)(~old & now);
+        fall = (unsigned char)(old & ~now);
+        sfr[SFR_IOCCF] |= (unsigned char)((rise & sfr[SFR_IOCCP]) | (fall & sfr[SFR_IOCCN]));
+    }
+    irqCheck = 1;
+}
+
+static void fireEvents(void)
+{
+    if(t0On && t0Next == simNow)
+    {
+        t0Base = t0Next;
+        t0LastMatch = simNow;
+        if(++t0PostCount > (sfr[SFR_T0CON0] & 0x0F))
+        {
+            t0PostCount = 0;
+            sfr[SFR_PIR0] |= TMR0IF_BIT;
+            irqCheck = 1;
+        }
+        t0Schedule();
+    }
+    if(t1On && t1Next == simNow)
+    {
+        t1Base = t1Next;
+        t1Next = t1Base + 65536 * t1Ps;
+        sfr[SFR_PIR4] |= TMR1IF_BIT;
+        irqCheck = 1;
+    }
+    if(t2On && t2Next == simNow)
+    {
+        t2Base = t2Next;
+        pwmDuty = ((unsigned int)sfr[SFR_PWM3DCH] << 2) | (sfr[SFR_PWM3DCL] >> 6);
+        if(++t2PostCount > (sfr[SFR_T2CON] & 0x0F))
+        {
+            t2PostCount = 0;
+            sfr[SFR_PIR4] |= TMR2IF_BIT;
+            irqCheck = 1;
+        }
+        t2Schedule();
+    }
+    if(spiDone == simNow)
+    {
+        chain = ((chain << 8) | spiByte) & CHAIN_MASK;
+        if(sfr[SFR_SSP1STAT] & BF_BIT)
+            sfr[SFR_SSP1CON1] |= SSPOV_BIT; // last byte never read out
+        sfr[SFR_SSP1STAT] |= BF_BIT;
+        sfr[SFR_PIR3] |= SSP1IF_BIT;
+        spiDone = NEVER;
+        simStats.spiBytes++;
+        irqCheck = 1;
+    }
+    if(uartDone == simNow)
+    {
+        simStats.uartBytes++;
+        if(simOnUart)
+            simOnUart(uartTsr);
+        uartDone = NEVER;
+        if(uartFull)
+        {
+            uartFull = 0;
+            uartStart(uartReg);
+        }
+        uartFlag();
+    }
+    while(!stims.empty() && stims.top().when == simNow)
+    {
+        Stim s = stims.top();
+        stims.pop();
+        if(s.port == 'V')
+            ambient = s.levels;
+        else
+            applyPins(s.port, s.mask, s.levels);
+    }
+}
+
+static void advance(simCycle_t n)
+{
+    simCycle_t target = simNow + n;
+
+    while(nextEvent <= target)
+    {
+        simNow = nextEvent;
+        fireEvents();
+        recalcNext();
+    }
+    simNow = target;
+}
+
+// Any enabled interrupt flag up (what wakes SLEEP, GIE or not)
+static int irqPending(void)
+{
+    unsigned char pir0 = (unsigned char)(sfr[SFR_PIR0] | (sfr[SFR_IOCCF] ? IOCIF_BIT : 0));
+
+    if(pir0 & sfr[SFR_PIE0] & (TMR0IF_BIT | IOCIF_BIT | INTF_BIT))
+        return 1;
+    if(sfr[SFR_INTCON] & PEIE_BIT)
+    {
+        if(sfr[SFR_PIR3] & sfr[SFR_PIE3])
+            return 1;
+        if(sfr[SFR_PIR4] & sfr[SFR_PIE4])
+            return 1;
+    }
+    return 0;
+}
+
+static void dispatch(void)
+{
+    simCycle_t enter;
+    int stream;
+
+    irqCheck = 0;
+    while((sfr[SFR_INTCON] & GIE_BIT) && irqPending())
+    {
+        inIsr = 1;
+        isrCause = sfr[SFR_PIR0];
+        stream = (sfr[SFR_PIR4] & sfr[SFR_PIE4] & TMR2IF_BIT) != 0;
+        sfr[SFR_INTCON] &= (unsigned char)~GIE_BIT;
+        enter = simNow;
+        if(stream)
+        {
+            simStats.streamIrqs++;
+            simStats.streamIrqAt = enter;
+        }
+        advance(3);     // interrupt latency + automatic context save
+        ISR_High();
+        advance(2);     // RETFIE
+        sfr[SFR_INTCON] |= GIE_BIT;
+        inIsr = 0;
+
+        simStats.isrCalls++;
+        simStats.isrCost.add(simNow - enter);
+        if(isrCause & TMR0IF_BIT)
+            simStats.tickIsrCost.add(simNow - enter);
+        if(stream)
+            simStats.streamIsrCost.add(simNow - enter);
+    }
+}
+
+// After every access from main() context: stop at simEnd, take interrupts
+static void afterAccess(void)
+{
+    if(inIsr)
+        return;
+    if(simNow >= simEnd)
+        throw SimStop();
+    if(irqCheck)
+        dispatch();
+}
+
+static void latch(void)
+{
+    if(spiDone != NEVER)
+        simStats.latchesWhileShifting++;
+    outputs = chain;
+    simStats.latches++;
+    if(simOnLatch)
+        // A tick latch is the Timer0 branch's, before it acks: a live frame's latch in the SPI branch
+        // of the same ISR call (both flags up at entry) isn't one
+        simOnLatch(outputs, inIsr && (isrCause & sfr[SFR_PIR0] & TMR0IF_BIT), simNow - t0LastMatch);
+    // The second's match came while the CPU was stalled on the flash, the RCK went out late
+    if(inIsr && (isrCause & TMR0IF_BIT) && t0LastMatch >= nvmStallFrom && t0LastMatch < nvmStallTo)
+        simStats.nvmLateRcks++;
+}
+
+static unsigned int nvmAddr(void)
+{
+    return ((unsigned int)(sfr[SFR_NVMADRH] & 0x7F) << 8) | sfr[SFR_NVMADRL];
+}
+
+// RD: the word is there the next cycle
+static void nvmRead(void)
+{
+    unsigned int w = nvmAddr() - SIM_SAF_BASE;
+
+    if((sfr[SFR_NVMCON1] & NVM_REGS_BIT) || w >= SIM_SAF_WORDS)
+    {
+        simStats.nvmErrors++;
+        w = 0;
+    }
+    sfr[SFR_NVMDATL] = (unsigned char)simSaf[w];
+    sfr[SFR_NVMDATH] = (unsigned char)(simSaf[w] >> 8);
+}
+
+// Erase / write: the CPU stops, the peripherals (and their interrupt flags) don't
+static void nvmStall(simCycle_t n)
+{
+    recalcNext();
+    nvmStallFrom = simNow;
+    advance(n);
+    nvmStallTo = simNow;
+    simStats.nvmStallCycles += n;
+}
+
+// WR: needs WREN and the unlock right before it, only the SAF, and interrupts off (one in the
+// middle of the unlock sequence would break it, and the firmware can't know when they do)
+static void nvmWrite(void)
+{
+    unsigned int w = nvmAddr() - SIM_SAF_BASE;
+    unsigned int row = w / SIM_SAF_ROW_WORDS;
+    unsigned int i;
+
+    if((nvmUnlock != 2) || !(sfr[SFR_NVMCON1] & NVM_WREN_BIT) || (sfr[SFR_NVMCON1] & NVM_REGS_BIT)
+       || w >= SIM_SAF_WORDS)
+    {
+        sfr[SFR_NVMCON1] |= NVM_WRERR_BIT;
+        simStats.nvmErrors++;
+        return;
+    }
+    if(sfr[SFR_INTCON] & GIE_BIT)
+        simStats.nvmErrors++;
+
+    if(sfr[SFR_NVMCON1] & NVM_FREE_BIT)
+    {
+        for(i=0; i<SIM_SAF_ROW_WORDS; i++)
+            simSaf[row * SIM_SAF_ROW_WORDS + i] = SIM_SAF_BLANK;
+        simStats.nvmErases++;
+        simStats.nvmRowErases[row]++;
+        nvmStall(SIM_NVM_ERASE_TCY);
+        return;
+    }
+
+    nvmLatch[w % SIM_SAF_ROW_WORDS] = (unsigned short)(((sfr[SFR_NVMDATH] << 8) | sfr[SFR_NVMDATL]) & SIM_SAF_BLANK);
+    if(sfr[SFR_NVMCON1] & NVM_LWLO_BIT)
+        return;     // only loading the latches
+
+    // Programming can only clear bits, a word that wasn't erased ends up the AND of both
+    for(i=0; i<SIM_SAF_ROW_WORDS; i++)
+    {
+        if(nvmLatch[i] == SIM_SAF_BLANK)
+            continue;
+        if(simSaf[row * SIM_SAF_ROW_WORDS + i] != SIM_SAF_BLANK)
+            simStats.nvmOverwrites++;
+        simSaf[row * SIM_SAF_ROW_WORDS + i] &= nvmLatch[i];
+        nvmLatch[i] = SIM_SAF_BLANK;
+    }
+    simStats.nvmWrites++;
+    nvmStall(SIM_NVM_WRITE_TCY);
+    if(simOnNvmWrite)
+        simOnNvmWrite((int)row);
+}
+
+static unsigned char readSfr(int r)
+{
+    unsigned int c;
+
+    switch(r)
+    {
+    case SFR_PORTA:
+        return (unsigned char)(pinsA & sfr[SFR_TRISA]);
+    case SFR_PORTC:
+        return (unsigned char)((sfr[SFR_LATC] & ~sfr[SFR_TRISC]) | (pinsC & sfr[SFR_TRISC]));
+    case SFR_PIR0:
+        return (unsigned char)(sfr[SFR_PIR0] | (sfr[SFR_IOCCF] ? IOCIF_BIT : 0));
+    case SFR_TMR0L:
+        return t0Count();
+    case SFR_TMR1L:
+        c = t1Count();
+        t1HighLatch = (unsigned char)(c >> 8);
+        return (unsigned char)c;
+    case SFR_T2TMR:
+        return t2Count();
+    case SFR_TMR1H:
+        if(sfr[SFR_T1CON] & 0x02)
+            return t1HighLatch;
+        return (unsigned char)(t1Count() >> 8);
+    case SFR_SSP1BUF:
+        sfr[SFR_SSP1STAT] &= (unsigned char)~BF_BIT;
+        return 0;   // nothing comes back from the TPIC6595s
+    default:
+        return sfr[r];
+    }
+}
+
+static void writeSfr(int r, unsigned char v)
+{
+    unsigned char old = sfr[r];
+    unsigned int c;
+
+    switch(r)
+    {
+    case SFR_PORTC:     // writes to PORT go to LAT
+        writeSfr(SFR_LATC, v);
+        return;
+    case SFR_LATC:
+        sfr[r] = v;
+        if((v & RCK_BIT) && !(old & RCK_BIT) && !(sfr[SFR_TRISC] & RCK_BIT))
+            latch();
+        return;
+    case SFR_PIR0:      // IOCIF is read only, it's the OR of the IOCxF flags
+        sfr[r] = (unsigned char)(v & ~IOCIF_BIT);
+        break;
+    case SFR_PIR3:      // so is TX1IF (only a TX1REG write clears it)
+        sfr[r] = (unsigned char)((v & ~TX1IF_BIT) | (old & TX1IF_BIT));
+        break;
+    case SFR_TX1STA:
+        sfr[r] = v;
+        uartFlag();
+        break;
+    case SFR_TX1REG:
+        if(!(sfr[SFR_TX1STA] & TXEN_BIT) || !(sfr[SFR_RC1STA] & SPEN_BIT))
+            break;
+        if(uartDone == NEVER)
+            uartStart(v);       // straight through to the shift register
+        else if(!uartFull)
+        {
+            uartFull = 1;
+            uartReg = v;
+        }
+        else
+            simStats.uartOverruns++;
+        uartFlag();
+        break;
+    case SFR_TMR0L:
+        if(t0On)
+        {
+            t0Base = simNow - (simCycle_t)v * t0Ps;
+            t0Schedule();
+        }
+        else
+            t0Frozen = v;
+        t0PostCount = 0;
+        break;
+    case SFR_TMR0H:
+        sfr[r] = v;
+        if(t0On)
+            t0Schedule();
+        break;
+    case SFR_T0CON1:
+        c = t0Count();
+        sfr[r] = v;
+        t0Ps = (simCycle_t)1 << (v & 0x0F);  // only Fosc/4 (T0CS = 010) is modelled
+        if(t0On)
+        {
+            t0Base = simNow - (simCycle_t)c * t0Ps;
+            t0Schedule();
+        }
+        break;
+    case SFR_T0CON0:
+        sfr[r] = v;
+        if((v & 0x80) && !t0On)
+        {
+            t0On = 1;
+            t0Base = simNow - (simCycle_t)t0Frozen * t0Ps;
+            t0Schedule();
+        }
+        else if(!(v & 0x80) && t0On)
+        {
+            t0Frozen = t0Count();
+            t0On = 0;
+        }
+        break;
+    case SFR_T1CON:
+        c = t1Count();
+        sfr[r] = v;
+        t1Ps = (simCycle_t)1 << ((v >> 4) & 3);  // only Fosc/4 (T1CLK = 0001) is modelled
+        if(v & 0x01)
+        {
+            t1On = 1;
+            t1Base = simNow - (simCycle_t)c * t1Ps;
+            t1Next = t1Base + 65536 * t1Ps;
+        }
+        else
+        {
+            sfr[SFR_TMR1H] = (unsigned char)(c >> 8);
+            sfr[SFR_TMR1L] = (unsigned char)c;
+            t1On = 0;
+        }
+        break;
+    case SFR_TMR1L:
+    case SFR_TMR1H:
+        sfr[r] = v;
+        if(t1On)
+        {
+            // RD16 writes land together on the TMR1L write, close enough for a count reset
+            c = ((unsigned int)sfr[SFR_TMR1H] << 8) | sfr[SFR_TMR1L];
+            t1Base = simNow - (simCycle_t)c * t1Ps;
+            t1Next = t1Base + 65536 * t1Ps;
+        }
+        break;
+    case SFR_T2CON:     // only Fosc/4 (T2CLKCON = 0001), free running (T2HLT = 0) is modelled
+        c = t2Count();
+        sfr[r] = v;
+        t2Ps = (simCycle_t)1 << ((v >> 4) & 7);
+        t2PostCount = 0;    // a T2CON write clears the pre/postscaler
+        t2On = (v & 0x80) != 0;
+        if(t2On)
+        {
+            t2Base = simNow - (simCycle_t)c * t2Ps;
+            t2Schedule();
+        }
+        else
+            sfr[SFR_T2TMR] = (unsigned char)c;
+        break;
+    case SFR_T2TMR:     // so does a T2TMR write
+        sfr[r] = v;
+        t2PostCount = 0;
+        if(t2On)
+        {
+            t2Base = simNow - (simCycle_t)v * t2Ps;
+            t2Schedule();
+        }
+        break;
+    case SFR_T2PR:
+        sfr[r] = v;
+        if(t2On)
+            t2Schedule();
+        break;
+    case SFR_PIE4:
+        sfr[r] = v;
+        if((v & TMR2IF_BIT) && !(old & TMR2IF_BIT))
+            streamSince = simNow;
+        else if(!(v & TMR2IF_BIT) && (old & TMR2IF_BIT))
+            simStats.streamCycles += simNow - streamSince;
+        break;
+    case SFR_NVMCON2:   // unlock: 0x55, 0xAA, then set WR
+        nvmUnlock = (v == 0x55) ? 1 : ((v == 0xAA && nvmUnlock == 1) ? 2 : 0);
+        return;
+    case SFR_NVMCON1:   // RD and WR clear themselves (WR once the stall is over)
+        sfr[r] = (unsigned char)(v & ~(NVM_RD_BIT | NVM_WR_BIT));
+        if(v & NVM_RD_BIT)
+            nvmRead();
+        if((v & NVM_WR_BIT) && !(old & NVM_WR_BIT))
+            nvmWrite();
+        nvmUnlock = 0;
+        return;
+    case SFR_ADCON0:    // conversion done as soon as it starts, nothing waits on it anyway
+        sfr[r] = v;
+        if((v & (ADON_BIT | GO_BIT)) == (ADON_BIT | GO_BIT))
+        {
+            sfr[SFR_ADRESH] = ambient;
+            sfr[SFR_ADRESL] = 0;
+            sfr[r] &= (unsigned char)~GO_BIT;
+        }
+        break;
+    case SFR_SSP1BUF:
+        if(!(sfr[SFR_SSP1CON1] & SSPEN_BIT))
+            break;
+        if(spiDone != NEVER)
+        {
+            sfr[SFR_SSP1CON1] |= WCOL_BIT;
+            simStats.spiCollisions++;
+            break;
+        }
+        spiByte = v;
+        switch(sfr[SFR_SSP1CON1] & 0x0F)
+        {
+        case 0x0:   spiDone = simNow + 8 * 1;   break;  // Fosc/4, 1 Tcy per bit
+        case 0x1:   spiDone = simNow + 8 * 4;   break;  // Fosc/16
+        case 0x2:   spiDone = simNow + 8 * 16;  break;  // Fosc/64
+        default:    spiDone = simNow + 8 * ((simCycle_t)sfr[SFR_SSP1ADD] + 1); break; // Fosc/(4*(SSPADD+1))
+        }
+        break;
+    default:
+        sfr[r] = v;
+        break;
+    }
+    irqCheck = 1;
+}
+
+unsigned char simRead(int r)
+{
+    unsigned char v;
+
+    advance(1);
+    t2Touch(r);
+    v = readSfr(r);
+    afterAccess();
+    return v;
+}
+
+void simWrite(int r, unsigned char v)
+{
+    advance(1);
+    t2Touch(r);
+    writeSfr(r, v);
+    recalcNext();
+    afterAccess();
+}
+
+void simBitWrite(int r, unsigned char mask, unsigned char bits)
+{
+    advance(1);
+    t2Touch(r);
+    writeSfr(r, (unsigned char)((sfr[r] & ~mask) | bits));
+    recalcNext();
+    afterAccess();
+}
+
+void simNop(void)
+{
+    advance(1);
+    afterAccess();
+}
+
+void simSleep(void)
+{
+    simCycle_t start;
+
+    advance(1);
+    start = simNow;
+    while(!irqPending())
+    {
+        if(nextEvent >= simEnd)
+        {
+            simStats.sleepCycles += simEnd - start;
+            simNow = simEnd;
+            throw SimStop();
+        }
+        advance(nextEvent - simNow);
+    }
+    simStats.sleepCycles += simNow - start;
+    if(sfr[SFR_PIE4] & TMR2IF_BIT)
+        simStats.streamSleepCycles += simNow - start;
+    afterAccess();
+}
+
+void simPinsA(simCycle_t when, unsigned char mask, unsigned char levels)
+{
+    Stim s = { when, stimSeq++, 'A', mask, levels };
+    stims.push(s);
+    recalcNext();
+}
+
+void simPinsC(simCycle_t when, unsigned char mask, unsigned char levels)
+{
+    Stim s = { when, stimSeq++, 'C', mask, levels };
+    stims.push(s);
+    recalcNext();
+}
+
+void simAmbient(simCycle_t when, unsigned char level)
+{
+    Stim s = { when, stimSeq++, 'V', 0, level };
+    stims.push(s);
+    recalcNext();
+}
+
+int simBrightness(void)
+{
+    unsigned int period = 4 * ((unsigned int)sfr[SFR_T2PR] + 1);
+    unsigned int on;
+
+    t2CatchUp();
+    if(sfr[SFR_TRISC] & G_BIT)
+        return 0;   // pulled up
+    if(sfr[SFR_RC5PPS] != PWM_OUT_PPS)
+        return (sfr[SFR_LATC] & G_BIT) ? 0 : 1000;
+    if(!(sfr[SFR_PWM3CON] & PWMEN_BIT) || !t2On)
+        return (sfr[SFR_PWM3CON] & PWMPOL_BIT) ? 1000 : 0;  // output parked at its inactive level
+    on = (pwmDuty < period) ? pwmDuty : period;     // high for the duty part...
+    if(!(sfr[SFR_PWM3CON] & PWMPOL_BIT))
+        on = period - on;                           // ...which is G off unless it's inverted
+    return (int)(on * 1000 / period);
+}
+
+void simHalt(void)
+{
+    sfr[SFR_PIE0] = 0;
+    sfr[SFR_PIE3] = 0;
+    sfr[SFR_PIE4] = 0;
+    simEnd = NEVER;
+}
+
+void simReset(void)
+{
+    int i;
+
+    for(i=0; i<SFR_COUNT; i++)
+        sfr[i] = 0;
+    sfr[SFR_TRISA] = 0xFF;  // POR: everything an input
+    sfr[SFR_TRISC] = 0xFF;
+    pinsA = BUTTON_BIT;     // push button pulled up
+    pinsC = 0;              // encoder sitting on a 00 detent
+    t0On = t1On = t2On = 0;
+    t0Ps = t1Ps = t2Ps = 1;
+    t2PostCount = 0;
+    pwmDuty = 0;
+    ambient = 255;
+    t0Frozen = t0PostCount = 0;
+    t0LastMatch = 0;
+    spiDone = NEVER;
+    uartDone = NEVER;
+    uartFull = 0;
+    chain = outputs = 0;
+    for(i=0; i<SIM_SAF_ROW_WORDS; i++)
+        nvmLatch[i] = SIM_SAF_BLANK;
+    nvmUnlock = 0;
+    nvmStallFrom = nvmStallTo = NEVER;
+    while(!stims.empty())
+        stims.pop();
+    stimSeq = 0;
+    simNow = 0;
+    inIsr = 0;
+    irqCheck = 0;
+    simStats = SimStats();
+    recalcNext();
+}
+
+// The chain, from DISPLAY_FIELDS: lowest bit, cathodes, which tube (-1 = a neon)
+struct SimField
+{
+    int at, cathodes, tube;
+};
+
+#define SIM_FIELD(name, n, shows, a)    { DISPLAY_##name##_AT, n, DISPLAY_DIGIT_##shows },
+static const SimField simFields[] = { DISPLAY_FIELDS(SIM_FIELD, 0) };
+#define SIM_FIELDS          (int)(sizeof(simFields) / sizeof(simFields[0]))
+
+// The checks are all about the time going up second by second, so every digit has to be there
+#define SIM_HAS(name, n, shows, a)      | ((DISPLAY_DIGIT_##shows >= 0) ? (1 << DISPLAY_DIGIT_##shows) : 0)
+static_assert((0 DISPLAY_FIELDS(SIM_HAS, 0)) == (1 << SIM_TUBES) - 1,
+              "the simulator needs all six time digits on the chain (DISPLAY_FIELDS)");
+
+int simTubeCathodes(int tube)
+{
+    int f;
+
+    for(f=0; f<SIM_FIELDS; f++)
+        if(simFields[f].tube == tube)
+            return simFields[f].cathodes;
+    return 0;
+}
+
+int simDecode(unsigned long long out, int digit[SIM_TUBES])
+{
+    int bad = 0;
+    int tube, f, i;
+    int lit[SIM_TUBES];
+    unsigned int field;
+
+    for(tube=0; tube<SIM_TUBES; tube++)
+    {
+        digit[tube] = -1;
+        lit[tube] = 0;
+    }
+    for(f=0; f<SIM_FIELDS; f++)
+    {
+        field = (unsigned int)(out >> simFields[f].at) & ((1u << simFields[f].cathodes) - 1);
+        tube = simFields[f].tube;
+        if(tube < 0)
+        {
+            if(field != 1)  // a neon is always on
+                bad++;
+            continue;
+        }
+        for(i=0; i<simFields[f].cathodes; i++)
+        {
+            if(field & (1u << i))
+            {
+                digit[tube] = i;
+                lit[tube]++;
+            }
+        }
+    }
+    for(tube=0; tube<SIM_TUBES; tube++)
+    {
+        if(lit[tube] > 1)
+            digit[tube] = -2;
+        if(lit[tube] != 1)
+            bad++;
+    }
+    if(out & ~(~0ULL >> (64 - DISPLAY_BITS)))    // outputs past the last field, wired to nothing
+        bad++;
+    return bad;
+}
+
+SimHist::SimHist() : count(0), sum(0), min(0), max(0)
+{
+    int i;
+
+    for(i=0; i<48; i++)
+        bucket[i] = 0;
+}
+
+void SimHist::add(long long v)
+{
+    int i = 0;
+
+    if(count == 0 || v < min)
+        min = v;
+    if(count == 0 || v > max)
+        max = v;
+    count++;
+    sum += (unsigned long long)v;
+    while(i < 47 && v >= (1LL << i))
+        i++;
+    bucket[i]++;
+}
+
+void SimHist::print(const char *name, const char *unit) const
+{
+    int i;
+
+    if(count == 0)
+    {
+        printf("%s: none\n", name);
+        return;
+    }
+    printf("%s: n=%llu min=%lld avg=%.1f max=%lld %s\n", name, count, min, (double)sum / count, max, unit);
+    for(i=0; i<48; i++)
+    {
+        if(bucket[i] == 0)
+            continue;
+        if(i == 0)
+            printf("    %10d         : %llu\n", 0, bucket[i]);
+        else
+            printf("    %10lld - %-8lld: %llu\n", 1LL << (i - 1), (1LL << i) - 1, bucket[i]);
+    }
+}
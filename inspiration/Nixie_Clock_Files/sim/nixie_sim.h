@@ -0,0 +1,147 @@
+/*
+ * File:        sim/nixie_sim.h
+ * Compiler:    g++ (host only)
+ *
+ * Info:    Host simulator for the Nixie clock firmware.
+ *
+ *          The firmware sources are built unmodified as C++ against sim/xc.h,
+ *          main() is renamed firmwareMain() and ISR_High() becomes a plain function.
+ *          Simulated time (simNow, in Tcy = 325.5ns) only moves when the firmware
+ *          touches an SFR (1 Tcy each), executes NOP(), takes an interrupt
+ *          (5 Tcy of entry/RETFIE overhead), or sleeps (skips straight to the next
+ *          peripheral event). Plain C between SFR accesses is free, so this is not
+ *          a cycle count: every code timing it reports (ISR cost, timer match -> RCK,
+ *          CPU per frame, scheduler latency) is an SFR-access lower bound, labelled
+ *          SIM_TCY_LB in the report. What the timers and the MSSP do on their own
+ *          (periods, shift times, the RCK spacing) is modelled to the Tcy.
+ *          So the peripherals are cycle-level, the firmware isn't. Closing that gap needs
+ *          real instruction costs, i.e. XC8's listing (cycles per function or per basic
+ *          block, charged with an advance() at its entry), and there's no XC8 here to
+ *          produce one. Until then, read every ISR and latency figure as "at least".
+ *
+ *          Modelled peripherals (only what the clock uses):
+ *              Timer0      8-bit compare mode (TMR0L runs up to TMR0H), Fosc/4, prescaler, postscaler
+ *              Timer1      16-bit, Fosc/4, prescaler, RD16 buffered TMR1H
+ *              Timer2      8-bit period (T2PR), Fosc/4, prescaler, postscaler --> TMR2IF
+ *              PWM3        off Timer2, duty loaded at each period (double buffered), on RC5 = TPIC6595 G
+ *              ADC         one channel, GO --> ADRESH = the light level from --ambient, instantly
+ *              MSSP1       SPI master, SSPM clock select, BF/SSP1IF/WCOL/SSPOV, one byte at a time
+ *              EUSART1     transmitter only: TX1REG + shift register, baud from SP1BRG/BRG16/BRGH,
+ *                          TX1IF = room in TX1REG, every byte handed to simOnUart when its stop bit is out
+ *              NVM         the Storage Area Flash (simSaf, kept across simReset(), i.e. a power cut):
+ *                          NVMCON2 unlock, row erase, write latches + row write, the CPU stalled 2.5ms
+ *                          (datasheet max) for each while the timers run on. Counts an error for a WR
+ *                          without the unlock / WREN, outside the SAF or with GIE on, a write over a word
+ *                          that wasn't erased, and a second's RCK held up by a stall
+ *              RC2 (RCK)   rising edge latches the TPIC6595 chain onto the tubes
+ *              TPIC6595s   FRAME_BYTES x 8-bit shift chain + output latch, decoded back into tube
+ *                          digits (and neons) by the fields Nixie_display.h declares
+ *              IOC RC3/RC4 quadrature encoder inputs, INT (RA2) push button
+ *              IDLE        SLEEP() with IDLEN, wakes on any enabled interrupt flag
+ */
+
+#ifndef NIXIE_SIM_H
+#define NIXIE_SIM_H
+
+#include <xc.h>
+
+#define SIM_FOSC            12288000LL
+#define SIM_TCY_PER_SEC     (SIM_FOSC / 4)  // 3,072,000
+#define SIM_TCY_LB          "Tcy (SFR-access lower bound)"  // unit of every code timing in the report
+#define SIM_TUBES           6
+
+typedef long long simCycle_t;
+
+#define SIM_SAF_BASE        0x1F80          // Storage Area Flash, the last 128 words
+#define SIM_SAF_WORDS       128
+#define SIM_SAF_ROW_WORDS   32
+#define SIM_SAF_ROWS        (SIM_SAF_WORDS / SIM_SAF_ROW_WORDS)
+#define SIM_SAF_BLANK       0x3FFF          // an erased 14-bit word
+#define SIM_NVM_ERASE_TCY   (SIM_TCY_PER_SEC * 25 / 10000)  // 2.5ms
+#define SIM_NVM_WRITE_TCY   (SIM_TCY_PER_SEC * 25 / 10000)
+
+struct SimStop {};              // thrown into the firmware when simEnd is reached
+
+// Histogram of non-negative values, power of 2 buckets
+struct SimHist
+{
+    unsigned long long count, sum;
+    long long min, max;
+    unsigned long long bucket[48];  // [0] = 0, [i] = 2^(i-1) .. 2^i - 1
+
+    SimHist();
+    void add(long long v);
+    void print(const char *name, const char *unit) const;
+};
+
+struct SimStats
+{
+    unsigned long long isrCalls;
+    unsigned long long latches;             // RCK rising edges
+    unsigned long long latchesWhileShifting;// RCK while the MSSP was mid-byte (half a frame on the tubes)
+    unsigned long long spiBytes;
+    unsigned long long spiCollisions;       // SSP1BUF written while a byte was still shifting (WCOL)
+    unsigned long long uartBytes;           // EUSART bytes sent
+    unsigned long long uartOverruns;        // TX1REG written while it was still full (byte lost)
+    simCycle_t sleepCycles;                 // Tcy spent in IDLE
+    SimHist isrCost;                        // Tcy per ISR_High() call, entry to RETFIE
+    SimHist tickIsrCost;                    // same, only the calls Timer0 was pending for
+    SimHist streamIsrCost;                  // same, only the calls Timer2 was pending for
+    unsigned long long streamIrqs;          // ISR_High() calls Timer2 was pending for
+    simCycle_t streamIrqAt;                 // ISR entry of the last one
+    simCycle_t streamCycles;                // Tcy with the Timer2 interrupt enabled (a frame stream running)
+    simCycle_t streamSleepCycles;           // Tcy of those spent in IDLE
+    unsigned long long nvmErases, nvmWrites;// SAF row erases, row writes
+    unsigned long long nvmRowErases[SIM_SAF_ROWS];
+    unsigned long long nvmErrors;           // see NVM above
+    unsigned long long nvmOverwrites;       // words programmed without an erase
+    unsigned long long nvmLateRcks;         // second's Timer0 match while the CPU was stalled on the flash
+    simCycle_t nvmStallCycles;
+};
+
+extern simCycle_t simNow;       // Tcy since reset
+extern simCycle_t simEnd;       // firmwareMain() gets a SimStop at this point
+extern SimStats simStats;
+
+// Called on every RCK rising edge
+//      outputs = the TPIC6595 outputs (chain bit 0 = last bit shifted in, see Nixie_display.h)
+//      tick    = 1 if the RCK came from the Timer0 interrupt, lag = Tcy since that Timer0 match
+extern void (*simOnLatch)(unsigned long long outputs, int tick, simCycle_t lag);
+
+// Called for every byte the EUSART finished sending
+extern void (*simOnUart)(unsigned char b);
+
+// Called after every SAF row write (not the erases), once the stall is over
+extern void (*simOnNvmWrite)(int row);
+
+// The SAF, erased at start-up, simReset() leaves it alone
+extern unsigned short simSaf[SIM_SAF_WORDS];
+
+void simReset(void);
+
+// After the SimStop: every interrupt masked and no more simEnd, so the report can call into the
+// firmware (functions that take GIE off and on) without it running on or stopping again
+void simHalt(void);
+
+// Stimulus (pin levels from outside), applied at the given Tcy
+void simPinsA(simCycle_t when, unsigned char mask, unsigned char levels);
+void simPinsC(simCycle_t when, unsigned char mask, unsigned char levels);
+void simAmbient(simCycle_t when, unsigned char level);     // light sensor, 0 = dark, 255 = bright
+
+// Fraction of the time the TPIC6595 outputs are enabled (G low), in 1/1000ths
+// PWM3 if it's on RC5, otherwise G follows LATC5 (or the pull-up, dark, while RC5 is an input)
+int simBrightness(void);
+
+// TPIC6595 outputs --> tube digits, -1 = tube dark, -2 = more than one cathode lit
+// returns the number of tubes that aren't showing exactly one digit (+1 for a neon that's off,
+// +1 for anything lit past the last field)
+int simDecode(unsigned long long outputs, int digit[SIM_TUBES]);
+
+// Cathodes tube (0 = H1 ... 5 = S0) has
+int simTubeCathodes(int tube);
+
+// The firmware, built against sim/xc.h
+void firmwareMain(void);
+void ISR_High(void);
+
+#endif // NIXIE_SIM_H
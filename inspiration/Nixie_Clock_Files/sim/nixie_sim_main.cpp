@@ -0,0 +1,708 @@
+/*
+ * File:        sim/nixie_sim_main.cpp
+ * Compiler:    g++ (host only)
+ *
+ * Info:    Command line driver for the host simulator (see nixie_sim.h).
+ *
+ *          Runs the firmware for a stretch of simulated time with optional button
+ *          pushes and encoder turns, checks every frame that reaches the tubes, and
+ *          prints latch timing, ISR timing histograms and how much faster than
+ *          real time it all ran.
+ *
+ *          nixie_sim [--seconds N] [--days N] [--press T] [--turn T:N] [--detent-ms MS] [--ambient T:L]
+ *                    [--power-off T:D] [--fuzz SEED] [--telem FILE] [--trace]
+ *              --press T       push the encoder button at T seconds
+ *              --turn T:N      turn the encoder N detents at T seconds (N < 0 = CCW)
+ *              --detent-ms MS  time between detents of a --turn (default 30)
+ *              --ambient T:L   light sensor to L (0 dark - 255 bright, 255 at reset) at T seconds
+ *              --power-off T:D power cut at T seconds for D seconds (the stimulus times stay absolute,
+ *                              whatever falls into a cut is lost)
+ *              --fuzz SEED     random button pushes, knob turns (any speed, some edges bouncing) and light
+ *                              levels all the way through, on top of the ones given (make frame-check)
+ *              --telem FILE    everything the telemetry UART sent (Nixie_telem.h), for telem_decode
+ *              --trace         print every latch
+ *
+ *          Anti-poisoning bursts (Nixie_slot.h) are told apart from the time by their frames, and
+ *          reported on their own: frame spacing, how long before the next RCK the time was back,
+ *          cathode coverage, and the Timer0 match --> RCK lag of just the seconds that had a burst.
+ *          Crossfade frames (Nixie_dim.h) have to be the second before or the new one, and the new
+ *          one has to be up before the next RCK. For the whole frame stream: Timer2 --> RCK (the SPI
+ *          bound on the refresh rate) and CPU time per frame (the CPU bound), see make refresh-bench.
+ *          Code timings are SFR-access lower bounds (nixie_sim.h), so those refresh limits are upper bounds.
+ *          Brightness is the G duty at every second's RCK.
+ *
+ *          Power cuts: every stretch of power runs in a process of its own (fork()), so the firmware's
+ *          RAM and the simulator's start from scratch each time, just like the real thing. Only the SAF
+ *          (Nixie_persist.h) and the bookkeeping in Carry get across, through a pipe. Each power-up is
+ *          reported: how long until the first time is on the tubes, whether it's the one saved last,
+ *          and how far behind the true time it is (the time the clock had, plus the time it was off).
+ *          The SAF wear is totted up over all of them.
+ *
+ *          Exit status is 1 if anything went wrong on the tubes (bad frame, a second
+ *          skipped or repeated, a missed latch, a stream frame skipped, a cathode
+ *          never lit by the slot frames, a crossfade frame that isn't one of its two
+ *          seconds or one left up at the RCK, a flash erase/write done wrong or in the way of an RCK,
+ *          a power-up that takes over a second to show a time, or shows another than the one saved),
+ *          so it works as a regression check.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include <chrono>
+#include "nixie_sim.h"
+#include "../Nixie_config.h"
+#include "../Nixie_sched.h"
+#include "../Nixie_frame.h"
+#include "../Nixie_slot.h"
+#include "../Nixie_dim.h"
+#include "../Nixie_telem.h"
+#include "../Nixie_persist.h"
+#include "../Nixie_power.h"
+
+// Firmware state worth reporting
+extern unsigned char frameLate;
+extern unsigned char latchLagMax;
+extern unsigned int schedLatencyMax[EVT_CLASSES];
+
+#define SECS(s)             ((simCycle_t)((s) * (double)SIM_TCY_PER_SEC))
+#define TMR1_TCY            8       // Timer1 runs at Fosc/4 / 8
+
+#if CLOCK_24_HOUR
+#define DAY_SECS            (24L * 3600)
+#else
+#define DAY_SECS            (12L * 3600)
+#endif
+
+static int trace = 0;
+static long shown = -1;             // seconds of the day on the tubes (or fading in), -1 = nothing valid yet
+static simCycle_t lastTickLatch = -1;
+static unsigned long long tickLatches, liveLatches, badFrames, sequenceErrors;
+static SimHist tickLag;             // Timer0 match --> RCK edge
+static SimHist tickJitter;          // |RCK to RCK - 1sec|
+#if SLOT_ENABLE
+static unsigned long long slotLatches;
+static unsigned long long slotLit[SIM_TUBES][10];   // slot frames each cathode was lit in
+static simCycle_t slotLast = -1;    // last slot frame latch
+static SimHist slotPeriod;          // slot frame to slot frame, within a burst
+static SimHist slotMargin;          // last slot frame of a burst --> the next tick RCK
+static SimHist slotTickLag;         // timer match -> RCK, only the seconds that had a burst
+
+// One of the anti-poisoning frames?
+static int isSlotFrame(unsigned long long outputs)
+{
+    int k, i;
+
+    for(k=0; k<SLOT_FRAMES; k++)
+    {
+        for(i=0; i<FRAME_BYTES; i++)
+            if(slotFrames[k][i] != (unsigned char)(outputs >> (8 * (FRAME_BYTES - 1 - i))))
+                break;
+        if(i == FRAME_BYTES)
+            return 1;
+    }
+    return 0;
+}
+#endif
+
+#if FADE_ENABLE
+static long fadePrev = -1;          // the second before the one on the tubes
+static int fadeOldUp = 0;           // last crossfade frame was the old second
+static int fadeFromOld = 0;         // the last tick RCK latched the second before again (fadeArmed)
+static simCycle_t fadeLast = -1;    // last crossfade frame latch
+static unsigned long long fadeOld, fadeNew, fadeBad, fadeStuck;
+static SimHist fadeSpan;            // tick RCK --> last crossfade frame
+static SimHist fadeMargin;          // last crossfade frame --> next tick RCK
+#endif
+#if STREAM_ENABLE
+static int streamKind = STREAM_IDLE;    // the stream a STREAM_DONE latch came from
+static unsigned long long streamLatches;
+static SimHist streamShift;         // Timer2 interrupt --> RCK of the frame it started
+#endif
+static int brightMin = 1000, brightMax = -1;
+static unsigned long long brightChanges;
+static int brightLast = -1;
+
+static FILE *telemFile = 0;
+
+// What crosses a power cut, from the process that ran a stretch back to the parent
+struct Carry
+{
+    unsigned short saf[SIM_SAF_WORDS];
+    unsigned long long rowErases[SIM_SAF_ROWS];
+    unsigned long long saves;
+    double powered;                 // seconds
+    long saved;                     // seconds of the day the last save had, -1 = nothing saved yet
+    double trueAtOff;               // true time when the power went (seconds of the day), -1 = unknown
+    double worstBootMs;
+    int fail;
+};
+static Carry carry;
+static simCycle_t firstTime = -1;   // first frame with a time on it, this stretch
+static long firstShown = -1;
+
+static void onNvmWrite(int row)
+{
+    (void)row;
+    carry.saved = shown;            // persistService() only saves with the tubes showing myTime
+}
+
+static void onUart(unsigned char b)
+{
+    if(telemFile)
+        fputc(b, telemFile);
+}
+
+// '-' = dark, '*' = more than one cathode lit
+static char tubeChar(int d)
+{
+    return (d >= 0) ? (char)('0' + d) : ((d == -1) ? '-' : '*');
+}
+
+static void onLatch(unsigned long long outputs, int tick, simCycle_t lag)
+{
+    int d[SIM_TUBES];
+    int bad = simDecode(outputs, d);
+    long secs = -1;
+    long hours;
+    int i;
+    int kind = STREAM_IDLE;     // which stream shifted this frame in, time frames can look like slot frames
+    int again = 0;              // a tick RCK that left the second before up for a crossfade to start from
+
+#if STREAM_ENABLE
+    if(!tick && streamState != STREAM_IDLE)
+    {
+        if(streamState != STREAM_DONE)
+            streamKind = streamState;
+        kind = streamKind;      // the stream stops in the ISR of its last frame
+        streamLatches++;
+        streamShift.add(simNow - simStats.streamIrqAt);
+    }
+#endif
+#if SLOT_ENABLE
+    if(kind == STREAM_SLOT && isSlotFrame(outputs))
+    {
+        slotLatches++;
+        for(i=0; i<SIM_TUBES; i++)
+            slotLit[i][d[i]]++;
+        if(slotLast >= 0 && simNow - slotLast < SIM_TCY_PER_SEC / 10)
+            slotPeriod.add(simNow - slotLast);
+        slotLast = simNow;
+        if(trace)
+            printf("%12.6fs  %c%c:%c%c:%c%c  slot\n", (double)simNow / SIM_TCY_PER_SEC,
+                   tubeChar(d[0]), tubeChar(d[1]), tubeChar(d[2]), tubeChar(d[3]), tubeChar(d[4]), tubeChar(d[5]));
+        return; // not a time, the sequence check carries on from what was up before
+    }
+    if(tick && slotLast >= 0 && simNow - slotLast < SIM_TCY_PER_SEC)
+    {
+        slotMargin.add(simNow - slotLast);
+        slotTickLag.add(lag);
+    }
+#endif
+    (void)i;
+    (void)kind;
+    
+    if(tick)
+    {
+        int b = simBrightness();
+        
+        if(b < brightMin)
+            brightMin = b;
+        if(b > brightMax)
+            brightMax = b;
+        if(brightLast >= 0 && b != brightLast)
+            brightChanges++;
+        brightLast = b;
+    }
+
+    if(bad == 0)
+    {
+        hours = d[0] * 10 + d[1];
+#if !CLOCK_24_HOUR
+        hours %= 12;    // 12 shows as 12, counts as 0
+#endif
+        secs = hours * 3600 + (d[2] * 10 + d[3]) * 60 + d[4] * 10 + d[5];
+    }
+    else if(outputs != 0)   // all dark is fine (power-up clear), anything else isn't
+        badFrames++;
+
+#if FADE_ENABLE
+    // Crossfade frame: the second before or the new one, nothing else, only after an RCK that left
+    // the second before up (one that put the new one up first would flash it at full before the fade),
+    // and the sequence check carries on from the new one
+    if(kind == STREAM_FADE)
+    {
+        if(!fadeFromOld)
+            fadeBad++;
+        else if(secs >= 0 && secs == fadePrev)
+        {
+            fadeOld++;
+            fadeOldUp = 1;
+        }
+        else if(secs >= 0 && secs == shown)
+        {
+            fadeNew++;
+            fadeOldUp = 0;
+        }
+        else
+            fadeBad++;
+        fadeLast = simNow;
+        if(trace)
+            printf("%12.6fs  %c%c:%c%c:%c%c  fade\n", (double)simNow / SIM_TCY_PER_SEC,
+                   tubeChar(d[0]), tubeChar(d[1]), tubeChar(d[2]), tubeChar(d[3]), tubeChar(d[4]), tubeChar(d[5]));
+        return;
+    }
+    if(tick)
+    {
+        if(fadeOldUp)
+            fadeStuck++;    // the RCK came with the second before still up
+        fadeOldUp = 0;
+        if(fadeLast > lastTickLatch && lastTickLatch >= 0)
+        {
+            fadeSpan.add(fadeLast - lastTickLatch);
+            fadeMargin.add(simNow - fadeLast);
+        }
+        fadePrev = shown;
+        again = fadeArmed;
+        fadeFromOld = again;
+        fadeOldUp = again;  // a fade or a live frame has to put the new second up before the next RCK
+    }
+    else
+        fadeOldUp = 0;      // a live frame (an edit, or the time going back on) replaces it
+#endif
+
+    if(tick)
+    {
+        tickLatches++;
+        tickLag.add(lag);
+        if(lastTickLatch >= 0)
+            tickJitter.add(llabs(simNow - lastTickLatch - SIM_TCY_PER_SEC));
+        lastTickLatch = simNow;
+
+        // Every second boundary shows exactly one second more than what was up before
+        // (or the same one again, a crossfade brings the new one in)
+        if(shown >= 0 && secs != (shown + 1 - again) % DAY_SECS)
+            sequenceErrors++;
+    }
+    else
+        liveLatches++;
+
+    if(trace)
+        printf("%12.6fs  %c%c:%c%c:%c%c  %s  lag %lld Tcy\n", (double)simNow / SIM_TCY_PER_SEC,
+               tubeChar(d[0]), tubeChar(d[1]), tubeChar(d[2]), tubeChar(d[3]), tubeChar(d[4]), tubeChar(d[5]),
+               tick ? "tick" : "live", tick ? lag : 0);
+
+    if(secs >= 0)
+    {
+        shown = (secs + again) % DAY_SECS;
+        if(firstTime < 0)
+        {
+            firstTime = simNow;
+            firstShown = secs;
+        }
+    }
+}
+
+// One encoder detent = 4 quadrature edges, CW goes 00 -> 10 -> 11 -> 01 -> 00 (A = RC4, B = RC3)
+static void turn(double at, int detents, double detentMs)
+{
+    static const unsigned char cw[4] = { 0x10, 0x18, 0x08, 0x00 };
+    simCycle_t t = SECS(at);
+    simCycle_t edge = SECS(detentMs / 1000.0 / 4);
+    int n = abs(detents);
+    int i, k;
+
+    for(i=0; i<n; i++)
+    {
+        for(k=0; k<4; k++)
+        {
+            simPinsC(t, 0x18, (detents > 0) ? cw[k] : cw[(6 - k) % 4]);
+            t += edge;
+        }
+    }
+}
+
+// --fuzz: xorshift, so a seed gives the same run everywhere
+static unsigned long long fuzzState;
+static unsigned long fuzzPresses, fuzzTurns, fuzzDetents, fuzzBounces, fuzzLights;
+
+static unsigned long fuzzRand(unsigned long n)
+{
+    fuzzState ^= fuzzState << 13;
+    fuzzState ^= fuzzState >> 7;
+    fuzzState ^= fuzzState << 17;
+    return (unsigned long)(fuzzState % n);
+}
+
+static void fuzz(double secs)
+{
+    static const unsigned char cw[4] = { 0x10, 0x18, 0x08, 0x00 };
+    simCycle_t t = SECS(0.5), end = SECS(secs), edge, bounce;
+    int what, n, i, k, s, last;
+
+    while(t < end)
+    {
+        what = (int)fuzzRand(10);
+        if(what < 4)
+        {
+            simPinsA(t, 0x04, 0x00);
+            simPinsA(t + SECS(0.1), 0x04, 0x04);
+            t += SECS(0.1);
+            fuzzPresses++;
+        }
+        else if(what < 9)
+        {
+            // A detent every 3-300ms, a few us of chatter on the odd edge
+            n = 1 + (int)fuzzRand(15);
+            edge = SECS((3 + fuzzRand(298)) / 1000.0 / 4);
+            last = 0x00;
+            for(i=0; i<n; i++)
+            {
+                for(k=0; k<4; k++)
+                {
+                    s = (what & 1) ? cw[k] : cw[(6 - k) % 4];
+                    simPinsC(t, 0x18, (unsigned char)s);
+                    if(fuzzRand(6) == 0)
+                    {
+                        bounce = SECS((5 + fuzzRand(46)) / 1e6);
+                        simPinsC(t + bounce, 0x18, (unsigned char)last);
+                        simPinsC(t + 2 * bounce, 0x18, (unsigned char)s);
+                        fuzzBounces++;
+                    }
+                    last = s;
+                    t += edge;
+                }
+            }
+            fuzzTurns++;
+            fuzzDetents += n;
+        }
+        else
+        {
+            simAmbient(t, (unsigned char)fuzzRand(256));
+            fuzzLights++;
+        }
+        t += SECS(0.05 + fuzzRand(4000) / 1000.0);    // right after, or seconds later
+    }
+}
+
+int main(int argc, char **argv)
+{
+    double seconds = 60;
+    double detentMs = 30;
+    const char *turns[64];
+    int nTurns = 0;
+    double presses[64];
+    int nPresses = 0;
+    const char *ambients[64];
+    int nAmbients = 0;
+    double cutAt[16], cutSecs[16];
+    int nCuts = 0;
+    long fuzzSeed = -1;
+    double start = 0, end;
+#if PERSIST_ENABLE
+    double trueAtOn = -1;
+    long expect;
+    int savedBefore;
+#endif
+    int fd[2];
+    pid_t child = 0;
+    int toParent = -1;
+    int i, k, fail;
+    double wall;
+
+    for(i=1; i<argc; i++)
+    {
+        if(!strcmp(argv[i], "--seconds") && i + 1 < argc)
+            seconds = atof(argv[++i]);
+        else if(!strcmp(argv[i], "--days") && i + 1 < argc)
+            seconds = atof(argv[++i]) * 86400;
+        else if(!strcmp(argv[i], "--press") && i + 1 < argc && nPresses < 64)
+            presses[nPresses++] = atof(argv[++i]);
+        else if(!strcmp(argv[i], "--turn") && i + 1 < argc && nTurns < 64)
+            turns[nTurns++] = argv[++i];
+        else if(!strcmp(argv[i], "--detent-ms") && i + 1 < argc)
+            detentMs = atof(argv[++i]);
+        else if(!strcmp(argv[i], "--ambient") && i + 1 < argc && nAmbients < 64)
+            ambients[nAmbients++] = argv[++i];
+        else if(!strcmp(argv[i], "--fuzz") && i + 1 < argc)
+            fuzzSeed = atol(argv[++i]);
+        else if(!strcmp(argv[i], "--power-off") && i + 1 < argc && nCuts < 16 && strchr(argv[i + 1], ':'))
+        {
+            cutAt[nCuts] = atof(argv[++i]);
+            cutSecs[nCuts++] = atof(strchr(argv[i], ':') + 1);
+        }
+        else if(!strcmp(argv[i], "--telem") && i + 1 < argc)
+        {
+            telemFile = fopen(argv[++i], "wb");
+            if(!telemFile)
+            {
+                perror(argv[i]);
+                return 2;
+            }
+        }
+        else if(!strcmp(argv[i], "--trace"))
+            trace = 1;
+        else
+        {
+            fprintf(stderr, "usage: %s [--seconds N] [--days N] [--press T] [--turn T:N] [--detent-ms MS] [--ambient T:L] [--power-off T:D] [--fuzz SEED] [--telem FILE] [--trace]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    // One stretch of power after another, each but the last in a child process, the parent only
+    // waits for it and takes the Carry back (the last one it runs itself, and prints the totals)
+    carry.saved = -1;
+    carry.trueAtOff = -1;
+    for(k=0; k<=nCuts; k++)
+    {
+        start = (k == 0) ? 0 : cutAt[k - 1] + cutSecs[k - 1];
+#if PERSIST_ENABLE
+        trueAtOn = (k != 0 && carry.trueAtOff >= 0) ? fmod(carry.trueAtOff + cutSecs[k - 1], DAY_SECS) : -1;
+#endif
+        if(k == nCuts)
+            break;
+        fflush(stdout);
+        if(pipe(fd) != 0 || (child = fork()) < 0)
+        {
+            perror("fork");
+            return 2;
+        }
+        if(child == 0)
+        {
+            close(fd[0]);
+            toParent = fd[1];
+            break;
+        }
+        close(fd[1]);
+        if(read(fd[0], &carry, sizeof(carry)) != (ssize_t)sizeof(carry))
+            carry.fail = 1;     // it crashed
+        close(fd[0]);
+        waitpid(child, 0, 0);
+        memcpy(simSaf, carry.saf, sizeof(simSaf));
+    }
+    end = (k < nCuts) ? cutAt[k] : seconds;
+    if(end < start)
+        end = start;
+#if PERSIST_ENABLE
+    savedBefore = (carry.saved >= 0);
+    expect = savedBefore ? carry.saved : 0;         // nothing saved: 12:00:00 / 00:00:00
+#endif
+    if(nCuts != 0)
+        printf("== power on at %.0f s, off at %.0f s ==\n", start, end);
+
+    simReset();
+    simEnd = SECS(end - start);
+    simOnLatch = onLatch;
+    simOnUart = onUart;
+    simOnNvmWrite = onNvmWrite;
+
+    // The stimulus that falls into this stretch, the light level from before it as well
+    for(i=0; i<nPresses; i++)
+    {
+        if(presses[i] < start || presses[i] >= end)
+            continue;
+        simPinsA(SECS(presses[i] - start), 0x04, 0x00);         // press...
+        simPinsA(SECS(presses[i] - start + 0.1), 0x04, 0x04);   // ...release 100ms later (INT on the rising edge)
+    }
+    for(i=0; i<nTurns; i++)
+    {
+        const char *colon = strchr(turns[i], ':');
+        if(colon && atof(turns[i]) >= start && atof(turns[i]) < end)
+            turn(atof(turns[i]) - start, atoi(colon + 1), detentMs);
+    }
+    for(i=0; i<nAmbients; i++)
+    {
+        const char *colon = strchr(ambients[i], ':');
+        if(colon && atof(ambients[i]) < end)
+            simAmbient(SECS(atof(ambients[i]) > start ? atof(ambients[i]) - start : 0), (unsigned char)atoi(colon + 1));
+    }
+    if(fuzzSeed >= 0)
+    {
+        fuzzState = ((unsigned long long)fuzzSeed + k) * 0x9E3779B97F4A7C15ULL + 1;
+        fuzz(end - start);
+    }
+
+    std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+    try
+    {
+        firmwareMain();
+    }
+    catch(SimStop &)
+    {
+    }
+    simHalt();
+    wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    if(telemFile)
+        fclose(telemFile);
+
+    seconds = end - start;
+    printf("simulated %.0f s (%.2f days) in %.3f s wall, %.0fx real time\n",
+           seconds, seconds / 86400, wall, seconds / (wall > 0 ? wall : 1e-9));
+    printf("latches: %llu tick, %llu live, %llu while the SPI was shifting\n",
+           tickLatches, liveLatches, simStats.latchesWhileShifting);
+    if(fuzzSeed >= 0)
+        printf("fuzz: seed %ld, %lu presses, %lu turns (%lu detents, %lu edges bounced), %lu light levels\n",
+               fuzzSeed, fuzzPresses, fuzzTurns, fuzzDetents, fuzzBounces, fuzzLights);
+    printf("bad frames: %llu, second sequence errors: %llu, frameLate: %u, SPI collisions: %llu\n",
+           badFrames, sequenceErrors, frameLate, simStats.spiCollisions);
+#if TELEM_ENABLE
+    printf("telemetry: %llu bytes on the UART, %u records dropped (ring full), %llu TX1REG overruns\n",
+           simStats.uartBytes, telemDropped, simStats.uartOverruns);
+#endif
+    printf("ISR calls: %llu, CPU awake %.3f%% (at least, SFR accesses only)\n", simStats.isrCalls,
+           100.0 * (double)(simNow - simStats.sleepCycles) / (double)(simNow ? simNow : 1));
+    for(i=0; i<POWER_MODES; i++)
+    {
+        static const char *modeNames[POWER_MODES] = { "free running", "edit hours", "edit minutes", "edit seconds" };
+
+        if(powerTotal[i] != 0)
+            printf("    %-12s %7.1f s, awake %4u/1000, ~%u uA (firmware, Nixie_power.h)\n", modeNames[i],
+                   powerTotal[i] / 384000.0, powerDutyPermille((unsigned char)i), powerCurrentUa((unsigned char)i));
+    }
+    printf("latchLagMax (firmware): %u TMR0 counts\n", latchLagMax);
+    printf("schedLatencyMax (firmware): tick %u, spi %u, button %u, encoder %u %s\n",
+           schedLatencyMax[EVT_TICK] * TMR1_TCY, schedLatencyMax[EVT_SPI_DONE] * TMR1_TCY,
+           schedLatencyMax[EVT_BUTTON] * TMR1_TCY, schedLatencyMax[EVT_ENCODER] * TMR1_TCY, SIM_TCY_LB);
+    tickLag.print("timer match -> RCK", SIM_TCY_LB);
+    tickJitter.print("RCK period error", "Tcy");
+    simStats.isrCost.print("ISR_High() cost", SIM_TCY_LB);
+    simStats.tickIsrCost.print("ISR_High() cost, Timer0", SIM_TCY_LB);
+
+    fail = (badFrames != 0) || (sequenceErrors != 0) || (frameLate != 0) || (simStats.latchesWhileShifting != 0)
+        || (simStats.uartOverruns != 0);
+    printf("brightness (G on) at the RCKs: %.1f-%.1f%%, %llu changes, level %u at the end\n",
+           brightMin / 10.0, brightMax / 10.0, brightChanges, dimLevel);
+    if(brightMin <= 0 && DIM_NIGHT_LEVEL > 0)
+        fail = 1;   // tubes dark at a second's RCK with no level that's off
+#if STREAM_ENABLE
+    {
+        double secs = (double)simStats.streamCycles / SIM_TCY_PER_SEC;
+        double awake = (double)(simStats.streamCycles - simStats.streamSleepCycles);
+        double perIrq = awake / (simStats.streamIrqs ? simStats.streamIrqs : 1);
+        double perShift = awake / (streamLatches ? streamLatches : 1);
+        
+        printf("frame stream: %.1f s running, %llu frames paced, %llu shifted, %u skipped (SPI busy)\n",
+               secs, simStats.streamIrqs, streamLatches, streamSkipped);
+        if(simStats.streamIrqs != 0)
+        {
+            printf("    CPU awake %.2f%% while streaming, %.0f Tcy per paced frame, %.0f per shifted frame (SFR-access lower bounds)\n",
+                   100.0 * awake / (double)simStats.streamCycles, perIrq, perShift);
+            printf("    refresh limit, at most: %.0f fps SPI (Timer2 -> RCK max), %.0f fps CPU (all shifted), 1000 fps Timer2\n",
+                   (double)SIM_TCY_PER_SEC / (double)(streamShift.max ? streamShift.max : 1),
+                   (double)SIM_TCY_PER_SEC / (perShift > 0 ? perShift : 1));
+            streamShift.print("stream frame, Timer2 -> RCK", SIM_TCY_LB);
+            simStats.streamIsrCost.print("ISR_High() cost, Timer2", SIM_TCY_LB);
+        }
+    }
+    if(streamSkipped != 0)
+        fail = 1;
+#endif
+#if FADE_ENABLE
+    printf("crossfade frames: %llu old, %llu new, %llu neither, %llu seconds left on the old one at the RCK\n",
+           fadeOld, fadeNew, fadeBad, fadeStuck);
+    fadeSpan.print("tick RCK -> last crossfade frame", "Tcy");
+    fadeMargin.print("last crossfade frame -> next tick RCK", "Tcy");
+    if(fadeBad != 0 || fadeStuck != 0)
+        fail = 1;
+#endif
+#if SLOT_ENABLE
+    printf("slot frames: %llu\n", slotLatches);
+    if(slotLatches != 0)
+    {
+        int tube, k;
+        unsigned long long lo, hi;
+
+        for(tube=0; tube<SIM_TUBES; tube++)
+        {
+            lo = hi = slotLit[tube][0];
+            for(k=0; k<simTubeCathodes(tube); k++)
+            {
+                if(slotLit[tube][k] < lo)
+                    lo = slotLit[tube][k];
+                if(slotLit[tube][k] > hi)
+                    hi = slotLit[tube][k];
+            }
+            printf("    tube %d: every cathode lit %llu-%llu times\n", tube, lo, hi);
+            if(slotLatches >= SLOT_FRAMES && lo == 0)
+                fail = 1;
+        }
+        slotPeriod.print("slot frame period", "Tcy");
+        slotMargin.print("last slot frame -> next tick RCK", "Tcy");
+        slotTickLag.print("timer match -> RCK, burst seconds", SIM_TCY_LB);
+    }
+#endif
+
+#if PERSIST_ENABLE
+    // Power-up: the first time on the tubes, how soon, and is it the one saved last
+    if(firstTime >= 0)
+    {
+        double ms = 1000.0 * (double)firstTime / SIM_TCY_PER_SEC;
+        long behind = 0;
+
+        printf("power-up: %02ld:%02ld:%02ld on the tubes after %.3f ms, %s %02ld:%02ld:%02ld", firstShown / 3600,
+               firstShown / 60 % 60, firstShown % 60, ms, savedBefore ? "saved" : "nothing saved,",
+               expect / 3600, expect / 60 % 60, expect % 60);
+        if(trueAtOn >= 0)
+        {
+            behind = (long)floor(fmod(trueAtOn + (double)firstTime / SIM_TCY_PER_SEC, DAY_SECS)) - firstShown;
+            behind = ((behind % DAY_SECS) + DAY_SECS) % DAY_SECS;
+            if(behind > DAY_SECS / 2)
+                behind -= DAY_SECS;
+            printf(", %ld s behind the true time", behind);
+        }
+        printf("\n");
+        if(ms > carry.worstBootMs)
+            carry.worstBootMs = ms;
+        if(ms > 1000 || firstShown != expect)
+            fail = 1;
+    }
+    else
+        fail = 1;
+    printf("SAF: %llu row erases, %llu row writes, %.3f ms of CPU stall, %llu errors, %llu words written unerased, "
+           "%llu RCKs held up\n", simStats.nvmErases, simStats.nvmWrites,
+           1000.0 * (double)simStats.nvmStallCycles / SIM_TCY_PER_SEC, simStats.nvmErrors, simStats.nvmOverwrites,
+           simStats.nvmLateRcks);
+    if(simStats.nvmErrors != 0 || simStats.nvmOverwrites != 0 || simStats.nvmLateRcks != 0)
+        fail = 1;
+
+    // Over every stretch so far: the wear, and where it's heading at this rate of saves
+    carry.saves += simStats.nvmWrites;
+    carry.powered += seconds;
+    for(i=0; i<SIM_SAF_ROWS; i++)
+        carry.rowErases[i] += simStats.nvmRowErases[i];
+    if(toParent < 0)
+    {
+        double perYear = (double)carry.saves / (carry.powered / (365.25 * 86400));
+
+        printf("SAF wear, %.2f days powered: %llu saves, row erases", carry.powered / 86400, carry.saves);
+        for(i=0; i<SIM_SAF_ROWS; i++)
+            printf(" %llu", carry.rowErases[i]);
+        printf("\n");
+        if(carry.saves != 0)
+            printf("    %d slots x 10k erases = %d saves, %.1f years at this rate (%.0f saves a year)\n",
+                   PERSIST_SLOTS, PERSIST_SLOTS * 10000, PERSIST_SLOTS * 10000.0 / perYear, perYear);
+        if(nCuts != 0)
+            printf("power-ups: %d, the slowest showed a time after %.3f ms\n", nCuts + 1, carry.worstBootMs);
+    }
+#endif
+
+    printf("%s\n", fail ? "FAIL" : "PASS");
+    if(toParent >= 0)
+    {
+        // The power goes: what the tubes showed, plus however far into the second it got
+        carry.trueAtOff = (shown >= 0 && lastTickLatch >= 0)
+            ? fmod(shown + (double)(simNow - lastTickLatch) / SIM_TCY_PER_SEC, DAY_SECS) : -1;
+        carry.fail |= fail;
+        memcpy(carry.saf, simSaf, sizeof(simSaf));
+        fflush(stdout);
+        if(write(toParent, &carry, sizeof(carry)) != (ssize_t)sizeof(carry))
+            return 2;
+        _exit(fail);
+    }
+    if(carry.fail)
+        printf("FAIL (an earlier stretch)\n");
+    return fail | carry.fail;
+}
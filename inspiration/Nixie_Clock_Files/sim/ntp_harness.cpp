@@ -0,0 +1,393 @@
+/*
+ * File:        sim/ntp_harness.cpp
+ * Compiler:    g++ (host only)
+ *
+ * Info:    Test bench for the NTP client (Nixie_ntp.c) against a stand-in NTP server on 127.0.0.1.
+ *
+ *          Time is simulated, so a day of polling runs in a few tens of milliseconds:
+ *              - the clock is a model of the sub-tick counter: a crystal off by --ppm, the real
+ *                tickTrimSecond() turning tickTrimPpb into whole counts once a second, read
+ *                in 1/3000 sec counts and stepped by whole sub-ticks exactly like Nixie_main_v3.c
+ *              - the server answers with the true time plus --offset (and a --jump part way through)
+ *              - the network in between adds delay, exponential jitter, asymmetry and loss
+ *          Every request and reply is a real 48 byte NTP packet through a real UDP socket pair,
+ *          only the moment it "arrives" is simulated.
+ *
+ *          ntp_harness [--hours H] [--ppm P] [--start-error S] [--offset MS] [--jump T:MS]
+ *                      [--delay MS] [--jitter MS] [--asym MS] [--loss P] [--lock-us US] [--seed N] [--trace]
+ *              --ppm P         crystal error, + = fast (default 25)
+ *              --start-error S clock error at power up, seconds (default -3725.4)
+ *              --offset MS     server time - true time (default 0)
+ *              --jump T:MS     server time moves MS at T seconds, must be slewed, never stepped (default 14400:150)
+ *              --delay MS      one way network delay (default 15)
+ *              --jitter MS     queueing delay per packet, exponential with this mean (default 4)
+ *              --asym MS       extra delay on the way back only (NTP can't see it, reads half of it as offset)
+ *              --loss P        fraction of packets lost each way (default 0.05)
+ *              --lock-us US    converged = |error| stays under this (default 1000)
+ *              --trace         print every clock update
+ *
+ *          Reports the convergence time after the first sync and after the jump, and the steady state
+ *          offset over the last quarter of the run. Exit status 1 if either never converged, the steady
+ *          state error is over --lock-us, or the tubes would have jumped or repeated a second after the
+ *          first sync.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <chrono>
+#include <random>
+#include <vector>
+#include "../Nixie_config.h"
+#include "../Nixie_tick.h"
+#include "../Nixie_ntp.h"
+
+#define TRUE_SECS       (NTP_BOOT_SECS + 200UL * 86400)   // true time at the start of the run (whole seconds)
+
+struct Packet
+{
+    double at;                          // when it gets to the client
+    unsigned char data[NTP_PACKET_BYTES];
+};
+
+struct Sample
+{
+    double t;
+    double err;                         // clock - server time, seconds
+};
+
+// Options
+static double hours = 8;
+static double ppm = 25;
+static double startError = -3725.4;
+static double offsetMs = 0;
+static double jumpAt = 14400, jumpMs = 150;
+static double delayMs = 15, jitterMs = 4, asymMs = 0, loss = 0.05;
+static double lockUs = 1000;
+static int trace = 0;
+
+// Simulation state
+static double now;                      // true time, seconds since the start of the run
+static unsigned long long localSecs;    // the clock's current second (utcSecs)
+static double secStart;                 // true time that second started
+static double secLen;                   // and how long it lasts
+static std::vector<Packet> inFlight;
+static std::mt19937_64 rng;
+static int srvSock, cliSock;
+static unsigned long long requests, lost;
+
+static double countsPerSec(void)
+{
+    return TICK_COUNTS_PER_SEC * (1.0 + ppm * 1e-6);
+}
+
+// Sub-timer counts since the second started
+static long elapsedCounts(void)
+{
+    return (long)floor((now - secStart) * countsPerSec());
+}
+
+// Server's idea of the time, relative to TRUE_SECS
+static double serverTime(double t)
+{
+    return t + offsetMs / 1000 + ((t >= jumpAt) ? jumpMs / 1000 : 0);
+}
+
+static ntpStamp_t toStamp(double secs)
+{
+    double whole = floor(secs);
+
+    return ((ntpStamp_t)(TRUE_SECS + (long long)whole) << 32) + (ntpStamp_t)((secs - whole) * 4294967296.0);
+}
+
+static double netDelay(void)
+{
+    std::exponential_distribution<double> jitter(1.0 / (jitterMs > 0 ? jitterMs : 1e-9));
+
+    return (delayMs + (jitterMs > 0 ? jitter(rng) : 0)) / 1000;
+}
+
+static int dropped(void)
+{
+    return std::uniform_real_distribution<double>(0, 1)(rng) < loss;
+}
+
+// --- what Nixie_main_v3.c provides to the client on the real clock ---
+
+ntpStamp_t ntpClockRead(void)
+{
+    return ((ntpStamp_t)localSecs << 32) + ((((ntpStamp_t)elapsedCounts() * 2 + 1) << 31) / TICK_COUNTS_PER_SEC);
+}
+
+// Same as the firmware: whole sub-ticks, the timer keeps its phase inside the sub-tick
+void ntpClockStep(long long ns)
+{
+    long e = elapsedCounts();
+    ntpStamp_t t = ntpClockRead() + (ntpStamp_t)ntpNsToStamp(ns);
+    unsigned long long secs = t >> 32;
+    long counts = (long)(((t & 0xFFFFFFFFULL) * TICK_COUNTS_PER_SEC) >> 32) - (e % TICK_PERIOD) + TICK_PERIOD / 2;
+    long sub;
+
+    if(counts < 0)
+    {
+        counts += TICK_COUNTS_PER_SEC;
+        secs--;
+    }
+    sub = counts / TICK_PERIOD;
+    if(sub >= TICK_SUBTICKS)
+    {
+        sub -= TICK_SUBTICKS;
+        secs++;
+    }
+    localSecs = secs;
+    secStart = now - (sub * TICK_PERIOD + e % TICK_PERIOD) / countsPerSec();
+}
+
+// The stand-in server: takes the request off its own socket and answers it
+// (the two sockets are real, the delays are added to the simulated clock)
+void ntpNetSend(const unsigned char *pkt)
+{
+    unsigned char req[NTP_PACKET_BYTES + 16], rep[NTP_PACKET_BYTES];
+    struct sockaddr_in from;
+    socklen_t fromLen = sizeof(from);
+    double up, down;
+    ntpStamp_t t2, t3;
+    Packet p;
+    int i;
+
+    requests++;
+    send(cliSock, pkt, NTP_PACKET_BYTES, 0);
+    if(recvfrom(srvSock, req, sizeof(req), 0, (struct sockaddr *)&from, &fromLen) != NTP_PACKET_BYTES)
+        return;
+    if(dropped())
+    {
+        lost++;
+        return;
+    }
+
+    up = netDelay();
+    t2 = toStamp(serverTime(now + up));
+    t3 = t2 + (50ULL << 32) / 1000000;  // 50us to answer
+
+    memset(rep, 0, sizeof(rep));
+    rep[0] = (0 << 6) | (4 << 3) | 4;   // no leap warning, version 4, server
+    rep[1] = 2;                         // stratum
+    rep[2] = 6;                         // poll 64s
+    rep[3] = (unsigned char)-20;        // precision ~1us
+    memcpy(rep + 12, "SIM", 3);         // reference id
+    memcpy(rep + 24, req + 40, 8);      // originate = the client's transmit stamp
+    for(i=0; i<8; i++)
+    {
+        rep[32 + i] = (unsigned char)(t2 >> (56 - 8 * i));
+        rep[40 + i] = (unsigned char)(t3 >> (56 - 8 * i));
+    }
+    sendto(srvSock, rep, sizeof(rep), 0, (struct sockaddr *)&from, fromLen);
+
+    if(recv(cliSock, p.data, sizeof(p.data), 0) != NTP_PACKET_BYTES)
+        return;
+    if(dropped())
+    {
+        lost++;
+        return;
+    }
+    down = netDelay() + asymMs / 1000;
+    p.at = now + up + 50e-6 + down;
+    inFlight.push_back(p);
+}
+
+static void openSockets(void)
+{
+    struct sockaddr_in a;
+    socklen_t len = sizeof(a);
+
+    srvSock = socket(AF_INET, SOCK_DGRAM, 0);
+    cliSock = socket(AF_INET, SOCK_DGRAM, 0);
+    memset(&a, 0, sizeof(a));
+    a.sin_family = AF_INET;
+    a.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    a.sin_port = 0;
+    if(srvSock < 0 || cliSock < 0 || bind(srvSock, (struct sockaddr *)&a, sizeof(a)) != 0 ||
+       getsockname(srvSock, (struct sockaddr *)&a, &len) != 0 || connect(cliSock, (struct sockaddr *)&a, sizeof(a)) != 0)
+    {
+        perror("ntp_harness: loopback UDP");
+        exit(2);
+    }
+}
+
+// Seconds from 'from' until the error stays under the lock limit up to 'to', -1 if it never does
+static double convergence(const std::vector<Sample> &s, double from, double to, double bias)
+{
+    double last = from;
+    size_t i;
+
+    for(i=0; i<s.size(); i++)
+        if(s[i].t >= from && s[i].t < to && fabs(s[i].err - bias) * 1e6 > lockUs)
+            last = s[i].t;
+    return (last < to - (to - from) / 4) ? last - from : -1;
+}
+
+int main(int argc, char **argv)
+{
+    std::vector<Sample> samples;
+    unsigned long long sequenceErrors = 0, stepsAfterSync = 0, prevSecs;
+    unsigned long prevSteps = 0, prevUpdates = 0;
+    double end, syncAt = -1, firstStep = 0, bias, convSync, convJump, wall;
+    double sum = 0, sum2 = 0, worst = 0, trimWorst = 0;
+    long n = 0;
+    unsigned long seed = 1;
+    size_t i, k;
+    int fail;
+
+    for(i=1; i<(size_t)argc; i++)
+    {
+        const char *a = argv[i];
+        const char *v = (i + 1 < (size_t)argc) ? argv[i + 1] : 0;
+
+        if(!strcmp(a, "--trace"))
+        {
+            trace = 1;
+            continue;
+        }
+        if(!v)
+            a = "?";
+        if(!strcmp(a, "--hours"))
+            hours = atof(v);
+        else if(!strcmp(a, "--ppm"))
+            ppm = atof(v);
+        else if(!strcmp(a, "--start-error"))
+            startError = atof(v);
+        else if(!strcmp(a, "--offset"))
+            offsetMs = atof(v);
+        else if(!strcmp(a, "--jump") && strchr(v, ':'))
+        {
+            jumpAt = atof(v);
+            jumpMs = atof(strchr(v, ':') + 1);
+        }
+        else if(!strcmp(a, "--delay"))
+            delayMs = atof(v);
+        else if(!strcmp(a, "--jitter"))
+            jitterMs = atof(v);
+        else if(!strcmp(a, "--asym"))
+            asymMs = atof(v);
+        else if(!strcmp(a, "--loss"))
+            loss = atof(v);
+        else if(!strcmp(a, "--lock-us"))
+            lockUs = atof(v);
+        else if(!strcmp(a, "--seed"))
+            seed = strtoul(v, 0, 0);
+        else
+        {
+            fprintf(stderr, "usage: %s [--hours H] [--ppm P] [--start-error S] [--offset MS] [--jump T:MS]\n"
+                            "       [--delay MS] [--jitter MS] [--asym MS] [--loss P] [--lock-us US] [--seed N] [--trace]\n", argv[0]);
+            return 2;
+        }
+        i++;
+    }
+
+    rng.seed(seed);
+    openSockets();
+    end = hours * 3600;
+    bias = -asymMs / 2000;  // where NTP settles with an asymmetric path (it can't tell)
+
+    // Power up: the clock is startError off, partway into a second
+    now = 0;
+    localSecs = TRUE_SECS + (unsigned long long)floor(startError);
+    secStart = -(startError - floor(startError)) / (1.0 + ppm * 1e-6);
+    tickTrimSecond();
+    secLen = (TICK_COUNTS_PER_SEC + tickStretch) / countsPerSec();
+    ntpInit();
+
+    std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+    while(now < end)
+    {
+        // Next thing to happen: a reply arriving, or the end of the clock's second
+        for(k=0, i=1; i<inFlight.size(); i++)
+            if(inFlight[i].at < inFlight[k].at)
+                k = i;
+
+        if(!inFlight.empty() && inFlight[k].at < secStart + secLen)
+        {
+            Packet p = inFlight[k];
+
+            inFlight.erase(inFlight.begin() + k);
+            now = p.at;
+            ntpReceive(p.data, NTP_PACKET_BYTES, ntpClockRead());
+            continue;
+        }
+
+        // Second boundary: the ISR works out next second's stretch, then main() runs ntpSecond()
+        now = secStart + secLen;
+        secStart = now;
+        prevSecs = localSecs;
+        localSecs++;
+        tickTrimSecond();
+        secLen = (TICK_COUNTS_PER_SEC + tickStretch) / countsPerSec();
+        ntpSecond();
+
+        if(ntpSteps != prevSteps)
+        {
+            if(prevSteps != 0)
+                stepsAfterSync++;
+            prevSteps = ntpSteps;
+            if(syncAt < 0)
+            {
+                syncAt = now;
+                firstStep = ntpLastOffsetNs / 1e9;
+            }
+        }
+        else if(localSecs != prevSecs + 1)
+            sequenceErrors++;
+        if(trace && ntpUpdates != prevUpdates)
+            printf("%9.1fs  offset %+9.1f us  delay %7.1f us  freq %+8.3f ppm  slew %+8.3f ppm\n", now,
+                   ntpLastOffsetNs / 1e3, ntpLastDelayNs / 1e3, ntpFreqPpb / 1000.0, ntpPhasePpb / 1000.0);
+        prevUpdates = ntpUpdates;
+
+        if(syncAt >= 0)
+        {
+            Sample s;
+
+            s.t = now;
+            s.err = (double)(long long)(localSecs - TRUE_SECS) - serverTime(now);
+            samples.push_back(s);
+            if(fabs((double)(tickTrimPpb - TICK_TRIM_PPB)) > trimWorst)
+                trimWorst = fabs((double)(tickTrimPpb - TICK_TRIM_PPB));
+        }
+    }
+    wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+    for(i=0; i<samples.size(); i++)
+    {
+        if(samples[i].t < end * 0.75)
+            continue;
+        sum += samples[i].err;
+        sum2 += samples[i].err * samples[i].err;
+        if(fabs(samples[i].err - bias) > worst)
+            worst = fabs(samples[i].err - bias);
+        n++;
+    }
+
+    convSync = (syncAt >= 0) ? convergence(samples, syncAt, (jumpAt > syncAt && jumpAt < end) ? jumpAt : end, bias) : -1;
+    convJump = (jumpAt > syncAt && jumpAt < end) ? convergence(samples, jumpAt, end, bias) : 0;
+
+    printf("simulated %.1f h in %.3f s wall: %llu requests, %llu packets lost, %lu clock updates\n",
+           hours, wall, requests, lost, ntpUpdates);
+    printf("network: %.1f ms +%.1f ms jitter each way, %.1f ms asymmetry, %.0f%% loss; crystal %+.1f ppm\n",
+           delayMs, jitterMs, asymMs, loss * 100, ppm);
+    printf("first sync at %.0f s (stepped %+.3f s), steps after it: %llu, second sequence errors: %llu\n",
+           syncAt, firstStep, stepsAfterSync, sequenceErrors);
+    printf("convergence to +/-%.0f us: %.0f s after the first sync, %.0f s after the %+.0f ms server jump\n",
+           lockUs, convSync, convJump, jumpMs);
+    printf("steady state (last quarter): mean %+.1f us, rms %.1f us, worst %.1f us from the %+.1f us NTP can see\n",
+           n ? sum / n * 1e6 : 0, n ? sqrt(sum2 / n) * 1e6 : 0, worst * 1e6, bias * 1e6);
+    printf("crystal estimate %+.3f ppm (true %+.3f), largest slew %.1f ppm\n",
+           -ntpFreqPpb / 1000.0, ppm, trimWorst / 1000);
+
+    fail = (convSync < 0) || (convJump < 0) || (worst * 1e6 > lockUs) || (stepsAfterSync != 0) || (sequenceErrors != 0);
+    printf("%s\n", fail ? "FAIL" : "PASS");
+    return fail;
+}
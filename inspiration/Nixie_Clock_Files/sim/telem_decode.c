@@ -0,0 +1,274 @@
+/*
+ * File:        sim/telem_decode.c
+ * Compiler:    cc (host only)
+ *
+ * Info:    Decoder for the clock's telemetry stream (see ../Nixie_telem.h).
+ *
+ *          Reads the raw UART bytes (a file, - for stdin, or the serial port itself once stty has
+ *          it at 38400 raw), finds the frames, and prints histograms:
+ *              RCK          TMR0 lag at the latch, and the RCK to RCK period error from the Timer1 stamps,
+ *                           whole Timer0 counts (the calibration / NTP trim) split off from the jitter
+ *              shifts       pipeline and live frames: start to latched, and how many had the button or the
+ *                           encoder interrupt them
+ *              streams      anti-poisoning bursts and crossfades: frames each, longest frame
+ *              NTP          slew offsets, steps
+ *              saves        how long each save to flash stalled the CPU, and where the power-up state came from
+ *              and the mode changes, encoder turns, dropped records and bytes that weren't a frame.
+ *
+ *          telem_decode [--check] [--trace] FILE
+ *              --check     exit status 1 on a bad frame, a dropped record or a missed latch (make telem-check)
+ *              --trace     print every record
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../Nixie_telem.h"
+#include "../Nixie_persist.h"
+
+#define TMR1_US             (8.0 / 3.072)   // Timer1 count, 2.6us
+#define TMR1_PER_SEC        384000L
+#define TMR1_PER_TMR0       128             // one Timer0 count (1024 Tcy) in Timer1 counts (8 Tcy)
+
+// Power of 2 buckets, like SimHist
+typedef struct
+{
+    unsigned long count;
+    long long sum, min, max;
+    unsigned long bucket[40];
+} hist_t;
+
+static void histAdd(hist_t *h, long long v)
+{
+    int i = 0;
+
+    if(h->count == 0 || v < h->min)
+        h->min = v;
+    if(h->count == 0 || v > h->max)
+        h->max = v;
+    h->count++;
+    h->sum += v;
+    while(i < 39 && v >= (1LL << i))
+        i++;
+    h->bucket[i]++;
+}
+
+static void histPrint(const char *name, const hist_t *h, const char *unit)
+{
+    int i;
+
+    if(h->count == 0)
+    {
+        printf("%s: none\n", name);
+        return;
+    }
+    printf("%s: n=%lu min=%lld avg=%.1f max=%lld %s\n", name, h->count, h->min,
+           (double)h->sum / h->count, h->max, unit);
+    for(i=0; i<40; i++)
+    {
+        if(h->bucket[i] == 0)
+            continue;
+        if(i == 0)
+            printf("    %10d         : %lu\n", 0, h->bucket[i]);
+        else
+            printf("    %10lld - %-8lld: %lu\n", 1LL << (i - 1), (1LL << i) - 1, h->bucket[i]);
+    }
+}
+
+static const char *typeName[TELEM_TYPES] =
+{
+    "boot", "tick", "shift", "stream", "mode", "encoder", "ntp slew", "ntp step", "drop", "save", "restore"
+};
+
+static unsigned long records[TELEM_TYPES];
+static unsigned long badBytes, drops, missed, trimmed, modes, encoderDetents;
+static unsigned long shiftsHit[2], shiftIrqs[2];
+static hist_t tickLag, periodErr, jitter, shifts[2], streamFrames[3], streamLongest[3], ntpSlew, ntpStep, saveStall;
+static int haveStamp = 0;
+static unsigned int lastStamp;
+static int trace = 0;
+
+static long s24(const unsigned char *d)
+{
+    long v = (long)d[0] | ((long)d[1] << 8) | ((long)d[2] << 16);
+
+    return (v & 0x800000L) ? v - 0x1000000L : v;
+}
+
+static void record(const unsigned char *r)
+{
+    const unsigned char *d = r + 1;
+    unsigned int stamp, took;
+    int err, whole, live;
+    long v;
+
+    records[r[0]]++;
+    if(trace)
+        printf("%-8s %02X %02X %02X\n", typeName[r[0]], d[0], d[1], d[2]);
+
+    switch(r[0])
+    {
+    case TELEM_BOOT:
+        printf("boot: version %u,%s%s%s%s%s%s SPI mode %u\n", d[0],
+               (d[1] & TELEM_OPT_24_HOUR) ? " 24-hour," : "", (d[1] & TELEM_OPT_SPI_IRQ) ? " SPI interrupt," : "",
+               (d[1] & TELEM_OPT_NTP) ? " NTP," : "", (d[1] & TELEM_OPT_SLOT) ? " slot," : "",
+               (d[1] & TELEM_OPT_FADE) ? " fade," : "", (d[1] & TELEM_OPT_PERSIST) ? " persist," : "", d[2]);
+        haveStamp = 0;
+        break;
+    case TELEM_TICK:
+        if(d[0] & TELEM_TICK_MISSED)
+            missed++;
+        histAdd(&tickLag, d[0] & ~TELEM_TICK_MISSED);
+        stamp = d[1] | ((unsigned int)d[2] << 8);
+        if(haveStamp)
+        {
+            // A second is 384000 Timer1 counts, only the low 16 bits make it: 56320 + the error
+            err = (int)(short)(unsigned short)(stamp - lastStamp - (TMR1_PER_SEC & 0xFFFF));
+            whole = (err >= 0 ? err + TMR1_PER_TMR0 / 2 : err - TMR1_PER_TMR0 / 2) / TMR1_PER_TMR0;
+            if(whole != 0)
+                trimmed++;
+            histAdd(&periodErr, abs(err));
+            histAdd(&jitter, abs(err - whole * TMR1_PER_TMR0));
+        }
+        lastStamp = stamp;
+        haveStamp = 1;
+        break;
+    case TELEM_SHIFT:
+        took = d[0] | ((unsigned int)d[1] << 8);
+        live = (d[2] & TELEM_SHIFT_LIVE) != 0;
+        histAdd(&shifts[live], took);
+        if(d[2] & TELEM_SHIFT_IRQS)
+        {
+            shiftsHit[live]++;
+            shiftIrqs[live] += d[2] & TELEM_SHIFT_IRQS;
+        }
+        break;
+    case TELEM_STREAM:
+        if(d[0] < 3)
+        {
+            histAdd(&streamFrames[d[0]], d[1]);
+            histAdd(&streamLongest[d[0]], d[2]);
+        }
+        break;
+    case TELEM_MODE:
+        modes++;
+        break;
+    case TELEM_ENCODER:
+        encoderDetents += abs((signed char)d[0]);
+        break;
+    case TELEM_NTP_SLEW:
+        v = s24(d);
+        histAdd(&ntpSlew, labs(v));
+        break;
+    case TELEM_NTP_STEP:
+        v = s24(d);
+        histAdd(&ntpStep, labs(v));
+        break;
+    case TELEM_SAVE:
+        histAdd(&saveStall, d[1] | ((unsigned int)d[2] << 8));
+        break;
+    case TELEM_RESTORE:
+        took = d[1] | ((unsigned int)d[2] << 8);
+        if(d[0] == PERSIST_NONE)
+            printf("power-up: nothing saved, %u Timer1 counts (%.0fus) after halInit()\n", took, took * TMR1_US);
+        else
+            printf("power-up: state from slot %u, %u Timer1 counts (%.0fus) after halInit()\n", d[0], took,
+                   took * TMR1_US);
+        break;
+    case TELEM_DROP:
+        drops += d[0];
+        haveStamp = 0;  // lost records could be ticks, the next period isn't one second
+        break;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    const char *path = 0;
+    int check = 0;
+    FILE *f;
+    unsigned char buf[TELEM_FRAME_BYTES];
+    int n = 0, c, i, fail;
+    unsigned char sum;
+
+    for(i=1; i<argc; i++)
+    {
+        if(!strcmp(argv[i], "--check"))
+            check = 1;
+        else if(!strcmp(argv[i], "--trace"))
+            trace = 1;
+        else if(path == 0)
+            path = argv[i];
+        else
+            path = 0, i = argc;
+    }
+    if(path == 0)
+    {
+        fprintf(stderr, "usage: %s [--check] [--trace] FILE (- = stdin)\n", argv[0]);
+        return 2;
+    }
+    f = strcmp(path, "-") ? fopen(path, "rb") : stdin;
+    if(!f)
+    {
+        perror(path);
+        return 2;
+    }
+
+    // Slide a 6 byte window along until it's a frame: start byte, known type, bytes after it sum to 0
+    while((c = getc(f)) != EOF)
+    {
+        buf[n++] = (unsigned char)c;
+        if(n < TELEM_FRAME_BYTES)
+            continue;
+        for(sum=0, i=1; i<TELEM_FRAME_BYTES; i++)
+            sum += buf[i];
+        if(buf[0] == TELEM_FRAME_START && buf[1] < TELEM_TYPES && sum == 0)
+        {
+            record(buf + 1);
+            n = 0;
+            continue;
+        }
+        badBytes++;
+        memmove(buf, buf + 1, --n);
+        haveStamp = 0;
+    }
+    badBytes += n;  // a frame cut off at the end
+
+    printf("records:");
+    for(i=0; i<TELEM_TYPES; i++)
+        printf(" %s %lu%s", typeName[i], records[i], (i < TELEM_TYPES - 1) ? "," : "\n");
+    printf("bytes that weren't a frame: %lu, records dropped by the clock (ring full): %lu\n", badBytes, drops);
+    printf("mode changes: %lu, encoder detents: %lu\n", modes, encoderDetents);
+
+    printf("seconds: %lu, not latched (no frame ready): %lu, trimmed (a Timer0 count longer/shorter): %lu\n",
+           records[TELEM_TICK], missed, trimmed);
+    histPrint("timer match -> RCK (firmware's view)", &tickLag, "TMR0 counts (333us)");
+    histPrint("RCK period error", &periodErr, "Timer1 counts (2.6us)");
+    histPrint("RCK period jitter (trim taken out)", &jitter, "Timer1 counts (2.6us)");
+
+    printf("pipeline frames: %lu, %lu of them interrupted by the button/encoder (%lu times)\n",
+           shifts[0].count, shiftsHit[0], shiftIrqs[0]);
+    histPrint("pipeline frame, start -> in", &shifts[0], "Timer1 counts (2.6us)");
+    printf("live frames: %lu, %lu of them interrupted by the button/encoder (%lu times)\n",
+           shifts[1].count, shiftsHit[1], shiftIrqs[1]);
+    histPrint("live frame, start -> latched", &shifts[1], "Timer1 counts (2.6us)");
+
+    histPrint("anti-poisoning bursts, frames each", &streamFrames[1], "frames");
+    histPrint("anti-poisoning bursts, longest frame", &streamLongest[1], "Timer1 counts (2.6us)");
+    histPrint("crossfades, frames each", &streamFrames[2], "frames");
+    histPrint("crossfades, longest frame", &streamLongest[2], "Timer1 counts (2.6us)");
+
+    if(records[TELEM_NTP_SLEW] || records[TELEM_NTP_STEP])
+    {
+        histPrint("NTP offset, slewed", &ntpSlew, "us");
+        histPrint("NTP offset, stepped", &ntpStep, "ms");
+    }
+    if(records[TELEM_SAVE])
+        histPrint("saves, CPU stalled", &saveStall, "Timer1 counts (2.6us)");
+    printf("(Timer1 count = %.2fus)\n", TMR1_US);
+
+    fail = check && ((badBytes != 0) || (drops != 0) || (missed != 0) || (records[TELEM_TICK] == 0));
+    if(check)
+        printf("%s\n", fail ? "FAIL" : "PASS");
+    return fail;
+}
@@ -0,0 +1,261 @@
+/*
+ * File:        sim/tz_check.c
+ * Compiler:    cc (Linux host)
+ *
+ * Info:    Checks the time zone engine (Nixie_tz.c + the generated Nixie_tz_table.h) against the
+ *          C library's zoneinfo, for the one zone it was built with (-DTZ_ZONE=..., the Makefile
+ *          builds one per zone).
+ *
+ *          tz_check            every check, exit 1 if anything didn't match
+ *              - the table is sorted and starts after TZ_EPOCH
+ *              - every transition in it is one the C library has, to the second, with the same offsets
+ *                either side, and the C library has none in TZ_FIRST_YEAR..TZ_LAST_YEAR the table misses
+ *              - the per-tick path (tzLocate() once, then utcSecs == tzNextAt / tzAdvance()) gives the
+ *                C library's local time for every second from an hour before to an hour after each one
+ *              - tzLocate() at random times all through the table
+ *              All with utcSecs as the firmware has it: 32-bit NTP seconds, wrapping in 2036.
+ *
+ *          tz_check --bench    ns per second of clock for the per-tick compare (a walk over all
+ *                              TZ_FIRST_YEAR..TZ_LAST_YEAR), tzLocate(), and localtime_r() for comparison
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "Nixie_config.h"
+#include "Nixie_hal.h"
+#include "Nixie_tz.h"
+#include "Nixie_tz_table.h"
+
+#define UNIX_TO_NTP     2208988800LL
+#define EPOCH_UNIX      ((long long)TZ_EPOCH - UNIX_TO_NTP)     // 2026-01-01 00:00 UTC
+#define SCAN_STEP       900                                     // every zone changes on a quarter hour
+
+static long long endUnix;       // 00:00 UTC on Jan 1st after TZ_LAST_YEAR
+static unsigned long failures;
+
+// What the firmware's utcSecs would be
+static uint32_t ntpSecs(long long unixSecs)
+{
+    return (uint32_t)(unixSecs + UNIX_TO_NTP);
+}
+
+static long libcOffset(long long unixSecs)
+{
+    time_t t = (time_t)unixSecs;
+    struct tm tm;
+
+    localtime_r(&t, &tm);
+    return tm.tm_gmtoff;
+}
+
+static long libcSecsOfDay(long long unixSecs)
+{
+    time_t t = (time_t)unixSecs;
+    struct tm tm;
+
+    localtime_r(&t, &tm);
+    return tm.tm_hour * 3600L + tm.tm_min * 60L + tm.tm_sec;
+}
+
+static void fail(const char *what, long long unixSecs, long want, long got)
+{
+    char buf[32];
+    time_t t = (time_t)unixSecs;
+    struct tm tm;
+
+    gmtime_r(&t, &tm);
+    strftime(buf, sizeof(buf), "%Y-%m-%d %H:%M:%S", &tm);
+    if(failures < 10)
+        printf("  FAIL %s at %s UTC: want %ld, got %ld\n", what, buf, want, got);
+    failures++;
+}
+
+static long tableOffset(int i)     // offset in force after entry i (i = -1: from TZ_EPOCH)
+{
+    return (i < 0) ? TZ_QUARTERS_START * 900L : tzQuarters[i] * 900L;
+}
+
+static void checkTable(void)
+{
+    long long t, lo, hi, mid;
+    long now, next;
+    int i = 0;
+
+    for(i=0; i<TZ_COUNT; i++)
+        if(tzAt[i] == 0 || (i > 0 && tzAt[i] <= tzAt[i - 1]) || (long long)tzAt[i] >= endUnix - EPOCH_UNIX)
+            fail("table order", EPOCH_UNIX + tzAt[i], i, 0);
+
+    if(libcOffset(EPOCH_UNIX) != tableOffset(-1))
+        fail("offset on TZ_EPOCH", EPOCH_UNIX, libcOffset(EPOCH_UNIX), tableOffset(-1));
+
+    // Walk the C library's zone a quarter hour at a time, every change has to be the next table entry
+    i = 0;
+    next = libcOffset(EPOCH_UNIX);
+    for(t=EPOCH_UNIX; t<endUnix; t+=SCAN_STEP)
+    {
+        now = next;
+        next = libcOffset(t + SCAN_STEP);
+        if(now == next)
+            continue;
+        lo = t;
+        hi = t + SCAN_STEP;     // the change is in (lo, hi]
+        while(hi - lo > 1)
+        {
+            mid = (lo + hi) / 2;
+            if(libcOffset(mid) == now)
+                lo = mid;
+            else
+                hi = mid;
+        }
+        if(i >= TZ_COUNT)
+        {
+            fail("transition missing from the table", hi, 0, 0);
+            continue;
+        }
+        if(EPOCH_UNIX + tzAt[i] != hi)
+            fail("transition time", hi, (long)(hi - EPOCH_UNIX), (long)tzAt[i]);
+        if(libcOffset(hi - 1) != tableOffset(i - 1))
+            fail("offset before", hi - 1, libcOffset(hi - 1), tableOffset(i - 1));
+        if(libcOffset(hi) != tableOffset(i))
+            fail("offset after", hi, libcOffset(hi), tableOffset(i));
+        i++;
+    }
+    if(i != TZ_COUNT)
+        fail("transitions in the C library vs the table", endUnix, i, TZ_COUNT);
+}
+
+// What onTick() does, second by second, from an hour before each transition to an hour after
+static void checkTicks(void)
+{
+    uint32_t utcSecs;
+    long long t;
+    int i;
+
+    for(i=0; i<TZ_COUNT; i++)
+    {
+        t = EPOCH_UNIX + tzAt[i] - 3600;
+        utcSecs = ntpSecs(t);
+        tzLocate(utcSecs);
+        if(tzIndex != i)
+            fail("tzLocate() index", t, i, tzIndex);
+
+        for(; t<=EPOCH_UNIX + tzAt[i] + 3600; t++)
+        {
+            if((long)tzSecsOfDay(utcSecs) != libcSecsOfDay(t))
+                fail("local time (per tick)", t, libcSecsOfDay(t), (long)tzSecsOfDay(utcSecs));
+            utcSecs++;
+            if(utcSecs == tzNextAt)
+                tzAdvance();
+        }
+    }
+
+    // Past the last transition nothing changes any more
+    tzLocate(ntpSecs(endUnix));
+    if(tzIndex != TZ_COUNT || tzNextAt != TZ_EPOCH - 1 || tzOffsetSecs != libcOffset(endUnix))
+        fail("past the end of the table", endUnix, libcOffset(endUnix), tzOffsetSecs);
+}
+
+static void checkRandom(unsigned long n)
+{
+    long long t;
+    unsigned long k;
+
+    srand(1);
+    for(k=0; k<n; k++)
+    {
+        t = EPOCH_UNIX + (long long)(((unsigned long long)rand() << 31 | (unsigned)rand()) % (unsigned long long)(endUnix - EPOCH_UNIX));
+        tzLocate(ntpSecs(t));
+        if((long)tzSecsOfDay(ntpSecs(t)) != libcSecsOfDay(t))
+            fail("local time (tzLocate)", t, libcSecsOfDay(t), (long)tzSecsOfDay(ntpSecs(t)));
+    }
+}
+
+static double nsNow(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static void bench(void)
+{
+    volatile unsigned long sink = 0;
+    uint32_t utcSecs;
+    unsigned long secs, k, n;
+    long long t;
+    double start, tick, locate, libc;
+    unsigned changes = 0;
+
+    // The whole table span, one second at a time, exactly as onTick() does it
+    utcSecs = ntpSecs(EPOCH_UNIX);
+    tzLocate(utcSecs);
+    secs = (unsigned long)(endUnix - EPOCH_UNIX);
+    start = nsNow();
+    for(k=0; k<secs; k++)
+    {
+        utcSecs++;
+        if(utcSecs == tzNextAt)
+        {
+            tzAdvance();
+            changes++;
+        }
+    }
+    tick = (nsNow() - start) / secs;
+    sink += utcSecs;
+
+    n = 2000000;
+    start = nsNow();
+    for(k=0; k<n; k++)
+    {
+        tzLocate(ntpSecs(EPOCH_UNIX + (long long)k * 787));
+        sink += tzSecsOfDay(ntpSecs(EPOCH_UNIX + (long long)k * 787));
+    }
+    locate = (nsNow() - start) / n;
+
+    start = nsNow();
+    for(k=0; k<n; k++)
+    {
+        t = EPOCH_UNIX + (long long)k * 787;
+        sink += libcSecsOfDay(t);
+    }
+    libc = (nsNow() - start) / n;
+
+    printf("  per tick (compare, %u transitions over %lu secs): %.2f ns\n", changes, secs, tick);
+    printf("  tzLocate() + tzSecsOfDay():                       %.1f ns\n", locate);
+    printf("  localtime_r():                                    %.1f ns\n", libc);
+    (void)sink;
+}
+
+int main(int argc, char **argv)
+{
+    struct tm tm;
+
+    setenv("TZ", TZ_ZONE_NAME, 1);
+    tzset();
+
+    memset(&tm, 0, sizeof(tm));
+    tm.tm_year = TZ_LAST_YEAR + 1 - 1900;
+    tm.tm_mday = 1;
+    endUnix = (long long)timegm(&tm);
+
+    printf("%s: %d transitions %d-%d, %d bytes of flash on a 32-bit target\n", TZ_ZONE_NAME, TZ_COUNT,
+           TZ_FIRST_YEAR, TZ_LAST_YEAR, (TZ_COUNT ? TZ_COUNT : 1) * 5);
+
+    if(argc > 1 && strcmp(argv[1], "--bench") == 0)
+    {
+        bench();
+        return 0;
+    }
+
+    checkTable();
+    checkTicks();
+    checkRandom(200000);
+
+    printf("  %s\n", failures ? "FAIL" : "PASS");
+    return failures ? 1 : 0;
+}
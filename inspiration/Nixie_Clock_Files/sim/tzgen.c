@@ -0,0 +1,157 @@
+/*
+ * File:        sim/tzgen.c
+ * Compiler:    cc (host only, build time)
+ *
+ * Info:    Time zone table generator for Nixie_tz.c.
+ *          Compiles the zone rules below into Nixie_tz_table.h: for every zone, a sorted list
+ *          of the UTC seconds (since TZ_EPOCH, 2026-01-01 00:00 UTC) at which its UTC offset
+ *          changes, and the offset from then on, for TZ_FIRST_YEAR to TZ_LAST_YEAR.
+ *          The firmware never sees a rule, only the finished transitions (kept in flash).
+ *
+ *          Rules are the current ones (no history needed, the table starts in 2026):
+ *              US  DST from the 2nd Sunday of March 02:00 local standard time
+ *                  to the 1st Sunday of November 02:00 local daylight time (since 2007)
+ *              EU  summer time from the last Sunday of March 01:00 UTC
+ *                  to the last Sunday of October 01:00 UTC (since 1996)
+ *          Adding a zone: one line in zones[], make tz-table, make tz-check.
+ *
+ *          tzgen > ../Nixie_tz_table.h   (make tz-table)
+ */
+
+#include <stdio.h>
+
+#define TZ_FIRST_YEAR   2026
+#define TZ_LAST_YEAR    2075
+
+#define RULE_NONE       0
+#define RULE_US         1
+#define RULE_EU         2
+
+typedef struct
+{
+    const char *macro;      // TZ_ZONE value in Nixie_config.h
+    const char *name;       // IANA name (what tz-check compares against)
+    int stdMins;            // standard time UTC offset, minutes
+    int rule;
+} zone_t;
+
+static const zone_t zones[] =
+{
+    { "TZ_UTC",         "UTC",                  0,      RULE_NONE },
+    { "TZ_US_EASTERN",  "America/New_York",     -300,   RULE_US },
+    { "TZ_US_CENTRAL",  "America/Chicago",      -360,   RULE_US },
+    { "TZ_US_MOUNTAIN", "America/Denver",       -420,   RULE_US },
+    { "TZ_US_ARIZONA",  "America/Phoenix",      -420,   RULE_NONE },
+    { "TZ_US_PACIFIC",  "America/Los_Angeles",  -480,   RULE_US },
+    { "TZ_US_ALASKA",   "America/Anchorage",    -540,   RULE_US },
+    { "TZ_US_HAWAII",   "Pacific/Honolulu",     -600,   RULE_NONE },
+    { "TZ_EU_WESTERN",  "Europe/London",        0,      RULE_EU },
+    { "TZ_EU_CENTRAL",  "Europe/Berlin",        60,     RULE_EU },
+    { "TZ_EU_EASTERN",  "Europe/Helsinki",      120,    RULE_EU },
+};
+
+#define ZONES   (sizeof(zones) / sizeof(zones[0]))
+
+// Days since 1970-01-01 of a date in the proleptic Gregorian calendar
+static long daysFromCivil(long y, int m, int d)
+{
+    long era, yoe, doy, doe;
+
+    y -= (m <= 2);
+    era = (y >= 0 ? y : y - 399) / 400;
+    yoe = y - era * 400;
+    doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+    doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + doe - 719468;
+}
+
+// 0 = Sunday
+static int weekday(long days)
+{
+    return (int)(((days % 7) + 11) % 7);
+}
+
+// Day (since 1970) of the n-th Sunday of a month, n = -1 for the last one
+static long sunday(long y, int m, int n)
+{
+    long first = daysFromCivil(y, m, 1);
+    long next = (m == 12) ? daysFromCivil(y + 1, 1, 1) : daysFromCivil(y, m + 1, 1);
+    long d;
+
+    if(n > 0)
+        return first + (7 - weekday(first)) % 7 + 7 * (n - 1);
+    d = next - 1;
+    return d - weekday(d);
+}
+
+int main(void)
+{
+    long epoch = daysFromCivil(2026, 1, 1) * 86400L;
+    unsigned z;
+    long y;
+
+    printf("/*\n"
+           " * File:        Nixie_tz_table.h\n"
+           " * Compiler:    generated by sim/tzgen.c (make -C sim tz-table), don't edit\n"
+           " *\n"
+           " * Info:    UTC offset transitions %d-%d for every zone tzgen knows, one zone gets\n"
+           " *          compiled in (TZ_ZONE, Nixie_config.h). Times are UTC seconds since TZ_EPOCH\n"
+           " *          (2026-01-01 00:00 UTC), offsets are in quarter hours.\n"
+           " */\n\n"
+           "#ifndef NIXIE_TZ_TABLE_H\n#define NIXIE_TZ_TABLE_H\n\n",
+           TZ_FIRST_YEAR, TZ_LAST_YEAR);
+    printf("#define TZ_FIRST_YEAR   %d\n#define TZ_LAST_YEAR    %d\n\n", TZ_FIRST_YEAR, TZ_LAST_YEAR);
+
+    for(z=0; z<ZONES; z++)
+        printf("#define %-16s%u\n", zones[z].macro, z);
+
+    for(z=0; z<ZONES; z++)
+    {
+        const zone_t *zn = &zones[z];
+        int std = zn->stdMins / 15;
+        int dst = (zn->stdMins + 60) / 15;
+        unsigned n = 0;
+
+        printf("\n%s TZ_ZONE == %s\n", z ? "#elif" : "#if", zn->macro);
+        printf("#define TZ_ZONE_NAME    \"%s\"\n", zn->name);
+        printf("#define TZ_QUARTERS_START %d\n", std);   // in force on TZ_EPOCH (winter everywhere here)
+
+        if(zn->rule == RULE_NONE)
+        {
+            printf("#define TZ_COUNT        0\n");
+            printf("static const uint32_t tzAt[1] HAL_FLASH = { 0 };\n");
+            printf("static const signed char tzQuarters[1] HAL_FLASH = { %d };\n", std);
+            continue;
+        }
+
+        printf("#define TZ_COUNT        %d\n", 2 * (TZ_LAST_YEAR - TZ_FIRST_YEAR + 1));
+        printf("static const uint32_t tzAt[TZ_COUNT] HAL_FLASH =\n{");
+        for(y=TZ_FIRST_YEAR; y<=TZ_LAST_YEAR; y++)
+        {
+            long on, off;
+
+            if(zn->rule == RULE_US)
+            {
+                on = sunday(y, 3, 2) * 86400L + 2 * 3600 - zn->stdMins * 60L;
+                off = sunday(y, 11, 1) * 86400L + 2 * 3600 - (zn->stdMins + 60) * 60L;
+            }
+            else
+            {
+                on = sunday(y, 3, -1) * 86400L + 3600;
+                off = sunday(y, 10, -1) * 86400L + 3600;
+            }
+            printf("%s%luUL, %luUL,", (n % 4) ? " " : "\n    ", (unsigned long)(on - epoch), (unsigned long)(off - epoch));
+            n += 2;
+        }
+        printf("\n};\n");
+
+        printf("static const signed char tzQuarters[TZ_COUNT] HAL_FLASH =\n{");
+        for(n=0; n<2u * (TZ_LAST_YEAR - TZ_FIRST_YEAR + 1); n++)
+            printf("%s%d,", (n % 16) ? " " : "\n    ", (n & 1) ? std : dst);
+        printf("\n};\n");
+    }
+
+    printf("\n#else\n#error \"TZ_ZONE: not a zone in Nixie_tz_table.h (add it to sim/tzgen.c)\"\n#endif\n");
+    printf("\n#endif // NIXIE_TZ_TABLE_H\n");
+    return 0;
+}
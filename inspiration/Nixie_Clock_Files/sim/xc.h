@@ -0,0 +1,126 @@
+/*
+ * File:        sim/xc.h
+ * Compiler:    g++ (host simulator only, the real one comes with XC8)
+ *
+ * Info:    Stand-in for the XC8 device header so the firmware sources build
+ *          unmodified (as C++) into the host simulator, see nixie_sim.h.
+ *
+ *          Every SFR the firmware touches is a tiny proxy object: reads and
+ *          writes go through simRead()/simWrite(), which is where the peripheral
+ *          models live. Each access costs 1 Tcy of simulated time (it's roughly
+ *          a MOVF/MOVWF/BSF/BCF on the real part).
+ *          Only the registers and bits the firmware actually uses are here,
+ *          add them as the firmware grows.
+ */
+
+#ifndef NIXIE_SIM_XC_H
+#define NIXIE_SIM_XC_H
+
+// Every SFR, one id each
+#define SIM_SFR_LIST(X) \
+    X(ANSELA) X(ANSELC) X(TRISA) X(TRISC) X(PORTA) X(PORTC) X(LATC) \
+    X(RC0PPS) X(RC1PPS) X(RC5PPS) X(RA0PPS) \
+    X(INTCON) X(PIE0) X(PIR0) X(PIE3) X(PIR3) X(PIE4) X(PIR4) \
+    X(IOCCP) X(IOCCN) X(IOCCF) \
+    X(T0CON0) X(T0CON1) X(TMR0H) X(TMR0L) \
+    X(T1CON) X(T1CLK) X(TMR1H) X(TMR1L) \
+    X(T2CON) X(T2CLKCON) X(T2PR) X(T2TMR) \
+    X(CCPTMRS1) X(PWM3CON) X(PWM3DCH) X(PWM3DCL) \
+    X(ADCON0) X(ADCON1) X(ADRESH) X(ADRESL) \
+    X(SSP1CON1) X(SSP1STAT) X(SSP1BUF) X(SSP1ADD) \
+    X(TX1STA) X(RC1STA) X(BAUD1CON) X(SP1BRGL) X(SP1BRGH) X(TX1REG) \
+    X(NVMADRL) X(NVMADRH) X(NVMDATL) X(NVMDATH) X(NVMCON1) X(NVMCON2) \
+    X(CPUDOZE)
+
+enum
+{
+#define SIM_SFR_ID(n) SFR_##n,
+    SIM_SFR_LIST(SIM_SFR_ID)
+#undef SIM_SFR_ID
+    SFR_COUNT
+};
+
+unsigned char simRead(int sfr);                  // costs 1 Tcy, runs the read side effects
+void simWrite(int sfr, unsigned char value);     // costs 1 Tcy, runs the write side effects
+void simBitWrite(int sfr, unsigned char mask, unsigned char bits); // BSF/BCF, 1 Tcy
+void simNop(void);                               // 1 Tcy
+void simSleep(void);                             // SLEEP (IDLE), skips ahead to the next interrupt
+
+// Whole register
+template <int SFR> struct SimSfr
+{
+    operator unsigned char() const              { return simRead(SFR); }
+    SimSfr &operator=(unsigned int v)           { simWrite(SFR, (unsigned char)v); return *this; }
+    SimSfr &operator|=(unsigned int v)          { simWrite(SFR, (unsigned char)(simRead(SFR) | v)); return *this; }
+    SimSfr &operator&=(unsigned int v)          { simWrite(SFR, (unsigned char)(simRead(SFR) & v)); return *this; }
+    SimSfr &operator^=(unsigned int v)          { simWrite(SFR, (unsigned char)(simRead(SFR) ^ v)); return *this; }
+    SimSfr &operator+=(unsigned int v)          { simWrite(SFR, (unsigned char)(simRead(SFR) + v)); return *this; }
+    SimSfr &operator-=(unsigned int v)          { simWrite(SFR, (unsigned char)(simRead(SFR) - v)); return *this; }
+    SimSfr &operator++()                        { return *this += 1; }
+    SimSfr &operator--()                        { return *this -= 1; }
+};
+
+// One bit (or a few) of a register, like the XC8 xxxbits structs
+template <int SFR, int POS, int WIDTH = 1> struct SimBits
+{
+    enum { MASK = ((1 << WIDTH) - 1) << POS };
+    operator unsigned char() const              { return (unsigned char)((simRead(SFR) & MASK) >> POS); }
+    SimBits &operator=(unsigned int v)          { simBitWrite(SFR, MASK, (unsigned char)((v << POS) & MASK)); return *this; }
+};
+
+#define SIM_SFR_DECL(n) extern SimSfr<SFR_##n> n;
+SIM_SFR_LIST(SIM_SFR_DECL)
+#undef SIM_SFR_DECL
+
+union PORTCbits_t   { SimBits<SFR_PORTC,0> RC0; SimBits<SFR_PORTC,1> RC1; SimBits<SFR_PORTC,2> RC2;
+                      SimBits<SFR_PORTC,3> RC3; SimBits<SFR_PORTC,4> RC4; SimBits<SFR_PORTC,5> RC5; };
+union LATCbits_t    { SimBits<SFR_LATC,0> LATC0; SimBits<SFR_LATC,1> LATC1; SimBits<SFR_LATC,2> LATC2;
+                      SimBits<SFR_LATC,3> LATC3; SimBits<SFR_LATC,4> LATC4; SimBits<SFR_LATC,5> LATC5; };
+union INTCONbits_t  { SimBits<SFR_INTCON,0> INTEDG; SimBits<SFR_INTCON,6> PEIE; SimBits<SFR_INTCON,7> GIE; };
+union PIE0bits_t    { SimBits<SFR_PIE0,0> INTE; SimBits<SFR_PIE0,4> IOCIE; SimBits<SFR_PIE0,5> TMR0IE; };
+union PIR0bits_t    { SimBits<SFR_PIR0,0> INTF; SimBits<SFR_PIR0,4> IOCIF; SimBits<SFR_PIR0,5> TMR0IF; };
+union PIE3bits_t    { SimBits<SFR_PIE3,0> SSP1IE; SimBits<SFR_PIE3,1> BCL1IE; SimBits<SFR_PIE3,4> TX1IE; SimBits<SFR_PIE3,5> RC1IE; };
+union PIR3bits_t    { SimBits<SFR_PIR3,0> SSP1IF; SimBits<SFR_PIR3,1> BCL1IF; SimBits<SFR_PIR3,4> TX1IF; SimBits<SFR_PIR3,5> RC1IF; };
+union PIE4bits_t    { SimBits<SFR_PIE4,0> TMR1IE; SimBits<SFR_PIE4,1> TMR2IE; };
+union PIR4bits_t    { SimBits<SFR_PIR4,0> TMR1IF; SimBits<SFR_PIR4,1> TMR2IF; };
+union T0CON0bits_t  { SimBits<SFR_T0CON0,0> T0OUTPS0; SimBits<SFR_T0CON0,1> T0OUTPS1; SimBits<SFR_T0CON0,2> T0OUTPS2;
+                      SimBits<SFR_T0CON0,3> T0OUTPS3; SimBits<SFR_T0CON0,4> T016BIT; SimBits<SFR_T0CON0,5> T0OUT;
+                      SimBits<SFR_T0CON0,7> T0EN; };
+union T0CON1bits_t  { SimBits<SFR_T0CON1,0> T0CKPS0; SimBits<SFR_T0CON1,1> T0CKPS1; SimBits<SFR_T0CON1,2> T0CKPS2;
+                      SimBits<SFR_T0CON1,3> T0CKPS3; SimBits<SFR_T0CON1,4> T0ASYNC; SimBits<SFR_T0CON1,5> T0CS0;
+                      SimBits<SFR_T0CON1,6> T0CS1; SimBits<SFR_T0CON1,7> T0CS2; };
+union SSP1CON1bits_t { SimBits<SFR_SSP1CON1,0> SSPM0; SimBits<SFR_SSP1CON1,1> SSPM1; SimBits<SFR_SSP1CON1,2> SSPM2;
+                      SimBits<SFR_SSP1CON1,3> SSPM3; SimBits<SFR_SSP1CON1,4> CKP; SimBits<SFR_SSP1CON1,5> SSPEN;
+                      SimBits<SFR_SSP1CON1,6> SSPOV; SimBits<SFR_SSP1CON1,7> WCOL; };
+union SSP1STATbits_t { SimBits<SFR_SSP1STAT,0> BF; SimBits<SFR_SSP1STAT,6> CKE; SimBits<SFR_SSP1STAT,7> SMP; };
+union CPUDOZEbits_t { SimBits<SFR_CPUDOZE,7> IDLEN; };
+union ADCON0bits_t  { SimBits<SFR_ADCON0,0> ADON; SimBits<SFR_ADCON0,1> GO; };
+union NVMCON1bits_t { SimBits<SFR_NVMCON1,0> RD; SimBits<SFR_NVMCON1,1> WR; SimBits<SFR_NVMCON1,2> WREN;
+                      SimBits<SFR_NVMCON1,3> WRERR; SimBits<SFR_NVMCON1,4> FREE; SimBits<SFR_NVMCON1,5> LWLO;
+                      SimBits<SFR_NVMCON1,6> NVMREGS; };
+
+extern PORTCbits_t PORTCbits;
+extern LATCbits_t LATCbits;
+extern INTCONbits_t INTCONbits;
+extern PIE0bits_t PIE0bits;
+extern PIR0bits_t PIR0bits;
+extern PIE3bits_t PIE3bits;
+extern PIR3bits_t PIR3bits;
+extern PIE4bits_t PIE4bits;
+extern PIR4bits_t PIR4bits;
+extern T0CON0bits_t T0CON0bits;
+extern T0CON1bits_t T0CON1bits;
+extern SSP1CON1bits_t SSP1CON1bits;
+extern SSP1STATbits_t SSP1STATbits;
+extern CPUDOZEbits_t CPUDOZEbits;
+extern ADCON0bits_t ADCON0bits;
+extern NVMCON1bits_t NVMCON1bits;
+
+#define interrupt                   // ISR_High() is a plain function, the simulator calls it
+#define NOP()           simNop()
+#define SLEEP()         simSleep()
+#define CLRWDT()        simNop()
+#define di()            (INTCONbits.GIE = 0)
+#define ei()            (INTCONbits.GIE = 1)
+
+#endif // NIXIE_SIM_XC_H